@@ -19,6 +19,8 @@
 #include <netp/bytes_helper.hpp>
 #include <netp/ringbuffer.hpp>
 #include <netp/packet.hpp>
+#include <netp/recycler.hpp>
+#include <netp/chained_packet.hpp>
 #include <netp/bytes_ringbuffer.hpp>
 #include <netp/heap.hpp>
 
@@ -47,6 +49,7 @@
 
 #include <netp/address.hpp>
 #include <netp/socket.hpp>
+#include <netp/connection_pool.hpp>
 #include <netp/icmp.hpp>
 
 #include <netp/handler/hlen.hpp>
@@ -75,6 +78,7 @@
 #include <netp/http/client.hpp>
 
 #include <netp/rpc.hpp>
+#include <netp/coroutine.hpp>
 
 #include <netp/signal_broker.hpp>
 #include <netp/app.hpp>
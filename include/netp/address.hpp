@@ -7,6 +7,7 @@
 #include <netp/ipv4.hpp>
 #include <netp/ipv6.hpp>
 #include <netp/string.hpp>
+#include <netp/smart_ptr.hpp>
 
 #define NETP_PF_INET 		PF_INET
 #define NETP_AF_INET		AF_INET
@@ -51,22 +52,74 @@ namespace netp {
 
 	const ipv4_t IP_LOOPBACK = 2130706433U;
 
+	//sun_path max len, abstract namespace names take a leading '\0'
+#ifdef _NETP_WIN
+	#define NETP_UNIX_PATH_MAX 0
+#else
+	#define NETP_UNIX_PATH_MAX (sizeof(((sockaddr_un*)0)->sun_path))
+#endif
+
+	//NETP_AF_UNIX only, immutable once built, shared by the copies of the address
+	struct address_unix_path final :
+		public netp::ref_base
+	{
+		string_t path; //abstract namespace if path[0] == '\0'
+		address_unix_path(const char* p, netp::size_t len) :
+			path(p, len)
+		{}
+	};
+
 	struct address final {
 		ipv4_t m_ipv4;
 		port_t m_port;
 		u8_t m_family;
+		ipv6_t m_ipv6; //NETP_AF_INET6 only
+		u32_t m_scope_id; //NETP_AF_INET6 only
+		NRP<address_unix_path> m_unix; //NETP_AF_UNIX only, nullptr for the unnamed address
 
 		address();
+		//ipv6 if f == NETP_AF_INET6, or f == NETP_AF_UNSPEC and ip is a ipv6 notation
 		address(const char* ip, unsigned short port, int f = NETP_AF_UNSPEC);
+		address(ipv6_t const& ip, port_t port, u32_t scope_id = 0);
 		address( sockaddr_in const& sockaddr_in_ ) ;
+		address( sockaddr const* sa, socklen_t len );
 
 		~address();
 
-		inline bool is_null() const {return 0 == m_ipv4 && 0 == m_port ;}
+		//unix://path, a leading '@' maps to the abstract namespace
+		static address from_unix_path(const char* path, netp::size_t len);
+
+		//return socklen, 0 for unsupported family
+		socklen_t to_sockaddr(sockaddr_storage& ss) const;
+
+		inline bool is_null() const {
+			return m_family == NETP_AF_UNIX ? m_unix == nullptr :
+				m_family == NETP_AF_INET6 ? (ipv6_is_zero(m_ipv6) && 0 == m_port) :
+				(0 == m_ipv4 && 0 == m_port) ;
+		}
+		inline bool is_unix_abstract() const { return m_family == NETP_AF_UNIX && m_unix != nullptr && m_unix->path[0] == '\0'; }
+		//empty for the unnamed address
+		string_t const& unix_path() const;
 		inline u64_t hash() const {
+			if (m_family == NETP_AF_UNIX) {
+				//FNV-1a
+				u64_t h = 14695981039346656037ULL;
+				string_t const& path = unix_path();
+				for (netp::size_t i = 0; i < path.length(); ++i) {
+					h = (h ^ u8_t(path[i])) * 1099511628211ULL;
+				}
+				return (h << 8) | u64_t(m_family);
+			} else if (m_family == NETP_AF_INET6) {
+				return ((m_ipv6.u64[0] * 31 + m_ipv6.u64[1]) << 24) ^ (u64_t(m_port) << 8 | u64_t(m_family));
+			}
 			return (u64_t(m_ipv4) << 24 | u64_t(m_port) << 8 | u64_t(m_family));
 		}
 		inline bool operator == ( address const& addr ) const {
+			if (m_family == NETP_AF_UNIX || addr.m_family == NETP_AF_UNIX) {
+				return m_family == addr.m_family && (m_unix == addr.m_unix || unix_path() == addr.unix_path());
+			} else if (m_family == NETP_AF_INET6 || addr.m_family == NETP_AF_INET6) {
+				return m_family == addr.m_family && m_port == addr.m_port && m_ipv6 == addr.m_ipv6;
+			}
 			return hash() == addr.hash();
 		}
 
@@ -85,8 +138,16 @@ namespace netp {
 			return u16_t(m_family);
 		}
 
+		//ipv4 dot notation, or ipv6 text notation for NETP_AF_INET6
 		const string_t dotip() const ;
 
+		inline ipv6_t const& ipv6() const {
+			return m_ipv6;
+		}
+		inline u32_t scope_id() const {
+			return m_scope_id;
+		}
+
 		inline ipv4_t ipv4() const {
 			return m_ipv4;
 		}
@@ -140,6 +201,9 @@ namespace netp {
 	extern ipv4_t hosttoip(const char* hostname);
 
 	extern bool is_dotipv4_decimal_notation(const char* string);
+	extern bool is_ipv6_notation(const char* string);
+	extern string_t ipv6tostr(ipv6_t const& ip);
+	extern ipv6_t strtoipv6(const char* str);
 
 	inline ipv4_t ipv4tonipv4(ipv4_t const& ip) { return ::htonl(ip); }
 	inline ipv4_t nipv4toipv4(ipv4_t const& ip) { return ::ntohl(ip); }
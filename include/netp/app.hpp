@@ -8,6 +8,7 @@
 namespace netp {
 
 	typedef std::function<void()> fn_app_hook_t;
+	typedef std::function<void(pool_align_allocator_stats const&)> fn_allocator_stats_hook_t;
 
 	struct app_cfg {
 
@@ -26,6 +27,11 @@ namespace netp {
 		fn_app_hook_t app_event_loop_deinit_prev;
 		fn_app_hook_t app_event_loop_deinit_post;
 
+		u32_t allocator_stats_interval; //in milliseconds, 0 to disable
+		fn_allocator_stats_hook_t allocator_stats_hook; //called on a loop with pool_align_allocator::stats_all, pool_align_allocator::stats_dump if not set
+		u32_t allocator_decay_interval; //in milliseconds, every loop decays its allocator cache on this interval, 0 to disable
+		u32_t allocator_entries_limit[TABLE::T_COUNT]; //blocks cached per slot of each table, 0 for the default
+
 	public:
 		app_cfg() :
 			logfilepathname(""),
@@ -37,8 +43,14 @@ namespace netp {
 			app_event_loop_init_prev(nullptr),
 			app_event_loop_init_post(nullptr),
 			app_event_loop_deinit_prev(nullptr),
-			app_event_loop_deinit_post(nullptr)
+			app_event_loop_deinit_post(nullptr),
+			allocator_stats_interval(0),
+			allocator_stats_hook(nullptr),
+			allocator_decay_interval(0)
 		{
+			for (size_t t = 0; t < TABLE::T_COUNT; ++t) {
+				allocator_entries_limit[t] = 0;
+			}
 			const int corecount = std::thread::hardware_concurrency();
 			for (size_t i = 0; i < T_POLLER_MAX; ++i) {
 				if (i == NETP_DEFAULT_POLLER_TYPE) {
@@ -54,6 +66,9 @@ namespace netp {
 
 				poller_cfgs[i].ch_buf_size = (128*1024);
 				poller_cfgs[i].maxiumctx = (0);
+				poller_cfgs[i].packet_pool_bytes = NETP_PACKET_POOL_DEFAULT_BYTES;
+				poller_cfgs[i].packet_arena_bytes = 0;
+				poller_cfgs[i].recycle_objects = NETP_RECYCLER_DEFAULT_OBJECTS;
 			}
 		}
 
@@ -78,6 +93,20 @@ namespace netp {
 		void cfg_log_filepathname(std::string const& logfilepathname_) {
 			logfilepathname = logfilepathname_;
 		}
+
+		void cfg_allocator_stats(u32_t interval, fn_allocator_stats_hook_t const& hook = nullptr) {
+			allocator_stats_interval = interval;
+			allocator_stats_hook = hook;
+		}
+
+		void cfg_allocator_decay(u32_t interval) {
+			allocator_decay_interval = interval;
+		}
+
+		void cfg_allocator_entries_limit(u8_t t, u32_t limit) {
+			NETP_ASSERT(t < TABLE::T_COUNT);
+			allocator_entries_limit[t] = limit;
+		}
 	};
 
 	class app {
@@ -130,6 +159,9 @@ namespace netp {
 		void ___event_loop_init();
 		void ___event_loop_deinit();
 
+		void __allocator_cfg_init();
+		void __allocator_stats_init();
+
 		//ISSUE: if the waken thread is main thread, we would get stuck here
 		void handle_signal(int signo);
 		bool should_exit() const;
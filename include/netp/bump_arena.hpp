@@ -0,0 +1,289 @@
+#ifndef _NETP_BUMP_ARENA_HPP_
+#define _NETP_BUMP_ARENA_HPP_
+
+#include <atomic>
+
+#include <netp/core.hpp>
+#include <netp/smart_ptr.hpp>
+
+#define NETP_BUMP_ARENA_CHUNK_SIZE (4096)
+//ref objects allocated in an arena keep it alive by a ref in front of them
+#define NETP_BUMP_ARENA_OBJECT_HEADER (NETP_DEFAULT_ALIGN)
+//container blocks of arena_allocator are tagged with the arena they are in, nullptr for netp::allocator
+#define NETP_BUMP_ARENA_BLOCK_HEADER (NETP_DEFAULT_ALIGN)
+
+namespace netp {
+
+	/*
+	 * a bump allocator for memory that dies together, the messages and headers of a request for example
+	 * 1, allocate bumps a pointer in the current chunk, a new chunk is linked in if it does not fit, deallocate only counts the block down
+	 * 2, once every block is back, the next allocate rewinds to the first chunk in O(1), chunks over the first one are released if the arena grew over max_bytes
+	 * 3, try_allocate does not grow the arena over max_bytes, callers fall back to netp::allocator, so a block that is never released costs at most max_bytes
+	 * 4, it is allocated in a scope on one thread only, a block can be released on any thread, m_live is the only state they share
+	 * 5, the owner calls renew at the start of each request scope, an arena that is full and still held by earlier requests is left to them
+	 */
+	class bump_arena final :
+		public netp::ref_base
+	{
+		struct chunk {
+			chunk* next;
+			netp::size_t size; //bytes after the chunk head
+			byte_t* data() { return ((byte_t*)this) + sizeof(chunk); }
+		};
+		static_assert((sizeof(chunk) % NETP_DEFAULT_ALIGN) == 0, "chunk head must keep the default alignment");
+
+		chunk* m_head;
+		chunk* m_cur;
+		byte_t* m_ptr;
+		byte_t* m_end;
+		netp::size_t m_chunk_size;
+		netp::size_t m_max_bytes;
+		netp::size_t m_capacity;
+		std::atomic<netp::size_t> m_live; //blocks not released yet
+		u64_t m_rewinds;
+
+		NETP_DECLARE_NONCOPYABLE(bump_arena)
+
+		typedef NRP<bump_arena> arena_ref_t;
+
+		void _rewind() {
+			if (m_head == nullptr) {
+				return;
+			}
+			if (m_capacity > m_max_bytes) {
+				chunk* c = m_head->next;
+				while (c != nullptr) {
+					chunk* next = c->next;
+					m_capacity -= c->size;
+					netp::allocator<byte_t>::free((byte_t*)c);
+					c = next;
+				}
+				m_head->next = nullptr;
+			}
+			m_cur = m_head;
+			m_ptr = m_head->data();
+			m_end = m_ptr + m_head->size;
+			++m_rewinds;
+		}
+
+		//n is rounded up to the alignment already
+		bool _next_chunk(netp::size_t n, bool grow) {
+			if (m_cur != nullptr && m_cur->next != nullptr && m_cur->next->size >= n) {
+				m_cur = m_cur->next;
+			} else {
+				const netp::size_t size = n > m_chunk_size ? n : m_chunk_size;
+				if (!grow && (m_capacity + size) > m_max_bytes) {
+					return false;
+				}
+				chunk* c = (chunk*)netp::allocator<byte_t>::malloc(sizeof(chunk) + size);
+				if (c == nullptr) {
+					return false;
+				}
+				c->size = size;
+				if (m_cur == nullptr) {
+					c->next = nullptr;
+					m_head = c;
+				} else {
+					//an undersized chunk is skipped, it is reused after the next rewind
+					c->next = m_cur->next;
+					m_cur->next = c;
+				}
+				m_cur = c;
+				m_capacity += size;
+			}
+			m_ptr = m_cur->data();
+			m_end = m_ptr + m_cur->size;
+			return true;
+		}
+
+		void* _allocate(netp::size_t n, bool grow) {
+			n = (n + NETP_DEFAULT_ALIGN - 1) & ~netp::size_t(NETP_DEFAULT_ALIGN - 1);
+			//pairs with the release of the last deallocate, the blocks are not touched any more once we rewind
+			if (m_live.load(std::memory_order_acquire) == 0) {
+				_rewind();
+			}
+			if ((m_ptr + n) > m_end && !_next_chunk(n, grow)) {
+				return nullptr;
+			}
+			byte_t* p = m_ptr;
+			m_ptr += n;
+			m_live.fetch_add(1, std::memory_order_relaxed);
+			return p;
+		}
+
+	public:
+		explicit bump_arena(netp::size_t max_bytes, netp::size_t chunk_size = NETP_BUMP_ARENA_CHUNK_SIZE) :
+			m_head(nullptr),
+			m_cur(nullptr),
+			m_ptr(nullptr),
+			m_end(nullptr),
+			m_chunk_size(chunk_size),
+			m_max_bytes(max_bytes),
+			m_capacity(0),
+			m_live(0),
+			m_rewinds(0)
+		{}
+
+		~bump_arena() {
+			NETP_ASSERT(live() == 0, "live: %zu", live());
+			chunk* c = m_head;
+			while (c != nullptr) {
+				chunk* next = c->next;
+				netp::allocator<byte_t>::free((byte_t*)c);
+				c = next;
+			}
+		}
+
+		//aligned to NETP_DEFAULT_ALIGN
+		inline void* allocate(netp::size_t n) { return _allocate(n, true); }
+		//nullptr if the arena has to grow over max_bytes
+		inline void* try_allocate(netp::size_t n) { return _allocate(n, false); }
+
+		inline void deallocate(void* p) {
+			(void)p;
+			const netp::size_t live_ = m_live.fetch_sub(1, std::memory_order_release);
+			NETP_ASSERT(live_ > 0);
+			(void)live_;
+		}
+
+		//no room for another chunk and still in use, it does not rewind before the blocks are back
+		inline bool exhausted() const { return (m_capacity + m_chunk_size) > m_max_bytes && (live() != 0); }
+
+		//every block must be back
+		void reset() {
+			NETP_ASSERT(live() == 0, "live: %zu", live());
+			_rewind();
+		}
+
+		//the arena for the next request scope: a, or a new one of the same size if a is exhausted, the old one goes with its last block
+		inline static NRP<bump_arena> renew(NRP<bump_arena> const& a) {
+			if (a == nullptr || !a->exhausted()) {
+				return a;
+			}
+			return netp::make_ref<bump_arena>(a->m_max_bytes, a->m_chunk_size);
+		}
+
+		inline netp::size_t live() const { return m_live.load(std::memory_order_acquire); }
+		inline netp::size_t capacity() const { return m_capacity; }
+		inline u64_t rewinds() const { return m_rewinds; }
+
+		static bump_arena*& current() {
+			static __NETP_TLS bump_arena* _current = nullptr;
+			return _current;
+		}
+
+		//ref objects with operator new/delete of object_malloc/object_free are allocated in the arena while a scope is alive
+		class scope final {
+			bump_arena* m_prev;
+			NETP_DECLARE_NONCOPYABLE(scope)
+		public:
+			explicit scope(NRP<bump_arena> const& a) :
+				m_prev(current())
+			{
+				current() = a.get();
+			}
+			~scope() {
+				current() = m_prev;
+			}
+		};
+
+		//[NRP<bump_arena>][object], the ref is nullptr if the object is not in an arena
+		inline static void* object_malloc(std::size_t size) {
+			bump_arena* a = current();
+			byte_t* p = nullptr;
+			if (a != nullptr) {
+				p = (byte_t*)a->try_allocate(NETP_BUMP_ARENA_OBJECT_HEADER + size);
+			}
+			if (p != nullptr) {
+				new (p) arena_ref_t(a);
+			} else {
+				p = (byte_t*)netp::allocator<byte_t>::malloc(NETP_BUMP_ARENA_OBJECT_HEADER + size);
+				if (p == nullptr) {
+					return nullptr;
+				}
+				new (p) arena_ref_t();
+			}
+			return p + NETP_BUMP_ARENA_OBJECT_HEADER;
+		}
+
+		inline static void object_free(void* p) {
+			if (p == nullptr) {
+				return;
+			}
+			byte_t* h = ((byte_t*)p) - NETP_BUMP_ARENA_OBJECT_HEADER;
+			arena_ref_t a(std::move(*((arena_ref_t*)h)));
+			((arena_ref_t*)h)->~arena_ref_t();
+			if (a != nullptr) {
+				a->deallocate(h);
+			} else {
+				netp::allocator<byte_t>::free(h);
+			}
+		}
+	};
+
+	/*
+	 * stateful, falls back to netp::allocator without an arena
+	 * 1, the arena is used in its scope only, the container might be changed later on another thread, those blocks go to netp::allocator
+	 * 2, a block that does not fit in max_bytes goes to netp::allocator too, each block is tagged with where it is from
+	 */
+	template <class T>
+	struct arena_allocator {
+		typedef T value_type;
+		typedef T* pointer;
+		typedef const T* const_pointer;
+		typedef T& reference;
+		typedef const T& const_reference;
+		typedef std::size_t size_type;
+		typedef std::ptrdiff_t difference_type;
+
+		template <class U>
+		struct rebind {
+			typedef arena_allocator<U> other;
+		};
+
+		bump_arena* arena;
+
+		arena_allocator() _NETP_NOEXCEPT : arena(nullptr) {}
+		explicit arena_allocator(bump_arena* a) _NETP_NOEXCEPT : arena(a) {}
+		template <class U>
+		arena_allocator(arena_allocator<U> const& other) _NETP_NOEXCEPT : arena(other.arena) {}
+
+		inline pointer allocate(size_type n) {
+			NETP_ASSERT(alignof(T) <= NETP_DEFAULT_ALIGN);
+			if (arena == nullptr) {
+				pointer p = netp::allocator<T>::malloc(n);
+				NETP_ALLOC_CHECK(p, sizeof(T) * n);
+				return p;
+			}
+			const netp::size_t size = NETP_BUMP_ARENA_BLOCK_HEADER + sizeof(T) * n;
+			bump_arena* from = nullptr;
+			byte_t* b = nullptr;
+			if (bump_arena::current() == arena) {
+				b = (byte_t*)arena->try_allocate(size);
+				from = arena;
+			}
+			if (b == nullptr) {
+				b = netp::allocator<byte_t>::malloc(size);
+				NETP_ALLOC_CHECK(b, size);
+				from = nullptr;
+			}
+			*((bump_arena**)b) = from;
+			return (pointer)(b + NETP_BUMP_ARENA_BLOCK_HEADER);
+		}
+		inline void deallocate(pointer p, size_type) {
+			if (arena == nullptr) {
+				netp::allocator<T>::free(p);
+				return;
+			}
+			byte_t* b = ((byte_t*)p) - NETP_BUMP_ARENA_BLOCK_HEADER;
+			bump_arena* from = *((bump_arena**)b);
+			from != nullptr ? from->deallocate(b) : netp::allocator<byte_t>::free(b);
+		}
+	};
+
+	template <class T, class U>
+	inline bool operator == (arena_allocator<T> const& l, arena_allocator<U> const& r) { return l.arena == r.arena; }
+	template <class T, class U>
+	inline bool operator != (arena_allocator<T> const& l, arena_allocator<U> const& r) { return l.arena != r.arena; }
+}
+#endif
@@ -0,0 +1,296 @@
+#ifndef _NETP_CHAINED_PACKET_HPP_
+#define _NETP_CHAINED_PACKET_HPP_
+
+#include <deque>
+
+#include <netp/core.hpp>
+#include <netp/smart_ptr.hpp>
+#include <netp/bytes_helper.hpp>
+#include <netp/packet.hpp>
+#include <netp/socket_api.hpp>
+
+namespace netp {
+
+	//[ptr, ptr+len) of pkt
+	struct chained_packet_segment {
+		NRP<packet> pkt;
+		byte_t* ptr;
+		netp::size_t len;
+	};
+
+	/*
+	 * a list of refcounted packet segments, for payloads that are built or split piece by piece
+	 * 1, append/prepend of a packet or another chain links its bytes in, no copy
+	 * 2, write/write_left copy into the tail/head segment if the chain is its only owner and it has room, otherwise link a new packet
+	 * 3, slice shares the segments, the packets linked in must not be modified by anyone else afterwards
+	 * 4, read/peek/skip works across segments, to_iov exports the segments for a gather write, to_packet for code that needs contiguous bytes
+	 * 5, channel::ch_write(chain) hands the segments to the transport in one gather write if no handler encodes writes, see channel::ch_write
+	 */
+	class chained_packet final :
+		public netp::ref_base
+	{
+		typedef std::deque<chained_packet_segment, netp::allocator<chained_packet_segment>> segments_t;
+		segments_t m_segments;
+		netp::size_t m_len;
+
+		byte_t* _tail_reserve(netp::size_t n) {
+			if (m_segments.size()) {
+				chained_packet_segment& s = m_segments.back();
+				if (s.pkt.ref_count() == 1 && (s.ptr + s.len) == s.pkt->tail() && s.pkt->left_right_capacity() >= n) {
+					byte_t* p = s.pkt->tail();
+					s.pkt->incre_write_idx(n);
+					s.len += n;
+					m_len += n;
+					return p;
+				}
+			}
+			NRP<packet> pkt = netp::make_ref<packet>(n > (PACK_DEFAULT_CAPACITY - PACK_MIN_LEFT_CAPACITY) ? n : (PACK_DEFAULT_CAPACITY - PACK_MIN_LEFT_CAPACITY));
+			pkt->incre_write_idx(n);
+			m_segments.push_back({ pkt, pkt->head(), n });
+			m_len += n;
+			return pkt->head();
+		}
+
+		byte_t* _head_reserve(netp::size_t n) {
+			if (m_segments.size()) {
+				chained_packet_segment& s = m_segments.front();
+				if (s.pkt.ref_count() == 1 && !s.pkt->is_shared() && s.ptr == s.pkt->head() && s.pkt->left_left_capacity() >= n) {
+					s.pkt->decre_read_idx(n);
+					s.ptr -= n;
+					s.len += n;
+					m_len += n;
+					return s.ptr;
+				}
+			}
+			//keep some headroom for the next header
+			NRP<packet> pkt = netp::make_ref<packet>(PACK_MIN_RIGHT_CAPACITY, n + PACK_MIN_LEFT_CAPACITY);
+			pkt->decre_read_idx(n);
+			m_segments.push_front({ pkt, pkt->head(), n });
+			m_len += n;
+			return pkt->head();
+		}
+
+		void _copy_out(netp::size_t off, byte_t* dst, netp::size_t n) const {
+			segments_t::const_iterator it = m_segments.begin();
+			while (off >= it->len) {
+				off -= it->len;
+				++it;
+			}
+			while (n > 0) {
+				const netp::size_t c = (it->len - off) > n ? n : (it->len - off);
+				::memcpy(dst, it->ptr + off, c);
+				dst += c;
+				n -= c;
+				off = 0;
+				++it;
+			}
+		}
+
+	public:
+		chained_packet() :
+			m_len(0)
+		{}
+
+		explicit chained_packet(NRP<packet> const& pkt) :
+			m_len(0)
+		{
+			append(pkt);
+		}
+
+		__NETP_FORCE_INLINE netp::size_t len() const { return m_len; }
+		__NETP_FORCE_INLINE netp::size_t segment_count() const { return m_segments.size(); }
+
+		void append(NRP<packet> const& pkt) {
+			if (pkt->len() == 0) {
+				return;
+			}
+			m_segments.push_back({ pkt, pkt->head(), pkt->len() });
+			m_len += pkt->len();
+		}
+
+		void append(NRP<chained_packet> const& other) {
+			NETP_ASSERT(other.get() != this);
+			m_segments.insert(m_segments.end(), other->m_segments.begin(), other->m_segments.end());
+			m_len += other->m_len;
+		}
+
+		void prepend(NRP<packet> const& pkt) {
+			if (pkt->len() == 0) {
+				return;
+			}
+			m_segments.push_front({ pkt, pkt->head(), pkt->len() });
+			m_len += pkt->len();
+		}
+
+		void prepend(NRP<chained_packet> const& other) {
+			NETP_ASSERT(other.get() != this);
+			m_segments.insert(m_segments.begin(), other->m_segments.begin(), other->m_segments.end());
+			m_len += other->m_len;
+		}
+
+		inline void write(void const* const buf, netp::size_t len) {
+			if (len == 0) {
+				return;
+			}
+			::memcpy(_tail_reserve(len), buf, len);
+		}
+
+		template <class T, class endian = netp::bytes_helper::big_endian>
+		inline void write(T t) {
+			netp::size_t wnbytes = endian::write_impl(t, _tail_reserve(sizeof(T)));
+			NETP_ASSERT(wnbytes == sizeof(T));
+			(void)wnbytes;
+		}
+
+		inline void fill(u8_t b, netp::size_t len) {
+			if (len == 0) {
+				return;
+			}
+			::memset(_tail_reserve(len), b, len);
+		}
+
+		__NETP_FORCE_INLINE void write_zero(netp::size_t len) {
+			fill(0, len);
+		}
+
+		inline void write_left(byte_t const* buf, netp::size_t len) {
+			if (len == 0) {
+				return;
+			}
+			::memcpy(_head_reserve(len), buf, len);
+		}
+
+		template <class T, class endian = netp::bytes_helper::big_endian>
+		inline void write_left(T t) {
+			netp::size_t wnbytes = endian::write_impl(t, _head_reserve(sizeof(T)));
+			NETP_ASSERT(wnbytes == sizeof(T));
+			(void)wnbytes;
+		}
+
+		template <class T, class endian = netp::bytes_helper::big_endian>
+		inline T peek() const {
+			NETP_ASSERT(sizeof(T) <= m_len);
+			chained_packet_segment const& s = m_segments.front();
+			if (NETP_LIKELY(s.len >= sizeof(T))) {
+				return endian::read_impl(s.ptr, netp::bytes_helper::type<T>());
+			}
+			byte_t tmp[sizeof(T)];
+			_copy_out(0, tmp, sizeof(T));
+			return endian::read_impl(tmp, netp::bytes_helper::type<T>());
+		}
+
+		netp::size_t peek(byte_t* const dst, netp::size_t len_) const {
+			if ((dst == nullptr) || len_ == 0) { return 0; }
+			const netp::size_t c = len_ > m_len ? m_len : len_;
+			if (c > 0) {
+				_copy_out(0, dst, c);
+			}
+			return c;
+		}
+
+		template <class T, class endian = netp::bytes_helper::big_endian>
+		inline T read() {
+			const T t = peek<T, endian>();
+			skip(sizeof(T));
+			return t;
+		}
+
+		inline netp::size_t read(byte_t* const dst, netp::size_t cap_) {
+			const netp::size_t c = peek(dst, cap_);
+			skip(c);
+			return c;
+		}
+
+		void skip(netp::size_t len_) {
+			NETP_ASSERT(len_ <= m_len);
+			m_len -= len_;
+			while (len_ > 0) {
+				chained_packet_segment& s = m_segments.front();
+				if (s.len > len_) {
+					s.ptr += len_;
+					s.len -= len_;
+					return;
+				}
+				len_ -= s.len;
+				m_segments.pop_front();
+			}
+		}
+
+		//[off, off+len_), shares the segments
+		NRP<chained_packet> slice(netp::size_t off, netp::size_t len_) const {
+			NETP_ASSERT((off + len_) <= m_len);
+			NRP<chained_packet> c = netp::make_ref<chained_packet>();
+			segments_t::const_iterator it = m_segments.begin();
+			while (len_ > 0 && off >= it->len) {
+				off -= it->len;
+				++it;
+			}
+			while (len_ > 0) {
+				const netp::size_t n = (it->len - off) > len_ ? len_ : (it->len - off);
+				c->m_segments.push_back({ it->pkt, it->ptr + off, n });
+				c->m_len += n;
+				len_ -= n;
+				off = 0;
+				++it;
+			}
+			return c;
+		}
+
+		//contiguous copy, the packet itself if it is linked in as a whole
+		NRP<packet> to_packet() const {
+			if (m_segments.size() == 1) {
+				chained_packet_segment const& s = m_segments.front();
+				if (s.ptr == s.pkt->head() && s.len == s.pkt->len()) {
+					return s.pkt;
+				}
+			}
+			NRP<packet> pkt = netp::make_ref<packet>(m_len);
+			if (m_len > 0) {
+				_copy_out(0, pkt->tail(), m_len);
+				pkt->incre_write_idx(m_len);
+			}
+			return pkt;
+		}
+
+		//fn(ptr, len) for every segment from the head
+		template <class fn_t>
+		void for_each_segment(fn_t const& fn) const {
+			for (segments_t::const_iterator it = m_segments.begin(); it != m_segments.end(); ++it) {
+				fn(it->ptr, it->len);
+			}
+		}
+
+		//fill at most iovcnt entries from the head, return the number filled
+		u32_t to_iov(iov_t* iov, u32_t iovcnt) const {
+			u32_t i = 0;
+			for (segments_t::const_iterator it = m_segments.begin(); it != m_segments.end() && i < iovcnt; ++it, ++i) {
+				NETP_IOV_SET(iov[i], it->ptr, it->len);
+			}
+			return i;
+		}
+
+		bool operator ==(chained_packet const& other) const {
+			if (m_len != other.m_len) {
+				return false;
+			}
+			segments_t::const_iterator l = m_segments.begin(), r = other.m_segments.begin();
+			netp::size_t loff = 0, roff = 0;
+			while (l != m_segments.end()) {
+				const netp::size_t n = (l->len - loff) < (r->len - roff) ? (l->len - loff) : (r->len - roff);
+				if (::memcmp(l->ptr + loff, r->ptr + roff, n) != 0) {
+					return false;
+				}
+				loff += n;
+				roff += n;
+				if (loff == l->len) { ++l; loff = 0; }
+				if (roff == r->len) { ++r; roff = 0; }
+			}
+			return true;
+		}
+
+		inline bool operator != (chained_packet const& other) const {
+			return !(*this == other);
+		}
+	};
+}
+#endif
@@ -3,6 +3,7 @@
 
 #include <netp/core.hpp>
 #include <netp/packet.hpp>
+#include <netp/chained_packet.hpp>
 #include <netp/io_event_loop.hpp>
 #include <netp/address.hpp>
 
@@ -37,14 +38,17 @@ namespace netp {
 		F_CLOSE_PENDING = 1<<12, //for transport, update close state
 		F_CLOSING = 1 << 13,
 		F_CLOSED = 1 << 14,
+		F_WRITE_FLUSH_PENDING = 1 << 15, //write coalesce, a flush has been deferred to the end of the current loop iteration
 
 		F_CONNECTING =1<<16,
 		F_CONNECTED = 1<<17,
 		F_LISTENING = 1<<18,
+		F_WRITE_HIGH_WATERMARK = 1<<19, //outbound bytes reached the high watermark, not writable until it drains to the low watermark
 
 		F_ACTIVE = 1 << 20,
 		F_BDLIMIT = 1 << 21,
 		F_BDLIMIT_TIMER = 1 << 22,
+		F_RATE_LIMIT_TIMER = 1 << 23, //waiting for tokens of the shared rate_limiter
 
 		F_IO_EVENT_LOOP_BEGINING = 1<<24,
 		F_IO_EVENT_LOOP_BEGIN_DONE = 1<<25,
@@ -59,6 +63,37 @@ namespace netp {
 		u32_t sndbuf_size;
 	};
 
+	//backpressure for producers, 0 high means no watermark check
+	struct channel_write_watermark {
+		u32_t high;
+		u32_t low;
+	};
+
+	//transport path conditions, sampled from TCP_INFO on linux
+	//rtt in microseconds, cwnd in segments, rates in bytes per second
+	struct channel_transport_stats {
+		long long sampled_at; //steady clock, in milliseconds
+		u32_t rtt;
+		u32_t rttvar;
+		u32_t min_rtt;
+		u32_t rto;
+		u32_t snd_mss;
+		u32_t snd_cwnd;
+		u32_t snd_ssthresh;
+		u32_t unacked; //segments in flight
+		u32_t lost;
+		u32_t retrans; //segments being retransmitted
+		u32_t total_retrans;
+		u32_t notsent_bytes;
+		u32_t rcv_rtt; //receiver side estimate
+		u32_t rcv_space; //bytes delivered to the app per rcv_rtt
+		u64_t delivery_rate;
+		u64_t pacing_rate;
+		u64_t bytes_acked;
+		u64_t bytes_received;
+	};
+	typedef netp::promise<std::tuple<int, channel_transport_stats>> channel_transport_stats_promise;
+
 	enum channel_buf_range {
 		CH_BUF_RCV_MAX_SIZE = (83388608U),//1024 * 1024 * 8,
 		CH_BUF_RCV_MIN_SIZE = (8192U),
@@ -78,6 +113,7 @@ namespace netp {
 	//NOTE: block|write_unblock hass been removed 
 	//the writer would get notified by write_promise->set when packet write done
 	//if write order is important , writer should maintain it's own write queue
+	//producers that want backpressure could set a write watermark and listen on writability_changed
 	class channel :
 		public netp::ref_base
 	{
@@ -91,6 +127,9 @@ namespace netp {
 		NRP<channel_pipeline> m_pipeline;
 		NRP<promise<int>> m_ch_close_p;
 		NRP<ref_base>	m_ctx;
+		channel_write_watermark m_wwm;
+
+		u64_t m_wdropped;
 
 	protected:
 		#define CH_FIRE_ACTION_IMPL_PACKET_1(_NAME, _IN) \
@@ -127,6 +166,50 @@ namespace netp {
 				m_ch_close_p->set(code);
 			}
 
+			//noutbound: bytes queued by the channel but not written to the transport yet
+			//capacity: hard limit of the queue (writes beyond it get E_CHANNEL_WRITE_BLOCK), high is clamped to it, 0 means no limit
+			inline void ch_check_writability(netp::size_t noutbound, netp::size_t capacity = 0) {
+				NETP_ASSERT(L->in_event_loop());
+				if (m_wwm.high == 0 || m_pipeline == nullptr) {
+					return;
+				}
+				netp::size_t high = m_wwm.high;
+				netp::size_t low = m_wwm.low;
+				if (capacity != 0 && high > capacity) {
+					high = capacity;
+					if (low > high) { low = (high >> 1); }
+				}
+				if ((m_chflag & int(channel_flag::F_WRITE_HIGH_WATERMARK)) == 0) {
+					if (noutbound >= high) {
+						m_chflag |= int(channel_flag::F_WRITE_HIGH_WATERMARK);
+						_ch_fire_writability_changed(false);
+					}
+				} else if (noutbound <= low) {
+					m_chflag &= ~int(channel_flag::F_WRITE_HIGH_WATERMARK);
+					_ch_fire_writability_changed(true);
+				}
+			}
+
+			//the flag flips at once, the event is scheduled, a handler that writes on it does not re-enter the write path that crossed the watermark
+			//the events keep their order, a false is always followed by a true
+			inline void _ch_fire_writability_changed(bool writable) {
+				L->schedule([ch = NRP<channel>(this), writable]() {
+					if (ch->m_pipeline != nullptr) {
+						ch->m_pipeline->fire_writability_changed(writable);
+					}
+				});
+			}
+
+			//a write was rejected with E_CHANNEL_WRITE_BLOCK below the high watermark, a producer that watches writability waits for writability_changed(true)
+			inline void ch_write_blocked() {
+				NETP_ASSERT(L->in_event_loop());
+				if (m_wwm.high == 0 || m_pipeline == nullptr || (m_chflag & int(channel_flag::F_WRITE_HIGH_WATERMARK))) {
+					return;
+				}
+				m_chflag |= int(channel_flag::F_WRITE_HIGH_WATERMARK);
+				_ch_fire_writability_changed(false);
+			}
+
 			inline void ch_deinit() {
 				NETP_ASSERT(m_pipeline != nullptr);
 				m_pipeline->deinit();
@@ -162,7 +245,9 @@ namespace netp {
 			m_cherrno(0),
 			m_pipeline(nullptr),
 			m_ch_close_p(nullptr),
-			m_ctx(nullptr)
+			m_ctx(nullptr),
+			m_wwm({0,0}),
+			m_wdropped(0)
 		{
 			NETP_TRACE_CHANNEL("channel::channel()");
 		}
@@ -175,6 +260,12 @@ namespace netp {
 		__NETP_FORCE_INLINE NRP<channel_pipeline> const& pipeline() const { return m_pipeline;}
 		__NETP_FORCE_INLINE NRP<promise<int>> const& ch_close_promise() const { return m_ch_close_p;}
 
+		//a packet with room for every header the pipeline prepends, so the encode stack never moves the payload
+		NRP<packet> ch_make_packet(netp::size_t right_capacity = (PACK_DEFAULT_CAPACITY - PACK_MIN_LEFT_CAPACITY)) const {
+			const u32_t room = m_pipeline == nullptr ? 0 : m_pipeline->headroom();
+			return netp::make_ref<packet>(right_capacity, room > PACK_MIN_LEFT_CAPACITY ? room : PACK_MIN_LEFT_CAPACITY);
+		}
+
 		template <class ctx_t>
 		inline NRP<ctx_t> get_ctx() const {
 			return netp::static_pointer_cast<ctx_t>(m_ctx);
@@ -190,6 +281,36 @@ namespace netp {
 		inline bool ch_is_passive() { return !ch_is_active(); }
 		inline bool ch_is_listener() { return (m_chflag & int(channel_flag::F_LISTENING)) != 0; }
 
+		inline bool ch_is_writable() const { return (m_chflag & int(channel_flag::F_WRITE_HIGH_WATERMARK)) == 0; }
+
+		//high==0 disable the watermark check, low is clamped to high
+		void ch_set_write_watermark(u32_t high, u32_t low) {
+			L->execute([ch = NRP<channel>(this), high, low]() {
+				ch->m_wwm = { high, (low > high ? high : low) };
+				if (high == 0 && (ch->m_chflag & int(channel_flag::F_WRITE_HIGH_WATERMARK))) {
+					ch->m_chflag &= ~int(channel_flag::F_WRITE_HIGH_WATERMARK);
+					if (ch->m_pipeline != nullptr) {
+						ch->m_pipeline->fire_writability_changed(true);
+					}
+				}
+			});
+		}
+
+		//writes without a promise(ch_write_forget) rejected so far, loop thread only
+		inline u64_t ch_write_dropped() const { return m_wdropped; }
+
+		//a rejected write without a promise(ch_write_forget) is counted, see ch_write_dropped
+		//the error event is kept for the errors that break the channel, a rejection is per write and may be transient(E_CHANNEL_WRITE_BLOCK)
+		inline void ch_write_failed(NRP<promise<int>> const& chp, int code) {
+			NETP_ASSERT(L->in_event_loop());
+			if (chp != nullptr) {
+				chp->set(code);
+			} else {
+				++m_wdropped;
+				NETP_TRACE_CHANNEL("[channel]write dropped: %d, total: %llu", code, (unsigned long long)m_wdropped);
+			}
+		}
+
 		inline void ch_set_active() { m_chflag |= int(channel_flag::F_ACTIVE); }
 		inline void ch_set_connected() {
 			m_chflag &= ~(int(channel_flag::F_CLOSED)|int(channel_flag::F_CONNECTING));
@@ -225,7 +346,7 @@ public: \
 private: \
 		inline void __ch_##NAME(NRP<packet> const& outlet, NRP<promise<int>> const& chp) {\
 			if (m_pipeline == nullptr) { \
-					chp->set(netp::E_CHANNEL_CLOSED); \
+				if (chp != nullptr) { chp->set(netp::E_CHANNEL_CLOSED); } \
 				return; \
 			} \
 			m_pipeline->NAME(outlet,chp); \
@@ -241,14 +362,38 @@ public: \
 				_ch->__ch_##NAME(outlet, chp); \
 			}); \
 		} \
+		inline void ch_##NAME##_forget(NRP<packet> const& outlet) {\
+			ch_##NAME(outlet, nullptr); \
+		} \
 
 		CH_FUTURE_ACTION_IMPL_PACKET(write);
 
+		//with no handler encoding writes, the segments go to the transport as they are, otherwise the chain is flattened by to_packet and written down the pipeline
+		inline void ch_write(NRP<chained_packet> const& chain, NRP<promise<int>> const& chp) {
+			NETP_ASSERT(chain->len() > 0);
+			L->execute([_ch = NRP<channel>(this), chain, chp]() {
+				if (_ch->m_pipeline == nullptr) {
+					if (chp != nullptr) { chp->set(netp::E_CHANNEL_CLOSED); }
+					return;
+				}
+				if (_ch->m_pipeline->has_outbound_write()) {
+					_ch->m_pipeline->write(chain->to_packet(), chp);
+					return;
+				}
+				_ch->ch_write_impl(chain, chp);
+			});
+		}
+		inline NRP<promise<int>> ch_write(NRP<chained_packet> const& chain) {
+			const NRP<promise<int>> chp = netp::make_ref<promise<int>>();
+			ch_write(chain, chp);
+			return chp;
+		}
+
 #define CH_FUTURE_ACTION_IMPL_PACKET_ADDR(NAME) \
 private: \
 		inline void __ch_##NAME(NRP<packet> const& outlet, address const& to, NRP<promise<int>> const& chp) {\
 			if (m_pipeline == nullptr) { \
-					chp->set(netp::E_CHANNEL_CLOSED); \
+				if (chp != nullptr) { chp->set(netp::E_CHANNEL_CLOSED); } \
 				return; \
 			} \
 			m_pipeline->NAME(outlet,to,chp); \
@@ -264,6 +409,9 @@ public: \
 				_ch->__ch_##NAME(outlet,to, chp); \
 			}); \
 		} \
+		inline void ch_##NAME##_forget(NRP<packet> const& outlet, address const& to) {\
+			ch_##NAME(outlet, to, nullptr); \
+		} \
 
 	CH_FUTURE_ACTION_IMPL_PACKET_ADDR(write_to);
 
@@ -294,7 +442,20 @@ public: \
 		virtual NRP<promise<int>> ch_set_nodelay() = 0;
 		virtual void ch_set_bdlimit(u32_t) {};
 
+		//the last sample if sampling is on, otherwise sampled in place
+		virtual NRP<channel_transport_stats_promise> ch_get_transport_stats() {
+			NRP<channel_transport_stats_promise> p = netp::make_ref<channel_transport_stats_promise>();
+			p->set(std::make_tuple(netp::E_INVALID_OPERATION, channel_transport_stats()));
+			return p;
+		}
+		//in milliseconds, 0 stops sampling
+		virtual void ch_set_transport_stats_sampling(u32_t) {};
+
 		virtual void ch_write_impl(NRP<packet> const& outlet, NRP<promise<int>> const& chp) = 0;
+		//a transport with a gather write links the segments in
+		virtual void ch_write_impl(NRP<chained_packet> const& chain, NRP<promise<int>> const& chp) {
+			ch_write_impl(chain->to_packet(), chp);
+		}
 		virtual void ch_write_to_impl(NRP<packet> const& outlet, netp::address const& to, NRP<promise<int>> const& chp) { 
 			NETP_ASSERT("to_impl"); 
 		
@@ -12,6 +12,7 @@ namespace netp {
 
 	enum channel_handler_api {
 		CH_ACTIVITY_CONNECTED			= 1,
+		CH_ACTIVITY_WRITABILITY_CHANGED = 1<<1, //opt-in, not included in CH_ACTIVITY
 		CH_ACTIVITY_CLOSED					= 1<< 2,
 		CH_ACTIVITY_ERROR					= 1 << 3,
 		CH_ACTIVITY_READ_CLOSED		= 1 << 4,
@@ -41,7 +42,8 @@ namespace netp {
 		friend class channel_handler_context;
 	public:
 		u16_t CH_H_FLAG;
-		channel_handler_abstract(u16_t flag) : CH_H_FLAG(flag)
+		u16_t CH_H_HEADROOM; //max bytes write() prepends to the outlet with write_left, see channel::ch_make_packet
+		channel_handler_abstract(u16_t flag, u16_t headroom = 0) : CH_H_FLAG(flag), CH_H_HEADROOM(headroom)
 		{
 		}
 
@@ -52,6 +54,7 @@ namespace netp {
 		virtual void error(NRP<channel_handler_context> const& ctx, int err);
 		virtual void read_closed(NRP<channel_handler_context> const& ctx);
 		virtual void write_closed(NRP<channel_handler_context> const& ctx);
+		virtual void writability_changed(NRP<channel_handler_context> const& ctx, bool writable);
 
 		//for inbound
 		virtual void read(NRP<channel_handler_context> const& ctx, NRP<packet> const& income);
@@ -91,7 +94,7 @@ namespace netp {
 	{
 	public:
 		channel_handler_tail() :
-			channel_handler_abstract(CH_ACTIVITY|CH_INBOUND)
+			channel_handler_abstract(CH_ACTIVITY|CH_ACTIVITY_WRITABILITY_CHANGED|CH_INBOUND)
 		{}
 	protected:
 		void connected(NRP<channel_handler_context> const& ctx);
@@ -99,6 +102,7 @@ namespace netp {
 		void error(NRP<channel_handler_context> const& ctx, int err);
 		void read_closed(NRP<channel_handler_context> const& ctx);
 		void write_closed(NRP<channel_handler_context> const& ctx);
+		void writability_changed(NRP<channel_handler_context> const& ctx, bool writable);
 
 		void read(NRP<channel_handler_context> const& ctx, NRP<packet> const& income) ;
 		void readfrom(NRP<channel_handler_context> const& ctx, NRP<packet> const& income, address const& from);
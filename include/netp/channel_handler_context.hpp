@@ -54,6 +54,22 @@ __ctx_iterate_begin: \
 		VOID_INVOKE_NEXT_INT_1(NAME,HANDLER_FLAG); \
 	} \
 
+#define VOID_INVOKE_NEXT_BOOL_1(NAME,HANDLER_FLAG) \
+	CHANNEL_HANDLER_CONTEXT_ITERATE_CTX(HANDLER_FLAG,N) \
+	_ctx->H->NAME(_ctx,b); \
+
+#define VOID_FIRE_HANDLER_CONTEXT_IMPL_H_TO_T_BOOL_1(NAME,HANDLER_FLAG) \
+	inline void fire_##NAME( bool b ) const { \
+		NETP_ASSERT(L->in_event_loop()); \
+		NRP<channel_handler_context>_ctx = N; \
+		VOID_INVOKE_NEXT_BOOL_1(NAME,HANDLER_FLAG); \
+	} \
+	inline void invoke_##NAME(bool b) { \
+		NETP_ASSERT(L->in_event_loop()); \
+		NRP<channel_handler_context>_ctx = NRP<channel_handler_context>(this); \
+		VOID_INVOKE_NEXT_BOOL_1(NAME,HANDLER_FLAG); \
+	} \
+
 #define VOID_INVOKE_NEXT_PACKET(NAME,HANDLER_FLAG) \
 	CHANNEL_HANDLER_CONTEXT_ITERATE_CTX(HANDLER_FLAG,N) \
 	_ctx->H->NAME(_ctx,p); \
@@ -97,7 +113,7 @@ __ctx_iterate_begin: \
 private:\
 	inline void __##NAME(NRP<packet> const& p, NRP<promise<int>> const& chp) { \
 		if( NETP_UNLIKELY(H_FLAG&CH_CTX_REMOVED) ) {\
-			chp->set(netp::E_CHANNEL_CONTEXT_REMOVED); \
+			__write_failed(chp, netp::E_CHANNEL_CONTEXT_REMOVED); \
 			return; \
 		} \
 		CH_PROMISE_INVOKE_PREV_PACKET_CH_PROMISE(NAME,HANDLER_FLAG) \
@@ -113,6 +129,9 @@ public:\
 		NAME(p,f); \
 		return f; \
 	} \
+	inline void NAME##_forget(NRP<packet> const& p) { \
+		NAME(p, nullptr); \
+	} \
 
 #define CH_PROMISE_INVOKE_PREV_PACKET_ADDR_CH_PROMISE(NAME,HANDLER_FLAG) \
 	NRP<channel_handler_context>_ctx = P; \
@@ -123,7 +142,7 @@ public:\
 private:\
 	inline void __##NAME(NRP<packet> const& p, address const& to, NRP<promise<int>> const& chp) { \
 		if( NETP_UNLIKELY(H_FLAG&CH_CTX_REMOVED) ) {\
-			chp->set(netp::E_CHANNEL_CONTEXT_REMOVED); \
+			__write_failed(chp, netp::E_CHANNEL_CONTEXT_REMOVED); \
 			return; \
 		} \
 		CH_PROMISE_INVOKE_PREV_PACKET_ADDR_CH_PROMISE(NAME,HANDLER_FLAG) \
@@ -139,6 +158,9 @@ public:\
 		NAME(p,to,f); \
 		return f;\
 	} \
+	inline void NAME##_forget(NRP<packet> const& p, address const& to) { \
+		NAME(p, to, nullptr); \
+	} \
 
 #define CH_PROMISE_INVOKE_PREV_CH_PROMISE(NAME,HANDLER_FLAG) \
 	NRP<channel_handler_context>_ctx = P; \
@@ -185,10 +207,14 @@ namespace netp {
 		NRP<netp::channel> ch;
 	private:
 		u16_t H_FLAG;
+		u16_t H_HEADROOM;
 		NRP<channel_handler_context> P;
 		NRP<channel_handler_context> N;
 		NRP<channel_handler_abstract> H;
 
+		//chp is nullptr for write_forget, see channel::ch_write_failed
+		void __write_failed(NRP<promise<int>> const& chp, int code) const;
+
 	public:
 		channel_handler_context(NRP<netp::channel> const& ch_, NRP<channel_handler_abstract> const& h);
 
@@ -200,11 +226,42 @@ namespace netp {
 			p->set(netp::OK);
 		}
 
+		//header bytes prepended by the outbound handlers between this ctx and the head
+		u32_t headroom() const {
+			NETP_ASSERT(L->in_event_loop());
+			u32_t room = 0;
+			for (channel_handler_context* _ctx = P.get(); _ctx != nullptr; _ctx = _ctx->P.get()) {
+				if ((_ctx->H_FLAG & (CH_OUTBOUND_WRITE | CH_CTX_REMOVED)) == CH_OUTBOUND_WRITE) {
+					room += _ctx->H_HEADROOM;
+				}
+			}
+			return room;
+		}
+
+		//an outbound handler between this ctx and the head encodes the writes
+		bool has_outbound_write() const {
+			NETP_ASSERT(L->in_event_loop());
+			//the head writes to the channel itself
+			for (channel_handler_context* _ctx = P.get(); _ctx != nullptr && _ctx->P != nullptr; _ctx = _ctx->P.get()) {
+				if ((_ctx->H_FLAG & (CH_OUTBOUND_WRITE | CH_CTX_REMOVED)) == CH_OUTBOUND_WRITE) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		//for packets written from this ctx, no write_left below would realloc, own_headroom for the bytes the caller prepends itself
+		NRP<packet> make_packet(netp::size_t right_capacity = (PACK_DEFAULT_CAPACITY - PACK_MIN_LEFT_CAPACITY), u32_t own_headroom = 0) const {
+			const u32_t room = headroom() + own_headroom;
+			return netp::make_ref<packet>(right_capacity, room > PACK_MIN_LEFT_CAPACITY ? room : PACK_MIN_LEFT_CAPACITY);
+		}
+
 		VOID_FIRE_HANDLER_CONTEXT_IMPL_H_TO_T_0(connected, CH_ACTIVITY_CONNECTED)
 		VOID_FIRE_HANDLER_CONTEXT_IMPL_H_TO_T_0(closed, CH_ACTIVITY_CLOSED)
 		VOID_FIRE_HANDLER_CONTEXT_IMPL_H_TO_T_0(read_closed, CH_ACTIVITY_READ_CLOSED)
 		VOID_FIRE_HANDLER_CONTEXT_IMPL_H_TO_T_0(write_closed, CH_ACTIVITY_WRITE_CLOSED)
 		VOID_FIRE_HANDLER_CONTEXT_IMPL_H_TO_T_INT_1(error, CH_ACTIVITY_ERROR)
+		VOID_FIRE_HANDLER_CONTEXT_IMPL_H_TO_T_BOOL_1(writability_changed, CH_ACTIVITY_WRITABILITY_CHANGED)
 		VOID_FIRE_HANDLER_CONTEXT_IMPL_H_TO_T_PACKET_1(read, CH_INBOUND_READ)
 
 		VOID_FIRE_HANDLER_CONTEXT_IMPL_H_TO_T_PACKET_ADDR(readfrom, CH_INBOUND_READ_FROM)
@@ -18,6 +18,11 @@
 		m_head->fire_##NAME(i); \
 	}\
 
+#define PIPELINE_VOID_FIRE_BOOL_1(NAME) \
+	__NETP_FORCE_INLINE void fire_##NAME(bool b) const { \
+		m_head->fire_##NAME(b); \
+	}\
+
 #define PIPELINE_VOID_FIRE_PACKET_1(NAME) \
 	__NETP_FORCE_INLINE void fire_##NAME(NRP<packet> const& packet_) const {\
 		m_head->fire_##NAME(packet_); \
@@ -76,6 +81,8 @@ namespace netp {
 		//tail,head is boundary
 		NRP<channel_handler_context> m_head;
 		NRP<channel_handler_context> m_tail;
+		//headroom of the whole pipeline, updated on add, might be over estimated after a remove
+		std::atomic<u32_t> m_headroom;
 
 	public:
 		channel_pipeline(NRP<channel> const& ch);
@@ -93,10 +100,19 @@ namespace netp {
 
 			m_tail->P->N = ctx;
 			m_tail->P = ctx;
+			m_headroom.store(m_tail->headroom(), std::memory_order_relaxed);
 
 			p->set(std::make_tuple(netp::OK, ctx));
 		}
 
+		__NETP_FORCE_INLINE u32_t headroom() const {
+			return m_headroom.load(std::memory_order_relaxed);
+		}
+
+		inline bool has_outbound_write() const {
+			return m_tail->has_outbound_write();
+		}
+
 		NRP<netp::add_handler_promise> add_last(NRP<channel_handler_abstract> const& h) {
 			NRP<netp::add_handler_promise> p = netp::make_ref<netp::add_handler_promise>();
 			m_loop->execute([ppl = NRP<channel_pipeline>(this), h, p]() -> void {
@@ -111,6 +127,7 @@ namespace netp {
 		PIPELINE_VOID_FIRE_INT_1(error)
 		PIPELINE_VOID_FIRE_VOID(read_closed)
 		PIPELINE_VOID_FIRE_VOID(write_closed)
+		PIPELINE_VOID_FIRE_BOOL_1(writability_changed)
 		PIPELINE_VOID_FIRE_PACKET_1(read)
 
 		PIPELINE_VOID_FIRE_PACKET_ADDR(readfrom)
@@ -0,0 +1,143 @@
+#ifndef _NETP_CONNECTION_POOL_HPP
+#define _NETP_CONNECTION_POOL_HPP
+
+#include <map>
+#include <deque>
+
+#include <netp/core.hpp>
+#include <netp/smart_ptr.hpp>
+#include <netp/mutex.hpp>
+#include <netp/promise.hpp>
+#include <netp/timer.hpp>
+#include <netp/channel.hpp>
+#include <netp/socket.hpp>
+
+//in milliseconds
+#define NETP_CONNECTION_POOL_IDLE_TIMEOUT (60*1000)
+#define NETP_CONNECTION_POOL_HEALTH_CHECK_INTERVAL (15*1000)
+#define NETP_CONNECTION_POOL_IDLE_CHECK_MIN (1000)
+
+#define NETP_CONNECTION_POOL_MAX_PER_HOST (8)
+#define NETP_CONNECTION_POOL_MAX_IDLE_PER_HOST (8)
+#define NETP_CONNECTION_POOL_MAX_WAITING_PER_HOST (128)
+
+namespace netp {
+
+	//return false to drop an idle channel, run on the loop of the channel
+	typedef std::function<bool(NRP<channel> const& ch)> fn_connection_health_check_t;
+
+	struct connection_pool_cfg final :
+		public netp::ref_base
+	{
+		NRP<socket_cfg> sock_cfg; //cloned for each dial, L is replaced by the loop the channel is acquired on
+		fn_channel_initializer_t initializer; //run once per connection, handlers stay installed while pooled, e.g rpc::pool_initializer
+		fn_connection_health_check_t health_check;
+		u32_t max_per_host; //dialing + in use + idle, per loop
+		u32_t max_idle_per_host; //per loop
+		u32_t max_waiting_per_host; //acquires queued when max_per_host reached, per loop
+		u32_t idle_timeout; //in milliseconds, 0 means never expire
+		u32_t health_check_interval; //in milliseconds, idle channels are checked on acquire, and periodically if not 0
+
+		connection_pool_cfg() :
+			sock_cfg(netp::make_ref<socket_cfg>()),
+			initializer(nullptr),
+			health_check(nullptr),
+			max_per_host(NETP_CONNECTION_POOL_MAX_PER_HOST),
+			max_idle_per_host(NETP_CONNECTION_POOL_MAX_IDLE_PER_HOST),
+			max_waiting_per_host(NETP_CONNECTION_POOL_MAX_WAITING_PER_HOST),
+			idle_timeout(NETP_CONNECTION_POOL_IDLE_TIMEOUT),
+			health_check_interval(NETP_CONNECTION_POOL_HEALTH_CHECK_INTERVAL)
+		{}
+	};
+
+	//outbound channels keyed by (loop, dial url), e.g tcp://host:port
+	//acquire on a loop hands out a channel of that loop, acquire on any other thread one of the next loop of the group
+	//every loop has its own idle lists and limits, only touched on that loop, a channel is never handed out to another loop
+	//usage: acquire(url) -> use the channel -> release(ch), release(ch,false) or ch_close() if it is not reusable
+	//rpc::acquire(pool,url) hands out an rpc over a pooled channel
+	class connection_pool final :
+		public netp::ref_base
+	{
+		struct idle_entry {
+			NRP<channel> ch;
+			timer_timepoint_t since;
+		};
+		typedef std::deque<idle_entry> idle_list_t;
+		typedef std::deque<NRP<channel_dial_promise>> waiting_list_t;
+
+		struct host_entry final :
+			public netp::ref_base
+		{
+			string_t url;
+			idle_list_t idles;
+			waiting_list_t waitings;
+			u32_t nconn; //dialing + in use + idle
+			u32_t ndialing;
+
+			host_entry(string_t const& url_) :
+				url(url_),
+				nconn(0),
+				ndialing(0)
+			{}
+		};
+		typedef std::map<string_t, NRP<host_entry>> host_map_t;
+		typedef std::map<channel*, NRP<host_entry>> owner_map_t;
+
+		//the hosts of one loop
+		struct loop_pool final :
+			public netp::ref_base
+		{
+			NRP<io_event_loop> L;
+			host_map_t hosts;
+			owner_map_t owners;
+			NRP<timer> tm_idle;
+			bool closed;
+
+			loop_pool(NRP<io_event_loop> const& L_, bool closed_) :
+				L(L_),
+				tm_idle(nullptr),
+				closed(closed_)
+			{}
+		};
+		typedef std::map<io_event_loop*, NRP<loop_pool>> loop_pool_map_t;
+
+		NRP<io_event_loop> m_L; //not nullptr if the pool is pinned to a loop
+		NRP<connection_pool_cfg> m_cfg;
+		spin_mutex m_mtx;
+		loop_pool_map_t m_loop_pools;
+		bool m_closed;
+
+		NRP<loop_pool> _loop_pool(NRP<io_event_loop> const& L);
+
+		void _do_acquire(NRP<loop_pool> const& lp, string_t const& url, NRP<channel_dial_promise> const& dp);
+		void _do_release(NRP<loop_pool> const& lp, NRP<channel> const& ch, bool reuse);
+		void _do_close(NRP<loop_pool> const& lp);
+
+		NRP<host_entry> _host(NRP<loop_pool> const& lp, string_t const& url);
+		void _dial(NRP<loop_pool> const& lp, NRP<host_entry> const& h, NRP<channel_dial_promise> const& dp);
+		void _dial_done(NRP<loop_pool> const& lp, NRP<host_entry> const& h, NRP<channel_dial_promise> const& dp, std::tuple<int, NRP<channel>> const& tupc);
+		void _ch_closed(NRP<loop_pool> const& lp, NRP<host_entry> const& h, NRP<channel> const& ch);
+		void _slot_available(NRP<loop_pool> const& lp, NRP<host_entry> const& h);
+
+		bool _is_healthy(NRP<channel> const& ch);
+		void _idle_timer_check(NRP<loop_pool> const& lp);
+		void _tmcb_idle(NRP<loop_pool> const& lp, NRP<timer> const& t);
+
+	public:
+		//L_ pins the pool to one loop, all the channels belong to it whatever the thread acquires
+		connection_pool(NRP<connection_pool_cfg> const& cfg, NRP<io_event_loop> const& L_ = nullptr);
+		~connection_pool();
+
+		//resolve with an idle channel if there is a healthy one, otherwise dial, or wait for a release when max_per_host reached
+		NRP<channel_dial_promise> acquire(string_t const& url);
+		NRP<channel_dial_promise> acquire(std::string const& url) { return acquire(string_t(url.c_str(), url.length())); }
+		NRP<channel_dial_promise> acquire(const char* url) { return acquire(string_t(url)); }
+
+		//hand back a channel got by acquire, reuse==false closes it
+		void release(NRP<channel> const& ch, bool reuse = true);
+
+		//close idle channels, fail waitings, in use channels are closed on release
+		void close();
+	};
+}
+#endif
@@ -281,6 +281,7 @@ namespace netp {
 	const int E_SOCKET_WRITE_BLOCK		= -30002;
 	const int E_SOCKET_READ_BLOCK		= -30003;
 	const int E_SOCKET_GRACE_CLOSE	= -30004;
+	const int E_SOCKET_ERRQUEUE_READY	= -30005; //not an error, the error queue (tx timestamps) is readable, sent to the notify fn
 
 	//31000 - 31999 //user custom socket error
 	const int E_SOCKET_INVALID_FAMILY		= -31001;
@@ -328,6 +329,9 @@ namespace netp {
 	const int E_MUX_STREAM_TRANSPORT_CLOSED = -37001;
 	const int E_MUX_STREAM_RST = -37002;
 
+	const int E_CONNECTION_POOL_EXHAUSTED = -38001;
+	const int E_CONNECTION_POOL_CLOSED = -38002;
+
 	const int E_RPC_NO_WRITE_CHANNEL		= -40001;
 	const int E_RPC_CALL_UNKNOWN_API		= -40002;
 	const int E_RPC_CALL_INVALID_PARAM		= -40003;
@@ -105,6 +105,10 @@
 
 #define NETP_RPC_QUEUE_SIZE (200)
 
+//bump arena of each rpc/http connection for the request scoped objects, 0 to disable
+#define NETP_RPC_ARENA_BYTES (32*1024)
+#define NETP_HTTP_ARENA_BYTES (32*1024)
+
 
 //#define NETP_ENABLE_WEBSOCKET
 
@@ -125,6 +129,9 @@
 
 #define NETP_DEBUG_WATCH_CTX_FLAG
 
+//assert on a netp::loop_ref_base grabbed/dropped on a thread other than the one it was created on
+#define NETP_DEBUG_LOOP_CONFINED_REF
+
 //#define NETP_ENABLE_TRACE_HTTP_MESSAGE
 #endif
 
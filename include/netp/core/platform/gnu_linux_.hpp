@@ -5,6 +5,7 @@
 //for gnu linux
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <getopt.h>
 #include <errno.h>
@@ -0,0 +1,418 @@
+#ifndef _NETP_COROUTINE_HPP_
+#define _NETP_COROUTINE_HPP_
+
+#include <netp/core.hpp>
+
+//C++20 only, the header is empty for the older standards the library itself is built with
+#if defined(__cpp_impl_coroutine) && ((__cplusplus >= 202002L) || (defined(_MSVC_LANG) && (_MSVC_LANG >= 202002L)))
+	#define NETP_ENABLE_COROUTINE
+#endif
+
+#ifdef NETP_ENABLE_COROUTINE
+
+#include <coroutine>
+#include <exception>
+#include <deque>
+
+#include <netp/promise.hpp>
+#include <netp/timer.hpp>
+#include <netp/io_event_loop.hpp>
+#include <netp/channel.hpp>
+#include <netp/channel_handler.hpp>
+#include <netp/channel_handler_context.hpp>
+#include <netp/socket.hpp>
+
+namespace netp {
+
+	template <class V = void>
+	class co_task;
+
+	namespace __co {
+
+		//coroutine frames are blocks of netp::allocator
+		struct frame_alloc {
+			static void* operator new(std::size_t size) {
+				return netp::allocator<char>::malloc(size);
+			}
+			static void operator delete(void* p, std::size_t size) {
+				(void)size;
+				netp::allocator<char>::free((char*)p);
+			}
+		};
+
+		struct task_final_awaiter {
+			bool await_ready() const noexcept { return false; }
+
+			template <class P>
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+				const std::coroutine_handle<> cont = h.promise().m_continuation;
+				if (cont) {
+					return cont;
+				}
+				if (h.promise().m_detached) {
+					h.destroy();
+				}
+				return std::noop_coroutine();
+			}
+			void await_resume() const noexcept {}
+		};
+
+		struct task_promise_base :
+			public frame_alloc
+		{
+			std::coroutine_handle<> m_continuation;
+			std::exception_ptr m_ex;
+			bool m_detached = false;
+
+			std::suspend_always initial_suspend() const noexcept { return {}; }
+			task_final_awaiter final_suspend() const noexcept { return {}; }
+
+			void unhandled_exception() {
+				m_ex = std::current_exception();
+				//nobody awaits a spawned task, the exception is logged and dropped with the frame at final_suspend
+				if (m_detached) {
+					try {
+						std::rethrow_exception(m_ex);
+					} catch (std::exception const& e) {
+						NETP_ERR("[co_task]detached task exit with exception: %s", e.what());
+					} catch (...) {
+						NETP_ERR("[co_task]detached task exit with unknown exception");
+					}
+				}
+			}
+		};
+
+		template <class V>
+		struct task_promise final :
+			public task_promise_base
+		{
+			V m_v = V();
+
+			co_task<V> get_return_object() noexcept;
+
+			template <class U>
+			void return_value(U&& v) {
+				m_v = std::forward<U>(v);
+			}
+			V result() {
+				if (m_ex) {
+					std::rethrow_exception(m_ex);
+				}
+				return std::move(m_v);
+			}
+		};
+
+		template <>
+		struct task_promise<void> final :
+			public task_promise_base
+		{
+			co_task<void> get_return_object() noexcept;
+
+			void return_void() const noexcept {}
+			void result() {
+				if (m_ex) {
+					std::rethrow_exception(m_ex);
+				}
+			}
+		};
+	}
+
+	/*
+	 * the return type of a netplus coroutine
+	 * 1, lazy, it starts on co_await or co_spawn, a co_await resumes the awaiter by symmetric transfer when it returns
+	 * 2, the frame is netp::allocator memory, it is owned by the co_task until co_spawn detaches it
+	 * 3, V must be default constructible, as it is for promise<V>
+	 * 4, gcc 12 destroys a lambda temporary of a co_await operand twice, pass named callables to co_dial/co_listen_on
+	 */
+	template <class V>
+	class co_task final {
+	public:
+		typedef __co::task_promise<V> promise_type;
+		typedef std::coroutine_handle<promise_type> handle_t;
+
+	private:
+		handle_t m_h;
+
+		NETP_DECLARE_NONCOPYABLE(co_task)
+
+	public:
+		explicit co_task(handle_t h) noexcept :
+			m_h(h)
+		{}
+
+		co_task(co_task&& other) noexcept :
+			m_h(other.m_h)
+		{
+			other.m_h = nullptr;
+		}
+
+		co_task& operator=(co_task&& other) noexcept {
+			if (this != &other) {
+				if (m_h) {
+					m_h.destroy();
+				}
+				m_h = other.m_h;
+				other.m_h = nullptr;
+			}
+			return *this;
+		}
+
+		~co_task() {
+			if (m_h) {
+				m_h.destroy();
+			}
+		}
+
+		//the frame frees itself at the end
+		handle_t detach() noexcept {
+			handle_t h = m_h;
+			m_h = nullptr;
+			if (h) {
+				h.promise().m_detached = true;
+			}
+			return h;
+		}
+
+		struct awaiter {
+			handle_t h;
+
+			bool await_ready() const noexcept { return !h || h.done(); }
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<> cont) noexcept {
+				h.promise().m_continuation = cont;
+				return h;
+			}
+			V await_resume() {
+				return h.promise().result();
+			}
+		};
+
+		awaiter operator co_await() const noexcept {
+			return awaiter{ m_h };
+		}
+	};
+
+	namespace __co {
+		template <class V>
+		inline co_task<V> task_promise<V>::get_return_object() noexcept {
+			return co_task<V>(std::coroutine_handle<task_promise<V>>::from_promise(*this));
+		}
+
+		inline co_task<void> task_promise<void>::get_return_object() noexcept {
+			return co_task<void>(std::coroutine_handle<task_promise<void>>::from_promise(*this));
+		}
+	}
+
+	//runs t on the current thread until its first suspension
+	template <class V>
+	inline void co_spawn(co_task<V>&& t) {
+		const typename co_task<V>::handle_t h = t.detach();
+		if (h) {
+			h.resume();
+		}
+	}
+
+	//starts t on L, a frame that has not started when L terminates is leaked
+	template <class V>
+	inline void co_spawn(NRP<io_event_loop> const& L, co_task<V>&& t) {
+		const typename co_task<V>::handle_t h = t.detach();
+		if (h) {
+			L->execute([h]() {
+				h.resume();
+			});
+		}
+	}
+
+	namespace __co {
+		//L, or the loop that suspends, or a loop of the group for the other threads
+		inline NRP<io_event_loop> resume_loop(NRP<io_event_loop> const& L) {
+			if (L != nullptr) {
+				return L;
+			}
+			io_event_loop* const cur = io_event_loop::current();
+			return cur != nullptr ? NRP<io_event_loop>(cur) : io_event_loop_group::instance()->next();
+		}
+	}
+
+	/*
+	 * co_await on a promise
+	 * 1, it is resumed by a task scheduled on L, or on the loop that suspends if L is nullptr, never inside the lock of the promise
+	 * 2, a coroutine that suspends off the loops is resumed on a loop of the group
+	 * 3, a cancelled promise resumes with V()
+	 */
+	template <class V>
+	struct co_promise_awaiter {
+		NRP<promise<V>> p;
+		NRP<io_event_loop> L;
+
+		bool await_ready() const { return !p->is_idle(); }
+		void await_suspend(std::coroutine_handle<> h) {
+			//do not touch this after if_done, the coroutine might be resumed and finished on L
+			p->if_done([h, L_ = __co::resume_loop(L)](V const&) {
+				L_->schedule([h]() {
+					h.resume();
+				});
+			});
+		}
+		V await_resume() {
+			return p->get();
+		}
+	};
+
+	//resumed on the loop of the channel, as co_promise_awaiter if there is no channel
+	struct co_channel_promise_awaiter :
+		public co_promise_awaiter<std::tuple<int, NRP<channel>>>
+	{
+		void await_suspend(std::coroutine_handle<> h) {
+			p->if_done([h, L_ = __co::resume_loop(L)](std::tuple<int, NRP<channel>> const& t) {
+				NRP<io_event_loop> const& CL = (std::get<0>(t) == netp::OK) ? std::get<1>(t)->L : L_;
+				CL->schedule([h]() {
+					h.resume();
+				});
+			});
+		}
+	};
+
+	//set and resumed on one loop, no lock
+	template <class V>
+	struct co_loop_promise_awaiter {
+		NRP<loop_promise<V>> p;
+
+		bool await_ready() const { return !p->is_idle(); }
+		void await_suspend(std::coroutine_handle<> h) {
+			p->if_done([h](V const&) {
+				h.resume();
+			});
+		}
+		V await_resume() {
+			return p->get();
+		}
+	};
+
+	//co_await ch->ch_write(outlet), co_await ch->ch_close() ...
+	template <class V>
+	inline co_promise_awaiter<V> operator co_await(NRP<promise<V>> const& p) {
+		return co_promise_awaiter<V>{ p, nullptr };
+	}
+
+	template <class V>
+	inline co_loop_promise_awaiter<V> operator co_await(NRP<loop_promise<V>> const& p) {
+		return co_loop_promise_awaiter<V>{ p };
+	}
+
+	template <class V>
+	inline co_promise_awaiter<V> co_wait(NRP<promise<V>> const& p, NRP<io_event_loop> const& L) {
+		return co_promise_awaiter<V>{ p, L };
+	}
+
+	//resumed by a timer of L with netp::OK, or with E_IO_EVENT_LOOP_TERMINATED if the timer could not be launched
+	struct co_sleep_awaiter {
+		NRP<io_event_loop> L;
+		timer_duration_t delay;
+		int rt;
+
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> h) {
+			NRP<promise<int>> lf = netp::make_ref<promise<int>>();
+			lf->if_done([h, this](int const& rt_) {
+				if (rt_ != netp::OK) {
+					rt = rt_;
+					h.resume();
+				}
+			});
+			L->launch(netp::make_ref<netp::timer>(delay, [h](NRP<netp::timer> const&) {
+				h.resume();
+			}), lf);
+		}
+		int await_resume() const noexcept { return rt; }
+	};
+
+	template <class _Rep, class _Period>
+	inline co_sleep_awaiter co_sleep_for(NRP<io_event_loop> const& L, std::chrono::duration<_Rep, _Period> const& dur) {
+		return co_sleep_awaiter{ L, std::chrono::duration_cast<timer_duration_t>(dur), netp::OK };
+	}
+
+	//std::tuple<int, NRP<channel>>, resumed on the loop of the channel
+	inline co_channel_promise_awaiter co_dial(std::string const& dialurl, fn_channel_initializer_t const& initializer, NRP<socket_cfg> const& cfg = netp::make_ref<socket_cfg>()) {
+		return co_channel_promise_awaiter{ { socket::dial(dialurl, initializer, cfg), nullptr } };
+	}
+
+	//std::tuple<int, NRP<channel>> of the listener, accepted channels go to initializer
+	inline co_channel_promise_awaiter co_listen_on(std::string const& listenurl, fn_channel_initializer_t const& initializer, NRP<socket_cfg> const& cfg = netp::make_ref<socket_cfg>(), int backlog = NETP_DEFAULT_LISTEN_BACKLOG) {
+		return co_channel_promise_awaiter{ { socket::listen_on(listenurl, initializer, cfg, backlog), nullptr } };
+	}
+
+	/*
+	 * a pipeline tail for a coroutine to pull inbound packets from
+	 * 1, add it in the initializer, co_await read() on the loop of the channel
+	 * 2, read() resumes with netp::OK and a packet, or with the close reason once the queue is drained: E_CHANNEL_READ_CLOSED, E_CHANNEL_CLOSED
+	 * 3, one reader at a time, it is resumed inside the read event of the pipeline
+	 */
+	class co_reader final :
+		public channel_handler_abstract
+	{
+		typedef std::deque<NRP<packet>, netp::allocator<NRP<packet>>> packet_queue_t;
+
+		packet_queue_t m_queue;
+		std::coroutine_handle<> m_waiter;
+		int m_rt;
+
+		void _wake() {
+			if (m_waiter) {
+				const std::coroutine_handle<> h = m_waiter;
+				m_waiter = nullptr;
+				h.resume();
+			}
+		}
+
+	public:
+		co_reader() :
+			channel_handler_abstract(CH_ACTIVITY_READ_CLOSED | CH_ACTIVITY_CLOSED | CH_INBOUND_READ),
+			m_rt(netp::OK)
+		{}
+
+		void read(NRP<channel_handler_context> const& ctx, NRP<packet> const& income) override {
+			(void)ctx;
+			m_queue.push_back(income);
+			_wake();
+		}
+
+		void read_closed(NRP<channel_handler_context> const& ctx) override {
+			m_rt = netp::E_CHANNEL_READ_CLOSED;
+			_wake();
+			ctx->fire_read_closed();
+		}
+
+		void closed(NRP<channel_handler_context> const& ctx) override {
+			if (m_rt == netp::OK) {
+				m_rt = netp::E_CHANNEL_CLOSED;
+			}
+			_wake();
+			ctx->fire_closed();
+		}
+
+		struct read_awaiter {
+			NRP<co_reader> r;
+
+			bool await_ready() const noexcept { return !r->m_queue.empty() || r->m_rt != netp::OK; }
+			void await_suspend(std::coroutine_handle<> h) {
+				NETP_ASSERT(!r->m_waiter, "one reader at a time");
+				r->m_waiter = h;
+			}
+			std::tuple<int, NRP<packet>> await_resume() {
+				if (r->m_queue.empty()) {
+					return std::make_tuple(r->m_rt, NRP<packet>(nullptr));
+				}
+				NRP<packet> p = std::move(r->m_queue.front());
+				r->m_queue.pop_front();
+				return std::make_tuple(int(netp::OK), std::move(p));
+			}
+		};
+
+		read_awaiter read() {
+			return read_awaiter{ NRP<co_reader>(this) };
+		}
+	};
+}
+
+#endif //NETP_ENABLE_COROUTINE
+#endif
@@ -10,6 +10,7 @@
 #include <netp/singleton.hpp>
 #include <netp/promise.hpp>
 #include <netp/ipv4.hpp>
+#include <netp/ipv6.hpp>
 #include <netp/io_event.hpp>
 
 namespace netp {
@@ -18,6 +19,7 @@ namespace netp {
 	class timer;
 
 	typedef netp::promise< std::tuple<int, std::vector<netp::ipv4_t,netp::allocator<netp::ipv4_t>>>> dns_query_promise;
+	typedef netp::promise< std::tuple<int, std::vector<netp::ipv6_t,netp::allocator<netp::ipv6_t>>>> dns_query6_promise;
 
 	class dns_resolver;
 	struct async_dns_query
@@ -26,6 +28,12 @@ namespace netp {
 		NRP<dns_query_promise> dnsquery_p;
 	};
 
+	struct async_dns_query6
+	{
+		dns_resolver* dnsr;
+		NRP<dns_query6_promise> dnsquery_p;
+	};
+
 	class dns_resolver :
 		public netp::singleton<dns_resolver>
 	{
@@ -59,11 +67,14 @@ namespace netp {
 		void async_read_dns_reply(const int aiort_);
 
 		void _do_resolve(string_t const& domain, NRP<dns_query_promise> const& p);
+		void _do_resolve6(string_t const& domain, NRP<dns_query6_promise> const& p);
 
 	public:
 		dns_resolver();
 		NRP<netp::promise<int>> add_name_server(std::vector<std::string> const& ns);
 		NRP<dns_query_promise> resolve(string_t const& domain);
+		//AAAA query
+		NRP<dns_query6_promise> resolve6(string_t const& domain);
 	};
 }
 
@@ -22,7 +22,7 @@ _check_begin:
 					return ;
 				}
 
-				NRP<netp::packet> _in=netp::make_ref<netp::packet>(income->head(),m_fragment_maxium_size);
+				NRP<netp::packet> _in=income->slice(0,m_fragment_maxium_size);
 				income->skip(m_fragment_maxium_size);
 				ctx->fire_read(_in);
 				goto _check_begin;
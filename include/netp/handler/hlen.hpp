@@ -22,7 +22,7 @@ namespace netp { namespace handler {
 
 	public:
 		hlen() :
-			channel_handler_abstract(CH_INBOUND_READ| CH_OUTBOUND_WRITE),
+			channel_handler_abstract(CH_INBOUND_READ| CH_OUTBOUND_WRITE, sizeof(u32_t)),
 			m_state(parse_state::S_READ_LEN),
 			m_size(0),
 			m_tmp(nullptr)
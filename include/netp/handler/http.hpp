@@ -53,6 +53,7 @@ namespace netp { namespace handler {
 	private:
 		NRP<netp::http::parser> m_http_parser;
 		NRP<netp::channel_handler_context> m_ctx;
+		netp::size_t m_arena_bytes;
 
 		//for httpu
 		NRP<netp::http::message> m_message_tmp;
@@ -62,8 +63,10 @@ namespace netp { namespace handler {
 		void __unsetup_parser();
 		void __http_parse(NRP<netp::channel_handler_context> const& ctx, NRP<netp::packet> const& income);
 	public:
-		http() :
-			channel_handler_abstract(CH_ACTIVITY_CONNECTED|CH_ACTIVITY_CLOSED|CH_ACTIVITY_ERROR|CH_ACTIVITY_READ_CLOSED|CH_ACTIVITY_WRITE_CLOSED|CH_INBOUND_READ|CH_INBOUND_READ_FROM)
+		//arena_bytes for the messages parsed on this channel, 0 to disable
+		explicit http(netp::size_t arena_bytes = NETP_HTTP_ARENA_BYTES) :
+			channel_handler_abstract(CH_ACTIVITY_CONNECTED|CH_ACTIVITY_CLOSED|CH_ACTIVITY_ERROR|CH_ACTIVITY_READ_CLOSED|CH_ACTIVITY_WRITE_CLOSED|CH_INBOUND_READ|CH_INBOUND_READ_FROM),
+			m_arena_bytes(arena_bytes)
 		{}
 		~http() {}
 		void connected(NRP<netp::channel_handler_context> const& ctx) override ;
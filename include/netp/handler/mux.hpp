@@ -90,10 +90,12 @@ namespace netp { namespace handler {
 		u32_t m_rcv_data_inc; //rcv incred
 		u32_t m_snd_dynamic;
 		u32_t m_frame_data_size_max;
+		u32_t m_frame_headroom; //frame header and the transport pipeline below mux
 
 		NRP<netp::handler::mux> m_transport_mux;
 
 		std::queue<mux_stream_outbound_entry> m_outlets_q;
+		netp::size_t m_outlets_q_nbytes; //data bytes queued in m_outlets_q, for write watermark
 		std::queue<NRP<netp::packet>> m_incomes_buffer_q;
 
 		//steady_seconds_timepoint_t m_write_bytes_last_update;
@@ -207,6 +209,12 @@ namespace netp { namespace handler {
 			return m_snd_wnd;
 		}
 
+		inline NRP<packet> _make_frame_data(byte_t const* ptr, netp::size_t len) {
+			NRP<packet> fp = netp::make_ref<packet>(len, m_frame_headroom);
+			fp->write(ptr, len);
+			return fp;
+		}
+
 		//
 		inline void _write_data(NRP<packet> const& data, NRP<promise<int>> const& write_p) {
 			NETP_ASSERT(L->in_event_loop());
@@ -217,7 +225,7 @@ namespace netp { namespace handler {
 		
 			while (left>m_frame_data_size_max) {
 				m_outlets_q.push({
-					mux_stream_make_frame(m_id, FRAME_DATA, 0, netp::make_ref<packet>(data->head() + wlen, m_frame_data_size_max)),
+					mux_stream_make_frame(m_id, FRAME_DATA, 0, _make_frame_data(data->head() + wlen, m_frame_data_size_max)),
 					nullptr
 				});
 				wlen += m_frame_data_size_max;
@@ -225,10 +233,12 @@ namespace netp { namespace handler {
 			}
 
 			m_outlets_q.push({
-				mux_stream_make_frame(m_id, FRAME_DATA, 0, netp::make_ref<packet>(data->head() + wlen, left)),
+				mux_stream_make_frame(m_id, FRAME_DATA, 0, _make_frame_data(data->head() + wlen, left)),
 				write_p
 			});
+			m_outlets_q_nbytes += data->len();
 			ch_flush_impl();
+			ch_check_writability(m_outlets_q_nbytes);
 		}
 
 		inline void _write_frame(NRP<packet> const& frame, NRP<promise<int>> const& write_p) {
@@ -240,7 +250,7 @@ namespace netp { namespace handler {
 		}
 
 		void _do_ch_zero_outlets_check();
-		void _ch_flush_done(const int aiort_, u16_t wt);
+		void _ch_flush_done(const int aiort_, u16_t wt, u8_t flag);
 		void _do_ch_flush_impl() ;
 
 		void _ch_do_cancel_all_outlets() {
@@ -255,6 +265,7 @@ namespace netp { namespace handler {
 				}
 				m_outlets_q.pop();
 			}
+			m_outlets_q_nbytes = 0;
 		}
 
 		void _ch_do_close_connecting() {
@@ -422,14 +433,13 @@ namespace netp { namespace handler {
 		void ch_write_impl(NRP<packet> const& outlet, NRP<promise<int>> const& write_p) override {
 			NETP_ASSERT(L->in_event_loop());
 			NETP_ASSERT(outlet != nullptr);
-			NETP_ASSERT(write_p != nullptr);
 			NETP_ASSERT(outlet->len() > 0);
 
 			if (m_chflag &int(channel_flag::F_WRITE_SHUTDOWN)) {
-				write_p->set(netp::E_CHANNEL_WRITE_CLOSED);
+				ch_write_failed(write_p, netp::E_CHANNEL_WRITE_CLOSED);
 				return;
 			} else if (m_chflag &(int(channel_flag::F_WRITE_SHUTDOWN_PENDING) | int(channel_flag::F_CLOSE_PENDING) | int(channel_flag::F_CLOSING))) {
-				write_p->set(netp::E_CHANNEL_WRITE_SHUTDOWNING);
+				ch_write_failed(write_p, netp::E_CHANNEL_WRITE_SHUTDOWNING);
 				return;
 			} else {
 				_write_data(outlet, write_p);
@@ -505,9 +515,10 @@ namespace netp { namespace handler {
 		typedef std::unordered_map<mux_stream_id_t, NRP<mux_stream>, std::hash<mux_stream_id_t>,std::equal_to<mux_stream_id_t>, netp::allocator<std::pair<const mux_stream_id_t, NRP<mux_stream>>> > stream_map_t;
 		typedef std::pair<mux_stream_id_t, NRP<mux_stream> > stream_pair_t;
 
+		//set on the transport loop, nullptr if nobody waits for it
 		struct mux_outlet_quota_entry {
 			NRP<netp::packet> data;
-			NRP<netp::promise<int>> wp;
+			NRP<netp::loop_promise<int>> wp;
 			netp::size_t quota;
 		};
 
@@ -536,7 +547,7 @@ namespace netp { namespace handler {
 		void __do_mux_flush_done(const int rt);
 		void __do_mux_flush();
 
-		void __do_mux_write(NRP<netp::packet> const& outlet, NRP<netp::promise<int>> const& wp);
+		void __do_mux_write(NRP<netp::packet> const& outlet, NRP<netp::loop_promise<int>> const& wp);
 
 		std::tuple<int, NRP<mux_stream>> __do_open_stream(mux_stream_id_t id, channel_buf_cfg const& bcfg ) {
 			NETP_ASSERT(m_loop->in_event_loop());
@@ -135,7 +135,7 @@ namespace netp { namespace handler {
 
 			public:
 				websocket(websocket_type t) :
-					channel_handler_abstract(CH_ACTIVITY_CONNECTED|CH_ACTIVITY_CLOSED | CH_INBOUND_READ | CH_OUTBOUND_WRITE|CH_OUTBOUND_CLOSE),
+					channel_handler_abstract(CH_ACTIVITY_CONNECTED|CH_ACTIVITY_CLOSED | CH_INBOUND_READ | CH_OUTBOUND_WRITE|CH_OUTBOUND_CLOSE, 2+sizeof(u64_t)),
 					m_http_parser(nullptr),
 					m_type(t),
 					m_state(state::S_IDLE),
@@ -8,6 +8,7 @@
 #include <netp/core.hpp>
 #include <netp/packet.hpp>
 #include <netp/string.hpp>
+#include <netp/bump_arena.hpp>
 
 #define NETP_HTTP_CR	"\r"
 #define NETP_HTTP_LF	"\n"
@@ -80,13 +81,27 @@ namespace netp { namespace http {
 			return _key;
 		}
 
-		typedef std::unordered_map<typename netp::string_t, _H, std::hash<typename netp::string_t>, std::equal_to<typename netp::string_t>, netp::allocator<std::pair<const typename netp::string_t, _H>>>	header_map;
+		typedef std::unordered_map<typename netp::string_t, _H, std::hash<typename netp::string_t>, std::equal_to<typename netp::string_t>, netp::arena_allocator<std::pair<const typename netp::string_t, _H>>>	header_map;
 		typedef std::pair<netp::string_t, _H>	header_pair;
+		typedef std::list<netp::string_t, netp::arena_allocator<netp::string_t>> keys_order_t;
 
+		//the nodes go to the arena of the scope the header is created in, the strings do not
+		NRP<netp::bump_arena> arena;
 		header_map map;
-		std::list<netp::string_t> keys_order;
+		keys_order_t keys_order;
 
-		header() {}
+		void* operator new(std::size_t size) {
+			return netp::bump_arena::object_malloc(size);
+		}
+		void operator delete(void* p) {
+			netp::bump_arena::object_free(p);
+		}
+
+		header() :
+			arena((netp::bump_arena::current() != nullptr && !netp::bump_arena::current()->exhausted()) ? netp::bump_arena::current() : nullptr),
+			map(0, header_map::hasher(), header_map::key_equal(), header_map::allocator_type(arena.get())),
+			keys_order(keys_order_t::allocator_type(arena.get()))
+		{}
 		~header() {}
 		void reset() {
 			map.clear();
@@ -101,7 +116,7 @@ namespace netp { namespace http {
 			header_map::iterator it = map.find(H_key(field));
 			if (it != map.end()) {
 				const header_pair& HP = *it;
-				std::list<netp::string_t>::iterator&& it_key = std::find_if(keys_order.begin(), keys_order.end(), [name = HP.second.name](netp::string_t const& key) {
+				keys_order_t::iterator&& it_key = std::find_if(keys_order.begin(), keys_order.end(), [name = HP.second.name](netp::string_t const& key) {
 					return key == name;
 				});
 				NETP_ASSERT(it_key != keys_order.end());
@@ -173,6 +188,13 @@ namespace netp { namespace http {
 		NRP<header> H;
 		NRP<netp::packet> body;
 
+		void* operator new(std::size_t size) {
+			return netp::bump_arena::object_malloc(size);
+		}
+		void operator delete(void* p) {
+			netp::bump_arena::object_free(p);
+		}
+
 		void encode(NRP<netp::packet>& outp) const;
 
 		string_t dump() const {
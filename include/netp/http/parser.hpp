@@ -44,6 +44,7 @@ namespace netp { namespace http {
 		parser_cb on_chunk_complete;
 
 		NRP<netp::http::message> message_tmp;
+		NRP<netp::bump_arena> arena; //message_tmp and its header are allocated in it if set
 
 		last_header_element last_h;
 		string_t field_tmp;//for header field
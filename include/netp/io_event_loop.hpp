@@ -42,6 +42,9 @@ namespace netp {
 	struct poller_cfg {
 		u32_t ch_buf_size;
 		u32_t maxiumctx;
+		u32_t packet_pool_bytes; //buffer bytes retained by the packet_pool of each loop, 0 to disable
+		u32_t packet_arena_bytes; //huge page arena of the packet_pool of each loop, 0 to disable, needs packet_pool_bytes
+		u32_t recycle_objects; //objects cached per recycled type(promise, timer) by the recycler of each loop, 0 to disable
 	};
 	typedef std::function< NRP<io_event_loop>(io_poller_type t, poller_cfg const& cfg) > fn_poller_maker_t;
 
@@ -85,8 +88,9 @@ namespace netp {
 	#define NETP_DEBUG_TERMINATING
 #endif
 
+	//created, polled and erased on its loop only
 	struct watch_ctx :
-		public netp::ref_base
+		public netp::loop_ref_base
 	{
 		SOCKET fd;
 		fn_aio_event_t iofn[aio_flag::AIO_FLAG_MAX];//notify,read,write
@@ -137,14 +141,17 @@ namespace netp {
 		spin_mutex m_tq_mutex;
 		io_task_q_t m_tq_standby;
 		io_task_q_t m_tq;
+		io_task_q_t m_tq_defer; //run at the end of each iteration, in loop only
 		NRP<timer_broker> m_tb;
 
 		u8_t m_type;
 		std::atomic<bool> m_waiting;
 		std::atomic<u8_t> m_state;
+		long long m_poll_ts; //realtime clock in nanoseconds, the last poll returned
 
 		SOCKET m_signalfds[2];
 		NRP<netp::packet> m_channel_rcv_buf;
+		NRP<netp::packet> m_channel_rcv_spare; //the packet an adaptive read left unfilled
 		NRP<netp::thread> m_th;
 
 		//timer_timepoint_t m_wait_until;
@@ -166,7 +173,7 @@ namespace netp {
 			netp::timer_duration_t ndelay;
 			m_tb->expire(ndelay);
 			long long ndelayns = ndelay.count();
-			if (ndelayns == 0 || m_acts.size() != 0 ) {
+			if (ndelayns == 0 || m_acts.size() != 0 || m_tq_defer.size() != 0) {
 				return 0;
 			}
 
@@ -181,11 +188,21 @@ namespace netp {
 			return ndelayns;
 		}
 
+		void __allocator_decay_init();
+
 		virtual void init() {
+			if (m_cfg.packet_pool_bytes != 0) {
+				netp::tls_create<netp::packet_pool>(m_cfg.packet_pool_bytes, m_cfg.packet_arena_bytes);
+			}
+			if (m_cfg.recycle_objects != 0) {
+				netp::tls_create<netp::recycler>(m_cfg.recycle_objects);
+			}
 			m_channel_rcv_buf = netp::make_ref<netp::packet>(m_cfg.ch_buf_size);
 			m_tid = std::this_thread::get_id();
+			current() = this;
 			m_tb = netp::make_ref<timer_broker>();
 			_do_poller_init();
+			__allocator_decay_init();
 
 #ifdef NETP_DEBUG_TERMINATING
 			m_terminated = false;
@@ -203,10 +220,19 @@ namespace netp {
 
 			NETP_ASSERT(m_acts.size() == 0);
 			NETP_ASSERT(m_tq.empty());
+			NETP_ASSERT(m_tq_defer.empty());
 			NETP_ASSERT(m_tb->size() == 0);
 			m_tb = nullptr;
 			_do_poller_deinit();
 			NETP_ASSERT(m_ctxs.size() == 0);
+
+			//the rcv buf might be carved out of the arena
+			m_channel_rcv_buf = nullptr;
+			m_channel_rcv_spare = nullptr;
+			//packets released on this thread from now on go to netp::allocator
+			netp::tls_destroy<netp::packet_pool>();
+			netp::tls_destroy<netp::recycler>();
+			current() = nullptr;
 		}
 
 		inline void __do_execute_act() {
@@ -391,6 +417,23 @@ namespace netp {
 			}
 		}
 
+		inline void __do_execute_defer() {
+			std::size_t ss = m_tq_defer.size();
+			if (ss > 0) {
+				//task might defer again, run it in the next iteration
+				io_task_q_t tq;
+				std::swap(tq, m_tq_defer);
+				std::size_t i = 0;
+				while (i < ss) {
+					tq[i++]();
+				}
+				if (m_tq_defer.size() == 0 && ss <= 2048) {
+					tq.clear();
+					std::swap(tq, m_tq_defer);
+				}
+			}
+		}
+
 		void __run();
 		void __notify_terminating();
 		int __launch();
@@ -401,6 +444,7 @@ namespace netp {
 			m_type(u8_t(t)),
 			m_waiting(false),
 			m_state(u8_t(loop_state::S_IDLE)),
+			m_poll_ts(0),
 			m_signalfds{ (SOCKET)NETP_INVALID_SOCKET, (SOCKET)NETP_INVALID_SOCKET },
 			m_internal_ref_count(1),
 			m_cfg(cfg)
@@ -452,10 +496,27 @@ namespace netp {
 			schedule(f);
 		}
 
+		//run f at the end of the current iteration, after all the io events of this round have been dispatched
+		inline void defer(fn_io_event_task_t&& f) {
+			NETP_ASSERT(in_event_loop());
+			m_tq_defer.push_back(std::move(f));
+		}
+
+		inline void defer(fn_io_event_task_t const& f) {
+			NETP_ASSERT(in_event_loop());
+			m_tq_defer.push_back(f);
+		}
+
 		__NETP_FORCE_INLINE bool in_event_loop() const {
 			return std::this_thread::get_id() == m_tid;
 		}
 
+		//the loop running on this thread, nullptr for the other threads
+		static io_event_loop*& current() {
+			static __NETP_TLS io_event_loop* _current = nullptr;
+			return _current;
+		}
+
 		void launch(NRP<netp::timer> const& t , NRP<netp::promise<int>> const& lf = nullptr ) {
 			if(!in_event_loop()) {
 				schedule([L = NRP<io_event_loop>(this), t, lf]() {
@@ -513,6 +574,28 @@ namespace netp {
 			return m_channel_rcv_buf;
 		}
 
+		//a packet of right_capacity size for an adaptive read, the spare is reused if it's of the same pool size class
+		__NETP_FORCE_INLINE NRP<netp::packet> channel_rcv_packet(u32_t size) {
+			NETP_ASSERT(in_event_loop());
+			if (m_channel_rcv_spare != nullptr && m_channel_rcv_spare->left_right_capacity() >= size && m_channel_rcv_spare->left_right_capacity() < (size << 1)) {
+				return std::move(m_channel_rcv_spare);
+			}
+			return netp::make_ref<netp::packet>(size);
+		}
+
+		//at most one spare per loop
+		__NETP_FORCE_INLINE void channel_rcv_packet_unfilled(NRP<netp::packet>&& p) {
+			NETP_ASSERT(in_event_loop());
+			NETP_ASSERT(p->len() == 0);
+			m_channel_rcv_spare = std::move(p);
+		}
+
+		//the io events of this iteration were reported at
+		__NETP_FORCE_INLINE long long poll_timestamp() const {
+			NETP_ASSERT(in_event_loop());
+			return m_poll_ts;
+		}
+
 #ifdef NETP_IO_MODE_IOCP
 		virtual void do_iocp_call(iocp_action act, SOCKET fd, fn_overlapped_io_event const& fn_overlapped, fn_aio_event_t const& fn) {
 			NETP_ASSERT(m_type == T_IOCP);
@@ -526,7 +609,11 @@ namespace netp {
 #endif
 
 	protected:
-	#define __LOOP_EXIT_WAITING__() (m_waiting.store(false, std::memory_order_release))
+	#define __LOOP_EXIT_WAITING__() \
+		do { \
+			m_waiting.store(false, std::memory_order_release); \
+			m_poll_ts = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count(); \
+		} while (0)
 
 		virtual void _do_poller_init();
 		virtual void _do_poller_deinit() ;
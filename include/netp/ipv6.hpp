@@ -1,8 +1,30 @@
 #ifndef _NETP_IPV6_HPP
 #define _NETP_IPV6_HPP
 
+#include <vector>
+#include <netp/memory.hpp>
+
 namespace netp {
+	//network byte order, same layout as in6_addr
+	union ipv6_t {
+		u8_t byte[16];
+		u16_t u16[8];
+		u32_t u32[4];
+		u64_t u64[2];
+	};
+	static_assert(sizeof(ipv6_t) == 16, "ipv6_t size assert failed");
+
+	inline bool operator == (ipv6_t const& l, ipv6_t const& r) {
+		return l.u64[0] == r.u64[0] && l.u64[1] == r.u64[1];
+	}
+	inline bool operator != (ipv6_t const& l, ipv6_t const& r) {
+		return !(l == r);
+	}
+	inline bool ipv6_is_zero(ipv6_t const& ip) {
+		return ip.u64[0] == 0 && ip.u64[1] == 0;
+	}
 
+	typedef std::vector<ipv6_t, netp::allocator<ipv6_t>> vector_ipv6_t;
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -4,6 +4,7 @@
 
 #include <vector>
 #include <cstring>
+#include <atomic>
 #include <type_traits>
 
 #include <netp/core/compiler.hpp>
@@ -73,15 +74,106 @@ namespace netp {
 	};
 
 
+	//owner 0 is reserved for allocators that failed to get an owner slot, their blocks are cached by whichever thread frees them
+#define NETP_POOL_ALLOCATOR_OWNER_MAX (256)
+//blocks freed for the same remote owner are handed back in batches of this size
+#define NETP_POOL_ALLOCATOR_REMOTE_BATCH (32)
+
+//T6 and T7 have 15 slots, the others have 16
+#define NETP_POOL_ALLOCATOR_SLOT_MAX (16)
+
+	struct pool_align_allocator_class_stats {
+		u64_t size; //block size of the class
+		u64_t alloc;
+		u64_t hit; //served from the cache
+		u64_t free;
+		u64_t cached; //blocks cached now
+		u64_t cached_peak;
+	};
+
+	//a snapshot, peaks of an aggregated snapshot are the sum of the per thread peaks
+	struct pool_align_allocator_stats {
+		pool_align_allocator_class_stats classes[TABLE::T_COUNT][NETP_POOL_ALLOCATOR_SLOT_MAX];
+		u64_t cached_bytes[TABLE::T_COUNT];
+		u64_t cached_bytes_peak[TABLE::T_COUNT];
+
+		u64_t large_alloc; //out of the tables, straight to the system
+		u64_t large_free;
+		u64_t system_alloc; //cache misses and large blocks
+		u64_t system_free; //over the slot limit and large blocks
+
+		u64_t remote_free; //blocks freed on this thread that belong to another one
+		u64_t remote_flush; //batches handed back to their owners
+		u64_t remote_reclaim; //blocks handed back to this thread by others
+		u64_t trimmed; //cached blocks returned to the system by decay and trim
+
+		u32_t threads; //allocators in the snapshot, exited ones are counted in the totals only
+	};
+
+	//written by its owner thread only, a relaxed load/store pair instead of a locked rmw, read by anyone
+	struct pool_align_allocator_counter {
+		std::atomic<u64_t> n;
+		pool_align_allocator_counter() : n(0) {}
+		__NETP_FORCE_INLINE void add(u64_t v) { n.store(n.load(std::memory_order_relaxed) + v, std::memory_order_relaxed); }
+		__NETP_FORCE_INLINE void sub(u64_t v) { n.store(n.load(std::memory_order_relaxed) - v, std::memory_order_relaxed); }
+		__NETP_FORCE_INLINE void incre() { add(1); }
+		__NETP_FORCE_INLINE void decre() { sub(1); }
+		__NETP_FORCE_INLINE void peak(u64_t v) { if (v > n.load(std::memory_order_relaxed)) { n.store(v, std::memory_order_relaxed); } }
+		__NETP_FORCE_INLINE u64_t get() const { return n.load(std::memory_order_relaxed); }
+	};
+
 	//NOTE: if want to share address with different alignment in the same pool, we need to check alignment and do a re-align if necessary
+	/*
+	 * every block remembers the allocator(thread) it came from
+	 * 1, a block freed on its owner thread goes to the owner tables
+	 * 2, a block freed on another thread is pushed to a lock free stack of the owner, a loop thread batches them per owner and pushes full batches and the leftovers of each iteration, see flush_remote
+	 * 3, the owner reclaims its stack on a cache miss and on flush_remote, so blocks do not drift from producer threads to consumer threads
+	 * 4, an exiting thread flushes its batches in the tls destructor, the blocks left on its stack are reclaimed by the next allocator that takes its owner slot
+	 * 5, a slot remembers the least blocks it held since the last decay, half of those idle blocks are returned to the system on every decay, so a spike does not pin its peak working set for ever
+	 */
 	class pool_align_allocator {
+		struct remote_batch {
+			void* head;
+			void* tail;
+			u32_t count;
+			bool dirty; //listed in m_remote_dirty
+		};
 
 		std::vector<void*>* m_tables[TABLE::T_COUNT];
 		size_t m_entries_limit[TABLE::T_COUNT];
 
+		u8_t m_owner;
+		bool m_remote_batching; //set by threads that call flush_remote regularly
+		u32_t m_remote_dirty_count;
+		remote_batch m_remote_batches[NETP_POOL_ALLOCATOR_OWNER_MAX];
+		u8_t m_remote_dirty[NETP_POOL_ALLOCATOR_OWNER_MAX];
+
+		struct class_counters {
+			pool_align_allocator_counter alloc;
+			pool_align_allocator_counter hit;
+			pool_align_allocator_counter free;
+			pool_align_allocator_counter cached;
+			pool_align_allocator_counter cached_peak;
+		};
+		class_counters m_classes[TABLE::T_COUNT][NETP_POOL_ALLOCATOR_SLOT_MAX];
+		u32_t m_low_water[TABLE::T_COUNT][NETP_POOL_ALLOCATOR_SLOT_MAX]; //least cached blocks since the last decay
+		pool_align_allocator_counter m_cached_bytes[TABLE::T_COUNT];
+		pool_align_allocator_counter m_cached_bytes_peak[TABLE::T_COUNT];
+		pool_align_allocator_counter m_large_alloc;
+		pool_align_allocator_counter m_large_free;
+		pool_align_allocator_counter m_system_alloc;
+		pool_align_allocator_counter m_system_free;
+		pool_align_allocator_counter m_remote_free;
+		pool_align_allocator_counter m_remote_flush;
+		pool_align_allocator_counter m_remote_reclaim;
+		pool_align_allocator_counter m_trimmed;
+
 		void set_slot_entries_limit(size_t tidx, size_t capacity) {
 			m_entries_limit[tidx] = capacity;
 		}
+		void _entries_limit_update();
+		//free the n oldest blocks of the slot, return the bytes released
+		size_t _release_front(u8_t t, u8_t slot, size_t n);
 
 		void init_table_slot(u8_t t, u8_t slot, std::vector<void*>& slotv, size_t capacity);
 		void init_table(u8_t t, std::vector<void*>* table);
@@ -92,6 +184,26 @@ namespace netp {
 		void init();
 		void deinit();
 
+		inline void _cached_add(u8_t t, u8_t slot, size_t size) {
+			class_counters& c = m_classes[t][slot];
+			c.cached.incre();
+			c.cached_peak.peak(c.cached.get());
+			m_cached_bytes[t].add(size);
+			m_cached_bytes_peak[t].peak(m_cached_bytes[t].get());
+		}
+		inline void _cached_sub(u8_t t, u8_t slot, size_t size) {
+			m_classes[t][slot].cached.decre();
+			m_cached_bytes[t].sub(size);
+		}
+
+		//gauges are left out for an exited allocator
+		void _stats_accumulate(pool_align_allocator_stats& stats, bool with_gauges) const;
+
+		void _local_free(void* ptr, u8_t t, u8_t slot);
+		void _remote_free(void* ptr, u8_t owner);
+		void _remote_push(u8_t owner);
+		bool _remote_reclaim();
+
 		public:
 			pool_align_allocator();
 			~pool_align_allocator();
@@ -99,6 +211,33 @@ namespace netp {
 			void* malloc(size_t size, size_t alignment = NETP_DEFAULT_ALIGN);
 			void free(void* ptr);
 			void* realloc(void* ptr, size_t size, size_t alignment = NETP_DEFAULT_ALIGN);
+
+			//O(1), size is rounded up to the class, table is T_COUNT if size is out of the tables
+			static void size_class(size_t& size, u8_t& table, u8_t& slot);
+
+			//push the pending remote batches to their owners and reclaim ours, io_event_loop calls it every iteration
+			void flush_remote();
+			//batch remote frees until flush_remote, off by default, io_event_loop turns it on for its thread
+			void remote_batching(bool on);
+
+			//return half of the blocks idle since the last call to the system and apply the process limits, io_event_loop calls it on a timer, see cfg_decay_interval
+			void decay();
+			//return every cached block of this thread to the system, return the bytes released
+			size_t trim();
+			//ask every allocator to trim on its next flush_remote
+			static void trim_all();
+
+			//process wide, an allocator picks a new limit up on its next decay or trim, 0 for the default
+			static void cfg_entries_limit(u8_t t, u32_t limit);
+			//in milliseconds, 0 to disable, read by the loops at launch
+			static void cfg_decay_interval(u32_t interval);
+			static u32_t decay_interval();
+
+			//snapshot of this allocator, safe to call from any thread while it is alive
+			void stats(pool_align_allocator_stats& stats) const;
+			//snapshot summed over all the allocators of the process
+			static void stats_all(pool_align_allocator_stats& stats);
+			static void stats_dump(pool_align_allocator_stats const& stats);
 	};
 
 	using pool_align_allocator_t = pool_align_allocator;
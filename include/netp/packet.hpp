@@ -5,6 +5,7 @@
 #include <netp/core.hpp>
 #include <netp/smart_ptr.hpp>
 #include <netp/bytes_helper.hpp>
+#include <netp/packet_pool.hpp>
 
 #define PACK_MIN_LEFT_CAPACITY (64)
 #define PACK_MIN_RIGHT_CAPACITY (128-(PACK_MIN_LEFT_CAPACITY))
@@ -24,8 +25,32 @@ namespace netp {
 	 * 2, read forward only
 	 * 3, write_left from head, write from tail, 
 	 * 4, always read from head, 
+	 * 5, slice() makes a packet that shares the bytes by refcount, both packets are shared from then on, and a write outside of [head,tail) copies the bytes out first
 	 */
 
+	//realtime clock in nanoseconds
+	//kernel: the bytes were stamped by the kernel, 0 if the kernel did not attach one
+	//loop: the io event loop returned from the poll that reported them
+	struct packet_rx_timestamp {
+		long long kernel;
+		long long loop;
+	};
+
+	//owns the buffer of a sliced packet
+	struct packet_buffer_holder final :
+		public netp::ref_base
+	{
+		byte_t* buf;
+		netp::size_t capacity;
+		packet_buffer_holder(byte_t* buf_, netp::size_t capacity_) :
+			buf(buf_),
+			capacity(capacity_)
+		{}
+		~packet_buffer_holder() {
+			packet_pool::free_buf(buf, capacity);
+		}
+	};
+
 	template<class _ref_base, size_t LEFT_RESERVE, size_t DEFAULT_CAPACITY>
 	class cap_fix_packet:
 		public _ref_base
@@ -37,6 +62,7 @@ namespace netp {
 		netp::size_t	m_read_idx; //read index
 		netp::size_t	m_write_idx; //write index
 		netp::size_t	m_capacity; //the total buffer size
+		NRP<netp::ref_base> m_owner; //not nullptr if m_buffer is shared by slices
 
 		void _init_buffer(netp::size_t left, netp::size_t right, size_t alignment = NETP_DEFAULT_ALIGN) {
 			if (right == 0) {
@@ -45,15 +71,36 @@ namespace netp {
 			NETP_ASSERT((left + right) <= PACK_MAX_CAPACITY);
 			m_capacity = (left + right);
 			reset(left);
-			m_buffer = netp::allocator<byte_t>::malloc(sizeof(byte_t) * m_capacity, alignment );
+			m_buffer = packet_pool::malloc_buf(m_capacity, alignment);
 			NETP_ALLOC_CHECK(m_buffer, sizeof(byte_t) * m_capacity);
 		}
 
+#ifdef _NETP_NO_CXX11_TEMPLATE_VARIADIC_ARGS
+#define _ALLOCATE_MAKE_REF( \
+	TEMPLATE_LIST, PADDING_LIST, LIST, COMMA, X1, X2, X3, X4) \
+template<class _Ty COMMA LIST(_CLASS_TYPE)> \
+	friend ref_ptr<_Ty> make_ref(LIST(_TYPE_REFREF_ARG)) ;
+		_VARIADIC_EXPAND_0X(_ALLOCATE_MAKE_REF, , , , )
+#undef _ALLOCATE_MAKE_REF
+#else
+		template <class _Ref_ty, typename... _Args>
+		friend ref_ptr<_Ref_ty> make_ref(_Args&&... args);
+#endif
+
+		//objects and buffers are recycled by the packet_pool of the current thread
+		void* operator new(std::size_t size) {
+			return packet_pool::malloc_object(size);
+		}
+		void operator delete(void* p, std::size_t size) {
+			packet_pool::free_object(p, size);
+		}
+
 	public:
 		explicit cap_fix_packet(netp::size_t right_capacity = (DEFAULT_CAPACITY - LEFT_RESERVE), netp::size_t left_capacity = LEFT_RESERVE, size_t alignment = NETP_DEFAULT_ALIGN) :
 			m_buffer(nullptr),
 			m_read_idx(0),
-			m_write_idx(0)
+			m_write_idx(0),
+			m_owner(nullptr)
 		{
 			_init_buffer(left_capacity, right_capacity, alignment);
 		}
@@ -61,17 +108,42 @@ namespace netp {
 		explicit cap_fix_packet(void const* const buf, netp::size_t len, size_t alignment = NETP_DEFAULT_ALIGN) :
 			m_buffer(nullptr),
 			m_read_idx(0),
-			m_write_idx(0)
+			m_write_idx(0),
+			m_owner(nullptr)
 		{
 			_init_buffer(LEFT_RESERVE, len, alignment);
 			write(buf, len);
 		}
 
+		//a slice, [ptr, ptr+len) of a buffer held by owner, no left or right capacity
+		explicit cap_fix_packet(NRP<netp::ref_base> const& owner, byte_t* ptr, netp::size_t len) :
+			m_buffer(ptr),
+			m_read_idx(0),
+			m_write_idx(len),
+			m_capacity(len),
+			m_owner(owner)
+		{
+			NETP_ASSERT(owner != nullptr);
+		}
+
 		~cap_fix_packet() {
-			netp::allocator<byte_t>::free(m_buffer);
+			if (m_owner == nullptr) {
+				packet_pool::free_buf(m_buffer, m_capacity);
+			}
 		}
 
+		__NETP_FORCE_INLINE bool is_shared() const { return m_owner != nullptr; }
+
+		//{0,0} but for the packets read by a socket with TIMESTAMPING_RX, the copies and slices do not keep it
+		virtual packet_rx_timestamp rx_timestamp() const { return { 0,0 }; }
+
 		__NETP_FORCE_INLINE void reset(netp::size_t left_capacity = LEFT_RESERVE) {
+			//the bytes might be referenced by another slice, start over with a buffer of our own
+			if (NETP_UNLIKELY(m_owner != nullptr)) {
+				m_owner = nullptr;
+				_init_buffer(left_capacity, 0);
+				return;
+			}
 #ifdef _DEBUG
 			NETP_ASSERT(left_capacity < m_capacity);
 #endif
@@ -118,6 +190,7 @@ namespace netp {
 		const inline netp::size_t left_right_capacity() const { return (NETP_UNLIKELY(m_buffer == nullptr)) ? 0 : m_capacity - m_write_idx; }
 
 		void write_left(byte_t const* buf, netp::size_t len) {
+			NETP_ASSERT(m_owner == nullptr);
 			NETP_ASSERT(m_read_idx >= len);
 			m_read_idx -= len;
 			::memcpy(m_buffer + m_read_idx, buf, len);
@@ -126,6 +199,7 @@ namespace netp {
 		//would result in memmove if left space is not enough
 		template <class T, class endian = netp::bytes_helper::big_endian>
 		inline void write_left(T t) {
+			NETP_ASSERT(m_owner == nullptr);
 			NETP_ASSERT( m_read_idx >= sizeof(T) );
 			m_read_idx -= sizeof(T);
 			netp::size_t wnbytes = endian::write_impl(t, (m_buffer + m_read_idx));
@@ -216,14 +290,39 @@ namespace netp {
 		typedef cap_fix_packet<_ref_base, LEFT_RESERVE, DEFAULT_CAPACITY> cap_fix_packet_t;
 		typedef cap_expandable_packet<_ref_base, LEFT_RESERVE, DEFAULT_CAPACITY> expandable_packet_t;
 	private:
+		//copy [head,tail) into a buffer of our own, the shared one is left to the other slices
+		void _unshare__(netp::size_t left, netp::size_t right) {
+			NETP_ASSERT(cap_fix_packet_t::m_owner != nullptr);
+			const netp::size_t _len = cap_fix_packet_t::len();
+			NETP_ASSERT((left + _len + right) <= PACK_MAX_CAPACITY);
+			netp::size_t _capacity = left + _len + right;
+			byte_t* _newbuffer = packet_pool::malloc_buf(_capacity);
+			NETP_ALLOC_CHECK(_newbuffer, _capacity);
+			if (_len > 0) {
+				::memcpy(_newbuffer + left, cap_fix_packet_t::head(), _len);
+			}
+			cap_fix_packet_t::m_buffer = _newbuffer;
+			cap_fix_packet_t::m_capacity = _capacity;
+			cap_fix_packet_t::m_read_idx = left;
+			cap_fix_packet_t::m_write_idx = left + _len;
+			cap_fix_packet_t::m_owner = nullptr;
+		}
+
 		inline void _extend_leftbuffer_capacity__(netp::size_t increment = PACK_INCREMENT_SIZE) {
+			if (cap_fix_packet_t::m_owner != nullptr) {
+				_unshare__(increment + LEFT_RESERVE, cap_fix_packet_t::left_right_capacity());
+				return;
+			}
 
 			NETP_ASSERT(cap_fix_packet_t::m_buffer != nullptr);
 			NETP_ASSERT(((cap_fix_packet_t::m_capacity + increment) <= PACK_MAX_CAPACITY));
-			cap_fix_packet_t::m_capacity += increment;
-			byte_t* _newbuffer = netp::allocator<byte_t>::realloc(cap_fix_packet_t::m_buffer, cap_fix_packet_t::m_capacity);
-			NETP_ALLOC_CHECK(_newbuffer, cap_fix_packet_t::m_capacity);
+			netp::size_t _capacity = cap_fix_packet_t::m_capacity + increment;
+			byte_t* _newbuffer = packet_pool::realloc_buf(cap_fix_packet_t::m_buffer, cap_fix_packet_t::m_capacity, _capacity);
+			NETP_ALLOC_CHECK(_newbuffer, _capacity);
+			//the rounding up of the class goes to the left as well
+			increment = _capacity - cap_fix_packet_t::m_capacity;
 			cap_fix_packet_t::m_buffer = _newbuffer;
+			cap_fix_packet_t::m_capacity = _capacity;
 
 			const netp::size_t new_left = cap_fix_packet_t::m_read_idx + increment;
 			netp::size_t _len = cap_fix_packet_t::len();
@@ -235,13 +334,18 @@ namespace netp {
 		}
 
 		inline void _extend_rightbuffer_capacity__(netp::size_t increment = PACK_INCREMENT_SIZE) {
+			if (cap_fix_packet_t::m_owner != nullptr) {
+				_unshare__(LEFT_RESERVE, cap_fix_packet_t::left_right_capacity() + increment);
+				return;
+			}
 			NETP_ASSERT(cap_fix_packet_t::m_capacity != 0);
 			NETP_ASSERT(cap_fix_packet_t::m_buffer != nullptr);
 			NETP_ASSERT((cap_fix_packet_t::m_capacity + increment) <= PACK_MAX_CAPACITY);
-			cap_fix_packet_t::m_capacity += increment;
-			byte_t* _newbuffer = netp::allocator<byte_t>::realloc(cap_fix_packet_t::m_buffer, cap_fix_packet_t::m_capacity, NETP_DEFAULT_ALIGN);
-			NETP_ALLOC_CHECK(_newbuffer, cap_fix_packet_t::m_capacity);
+			netp::size_t _capacity = cap_fix_packet_t::m_capacity + increment;
+			byte_t* _newbuffer = packet_pool::realloc_buf(cap_fix_packet_t::m_buffer, cap_fix_packet_t::m_capacity, _capacity);
+			NETP_ALLOC_CHECK(_newbuffer, _capacity);
 			cap_fix_packet_t::m_buffer = _newbuffer;
+			cap_fix_packet_t::m_capacity = _capacity;
 		}
 
 	public:
@@ -255,7 +359,25 @@ namespace netp {
 		{
 		}
 
+		explicit cap_expandable_packet(NRP<netp::ref_base> const& owner, byte_t* ptr, netp::size_t len) :
+			cap_fix_packet_t(owner, ptr, len)
+		{
+		}
+
+		//[head+off, head+off+len) without copy, the bytes are kept alive by refcount
+		NRP<expandable_packet_t> slice(netp::size_t off, netp::size_t len) {
+			NETP_ASSERT((off + len) <= cap_fix_packet_t::len());
+			if (cap_fix_packet_t::m_owner == nullptr) {
+				cap_fix_packet_t::m_owner = netp::make_ref<packet_buffer_holder>(cap_fix_packet_t::m_buffer, cap_fix_packet_t::m_capacity);
+			}
+			return netp::make_ref<expandable_packet_t>(cap_fix_packet_t::m_owner, cap_fix_packet_t::head() + off, len);
+		}
+
 		void write_left( byte_t const* buf, netp::size_t len ) {
+			//the bytes on the left might be part of another slice
+			if (NETP_UNLIKELY(cap_fix_packet_t::m_owner != nullptr)) {
+				_unshare__(len + LEFT_RESERVE, cap_fix_packet_t::left_right_capacity());
+			}
 			while ( NETP_UNLIKELY(len > (cap_fix_packet_t::left_left_capacity())) ) {
 				_extend_leftbuffer_capacity__( ((len - (cap_fix_packet_t::left_left_capacity() ))<<1));
 			}
@@ -270,6 +392,9 @@ namespace netp {
 		//would result in memmove if left space is not enough
 		template <class T, class endian=netp::bytes_helper::big_endian>
 		inline void write_left(T t) {
+			if (NETP_UNLIKELY(cap_fix_packet_t::m_owner != nullptr)) {
+				_unshare__(sizeof(T) + LEFT_RESERVE, cap_fix_packet_t::left_right_capacity());
+			}
 			while ( NETP_UNLIKELY(sizeof(T) > (cap_fix_packet_t::left_left_capacity())) ) {
 				_extend_leftbuffer_capacity__();
 			}
@@ -328,5 +453,25 @@ namespace netp {
 	};
 
 	using packet = cap_expandable_packet<netp::ref_base, PACK_MIN_LEFT_CAPACITY, PACK_DEFAULT_CAPACITY>;
+
+	//a packet read with its receive timestamp, it goes through the pipeline as a packet
+	class rx_stamped_packet final :
+		public packet
+	{
+		packet_rx_timestamp m_rx_ts;
+	public:
+		explicit rx_stamped_packet(netp::size_t right_capacity) :
+			packet(right_capacity),
+			m_rx_ts({ 0,0 })
+		{}
+
+		explicit rx_stamped_packet(void const* const buf, netp::size_t len, packet_rx_timestamp const& ts) :
+			packet(buf, len),
+			m_rx_ts(ts)
+		{}
+
+		__NETP_FORCE_INLINE void set_rx_timestamp(packet_rx_timestamp const& ts) { m_rx_ts = ts; }
+		packet_rx_timestamp rx_timestamp() const override { return m_rx_ts; }
+	};
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,150 @@
+#ifndef _NETP_PACKET_POOL_HPP_
+#define _NETP_PACKET_POOL_HPP_
+
+#include <vector>
+#include <atomic>
+
+#include <netp/core.hpp>
+#include <netp/memory.hpp>
+#include <netp/tls.hpp>
+
+//buffer classes, 4 per power of two in [128, 256K]
+#define NETP_PACKET_POOL_BUF_CLASS_MIN (128)
+#define NETP_PACKET_POOL_BUF_CLASS_MAX (256*1024)
+#define NETP_PACKET_POOL_BUF_CLASS_COUNT (45)
+
+//packet objects are allocated in blocks of this size, sizeof(packet) is 56 on x64
+#define NETP_PACKET_POOL_OBJECT_SIZE (64)
+#define NETP_PACKET_POOL_OBJECT_MAX (4096)
+
+#define NETP_PACKET_POOL_DEFAULT_BYTES (1024*1024*2)
+
+//arenas in the process, one per loop at most
+#define NETP_PACKET_ARENA_MAX (64)
+#define NETP_PACKET_ARENA_PAGE_SIZE (1024*1024*2)
+
+namespace netp {
+
+	struct packet_pool_stats {
+		u64_t object_hit;
+		u64_t object_miss;
+		u64_t buf_hit;
+		u64_t buf_miss;
+		u64_t buf_drop; //returned but not retained, out of class or over the limit
+		u32_t objects; //retained
+		u32_t bufs; //retained
+		u64_t bytes; //retained, arena buffers are not counted
+		u64_t arena_bytes; //mapped
+		u64_t arena_carved; //bytes carved out so far
+		u64_t arena_remote; //arena buffers handed back by other threads
+		u32_t arena_huge_page; //1 if the arena is backed by MAP_HUGETLB, 0 for 4K pages advised for THP
+	};
+
+	//to skip the arena lookup in free_buf if no arena has been mapped
+	extern std::atomic<u32_t> __packet_arena_count;
+
+	/*
+	 * free lists of packet objects and buffers of the current thread
+	 * 1, io_event_loop creates one in its thread if poller_cfg::packet_pool_bytes is not 0, other threads have none and go to netp::allocator directly
+	 * 2, a packet released on another thread is returned to the pool of that thread, or to netp::allocator, a pool is never touched by another thread
+	 * 3, buffer capacity is rounded up to its class, so it can be reused by any packet of the same class
+	 * 4, with arena_bytes, buffers are carved out of a prefaulted mapping of 2M huge pages (THP if MAP_HUGETLB fails) when the free list is empty
+	 *	arena buffers never go back to the system, a buffer freed on another thread is pushed back to the arena owner like pool_align_allocator does
+	 *	the mapping is released with the pool if every buffer is back, it is kept until the process exits otherwise
+	 */
+	class packet_pool final {
+		std::vector<void*> m_objects;
+		std::vector<byte_t*> m_bufs[NETP_PACKET_POOL_BUF_CLASS_COUNT];
+		netp::size_t m_max_bytes;
+		packet_pool_stats m_stats;
+
+		int m_arena; //index in the arena registry, -1 for none
+		byte_t* m_arena_base;
+		u64_t m_arena_carved_count;
+
+		NETP_DECLARE_NONCOPYABLE(packet_pool)
+
+		void _arena_init(netp::size_t arena_bytes);
+		void _arena_deinit();
+		bool _arena_reclaim();
+		byte_t* _arena_carve(netp::size_t class_size);
+		void _arena_free(byte_t* p, netp::size_t capacity);
+		static int _arena_of(byte_t const* p);
+		static void _arena_remote_free(int arena, byte_t* p, netp::size_t capacity);
+
+	public:
+		packet_pool(netp::size_t max_bytes, netp::size_t arena_bytes = 0);
+		~packet_pool();
+
+		packet_pool_stats const& stats() const { return m_stats; }
+
+		//the smallest class that fits n, -1 if n is out of range
+		static int buf_class(netp::size_t n, netp::size_t& class_size);
+
+		void* object_malloc();
+		void object_free(void* p);
+		byte_t* buf_malloc(int cls, netp::size_t class_size);
+		bool buf_free(byte_t* p, netp::size_t capacity);
+
+		inline static void* malloc_object(std::size_t size) {
+			if (size > NETP_PACKET_POOL_OBJECT_SIZE) {
+				return netp::allocator<char>::malloc(size);
+			}
+			packet_pool* pool = netp::tls_get<packet_pool>();
+			return pool != nullptr ? pool->object_malloc() : netp::allocator<char>::malloc(NETP_PACKET_POOL_OBJECT_SIZE);
+		}
+
+		inline static void free_object(void* p, std::size_t size) {
+			if (p == nullptr) {
+				return;
+			}
+			packet_pool* pool;
+			if (size <= NETP_PACKET_POOL_OBJECT_SIZE && (pool = netp::tls_get<packet_pool>()) != nullptr) {
+				pool->object_free(p);
+				return;
+			}
+			netp::allocator<char>::free((char*)p);
+		}
+
+		//capacity might be rounded up
+		inline static byte_t* malloc_buf(netp::size_t& capacity, size_t alignment = NETP_DEFAULT_ALIGN) {
+			netp::size_t class_size;
+			int cls;
+			if (alignment != NETP_DEFAULT_ALIGN || (cls = buf_class(capacity, class_size)) < 0) {
+				return netp::allocator<byte_t>::malloc(capacity, alignment);
+			}
+			capacity = class_size;
+			packet_pool* pool = netp::tls_get<packet_pool>();
+			return pool != nullptr ? pool->buf_malloc(cls, class_size) : netp::allocator<byte_t>::malloc(class_size, NETP_DEFAULT_ALIGN);
+		}
+
+		//capacity might be rounded up, [p, p+old_capacity) is copied
+		inline static byte_t* realloc_buf(byte_t* p, netp::size_t old_capacity, netp::size_t& capacity) {
+			NETP_ASSERT(capacity >= old_capacity);
+			byte_t* n = malloc_buf(capacity);
+			if (n != nullptr && p != nullptr) {
+				::memcpy(n, p, old_capacity);
+				free_buf(p, old_capacity);
+			}
+			return n;
+		}
+
+		inline static void free_buf(byte_t* p, netp::size_t capacity) {
+			if (p == nullptr) {
+				return;
+			}
+			packet_pool* pool = netp::tls_get<packet_pool>();
+			if (NETP_UNLIKELY(__packet_arena_count.load(std::memory_order_relaxed) != 0)) {
+				const int arena = _arena_of(p);
+				if (arena != -1) {
+					(pool != nullptr && pool->m_arena == arena) ? pool->_arena_free(p, capacity) : _arena_remote_free(arena, p, capacity);
+					return;
+				}
+			}
+			if (pool == nullptr || !pool->buf_free(p, capacity)) {
+				netp::allocator<byte_t>::free(p);
+			}
+		}
+	};
+}
+#endif
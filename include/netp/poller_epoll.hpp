@@ -141,8 +141,15 @@ namespace netp {
 						int getrt = ::getsockopt(ctx->fd, SOL_SOCKET, SO_ERROR, (char*)&ec, &optlen);
 						if (getrt == -1) {
 							ec = netp_socket_get_last_errno();
+						} else if (ec == netp::OK) {
+							//no pending error but the error queue (tx timestamps), the notify fn drains it, with or without a reader
+							if ((events&EPOLLHUP) != 0) {
+								ec = netp::E_SOCKET_EPOLLHUP;
+							} else {
+								NETP_ASSERT(ctx->iofn[aio_flag::AIO_NOTIFY] != nullptr);
+								ctx->iofn[aio_flag::AIO_NOTIFY](netp::E_SOCKET_ERRQUEUE_READY);
+							}
 						} else {
-							NETP_ASSERT(ec != netp::OK);
 							ec = NETP_NEGATIVE(ec);
 						}
 					} else if ((events&EPOLLHUP) != 0) {
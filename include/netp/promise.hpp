@@ -5,6 +5,7 @@
 
 #include <netp/core.hpp>
 #include <netp/smart_ptr.hpp>
+#include <netp/recycler.hpp>
 #include <netp/event_broker.hpp>
 
 #include <netp/condition.hpp>
@@ -68,6 +69,9 @@ namespace netp {
 		int m_waiter;
 
 	public:
+		//one for every write, recycled by the loop
+		NETP_RECYCLE_OBJECT(promise_t, "promise")
+
 		promise():
 			m_state(u8_t(promise_state::S_IDLE)),
 			m_v(V()),
@@ -202,5 +206,105 @@ namespace netp {
 			NETP_THROW("set failed: DO NOT set twice on a same promise");
 		}
 	};
+
+	/*
+	 * a promise that is set and consumed on one io_event_loop
+	 * 1, no lock and no cond var, the first callee is stored inline, the others go to a vector
+	 * 2, no blocking get, a thread other than the loop waits on share(), a promise<V> set together with this one
+	 * 3, a loop_ref_base, NETP_DEBUG_LOOP_CONFINED_REF asserts on a grab/drop from another thread
+	 */
+	template <typename V>
+	class loop_promise final :
+		public loop_ref_base
+	{
+		typedef loop_promise<V> loop_promise_t;
+		typedef std::function<void(V const&)> fn_promise_callee_t;
+		typedef std::vector<fn_promise_callee_t, netp::allocator<fn_promise_callee_t>> fn_promise_callee_vector_t;
+
+		u8_t m_state;
+		V m_v;
+		fn_promise_callee_t m_callee;
+		fn_promise_callee_vector_t m_callees;
+
+		void _invoke() {
+			if (m_callee != nullptr) {
+				fn_promise_callee_t callee(std::move(m_callee));
+				m_callee = nullptr;
+				callee(m_v);
+			}
+			for (::size_t i = 0; i < m_callees.size(); ++i) {
+				m_callees[i](m_v);
+			}
+			m_callees.clear();
+		}
+
+	public:
+		NETP_RECYCLE_OBJECT(loop_promise_t, "loop_promise")
+
+		loop_promise() :
+			m_state(u8_t(promise_state::S_IDLE)),
+			m_v(V())
+		{}
+
+		inline bool is_idle() const { return m_state == u8_t(promise_state::S_IDLE); }
+		inline bool is_done() const { return m_state == u8_t(promise_state::S_DONE); }
+		inline bool is_cancelled() const { return m_state == u8_t(promise_state::S_CANCELLED); }
+
+		//never blocks
+		inline V const& get() const {
+			NETP_ASSERT(is_done());
+			return m_v;
+		}
+
+		template<class _callable
+			, class = typename std::enable_if<std::is_convertible<_callable, fn_promise_callee_t>::value>::type>
+		void if_done(_callable&& callee) {
+			if (m_state != u8_t(promise_state::S_IDLE)) {
+				callee(m_v);
+				return;
+			}
+			if (m_callee == nullptr) {
+				m_callee = std::forward<_callable>(callee);
+			} else {
+				m_callees.emplace_back(std::forward<_callable>(callee));
+			}
+		}
+
+		bool cancel() {
+			if (m_state != u8_t(promise_state::S_IDLE)) {
+				return false;
+			}
+			m_state = u8_t(promise_state::S_CANCELLED);
+			_invoke();
+			return true;
+		}
+
+		void set(V const& v) {
+			if (m_state != u8_t(promise_state::S_IDLE)) {
+				NETP_THROW("set failed: DO NOT set twice on a same promise");
+			}
+			m_state = u8_t(promise_state::S_DONE);
+			m_v = v;
+			_invoke();
+		}
+
+		void set(V&& v) {
+			if (m_state != u8_t(promise_state::S_IDLE)) {
+				NETP_THROW("set failed: DO NOT set twice on a same promise");
+			}
+			m_state = u8_t(promise_state::S_DONE);
+			m_v = std::forward<V>(v);
+			_invoke();
+		}
+
+		//for a thread other than the loop to wait on, called on the loop
+		NRP<promise<V>> share() {
+			NRP<promise<V>> p = netp::make_ref<promise<V>>();
+			if_done([p](V const& v) {
+				p->set(v);
+			});
+			return p;
+		}
+	};
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,138 @@
+#ifndef _NETP_RECYCLER_HPP_
+#define _NETP_RECYCLER_HPP_
+
+#include <atomic>
+
+#include <netp/core.hpp>
+#include <netp/memory.hpp>
+#include <netp/tls.hpp>
+
+//recycled name and size pairs in the process, types registered over it go to netp::allocator
+#define NETP_RECYCLER_TYPE_MAX (32)
+//name<size> as type_name reports it
+#define NETP_RECYCLER_TYPE_NAME_MAX (48)
+//objects cached per type by each loop
+#define NETP_RECYCLER_DEFAULT_OBJECTS (1024)
+
+//in the class body of a hot ref type, make_ref takes its memory from the recycler of the current thread
+#define NETP_RECYCLE_OBJECT(T, name) \
+	void* operator new(std::size_t size) { \
+		return netp::recycler::malloc_object<T>(name, size); \
+	} \
+	void operator delete(void* p, std::size_t size) { \
+		netp::recycler::free_object<T>(name, p, size); \
+	}
+
+namespace netp {
+
+	struct recycler_stats {
+		u64_t hit;
+		u64_t miss;
+		u64_t recycled; //put back to the free list
+		u64_t drop; //freed to netp::allocator, the free list is full
+		u32_t objects; //retained
+	};
+
+	/*
+	 * type specific free lists of object memory of the current thread
+	 * 1, io_event_loop creates one in its thread if poller_cfg::recycle_objects is not 0, other threads have none and go to netp::allocator directly
+	 * 2, a type is registered on its first malloc_object, types of the same name and sizeof(T) share one list, subclasses of other sizes go to netp::allocator
+	 * 3, an object freed on another thread goes to the list of that thread, the block is memory of netp::allocator, so it does not matter which list it is in
+	 * 4, construction and destruction still run on every make_ref and last drop, only the round trip to the allocator is saved
+	 */
+	class recycler final {
+		struct node {
+			node* next;
+		};
+
+		struct slot {
+			node* head;
+			recycler_stats stats;
+		};
+
+		slot m_slots[NETP_RECYCLER_TYPE_MAX];
+		u32_t m_max;
+
+		NETP_DECLARE_NONCOPYABLE(recycler)
+
+		template <class T>
+		struct type_id {
+			inline static u32_t get(char const* name) {
+				static const u32_t _id = recycler::register_type(name, sizeof(T));
+				return _id;
+			}
+		};
+
+	public:
+		explicit recycler(u32_t max);
+		~recycler();
+
+		//the id of the name and size pair, NETP_RECYCLER_TYPE_MAX if the registry is full
+		static u32_t register_type(char const* name, netp::size_t size);
+		static u32_t type_count();
+		static char const* type_name(u32_t id);
+		static netp::size_t type_size(u32_t id);
+
+		inline recycler_stats const& stats(u32_t id) const {
+			NETP_ASSERT(id < NETP_RECYCLER_TYPE_MAX);
+			return m_slots[id].stats;
+		}
+
+		inline void* object_malloc(u32_t id, netp::size_t size) {
+			slot& s = m_slots[id];
+			if (s.head != nullptr) {
+				node* n = s.head;
+				s.head = n->next;
+				++s.stats.hit;
+				--s.stats.objects;
+				return n;
+			}
+			++s.stats.miss;
+			return netp::allocator<char>::malloc(size);
+		}
+
+		inline void object_free(u32_t id, void* p) {
+			slot& s = m_slots[id];
+			if (s.stats.objects >= m_max) {
+				++s.stats.drop;
+				netp::allocator<char>::free((char*)p);
+				return;
+			}
+			node* n = (node*)p;
+			n->next = s.head;
+			s.head = n;
+			++s.stats.recycled;
+			++s.stats.objects;
+		}
+
+		template <class T>
+		inline static void* malloc_object(char const* name, std::size_t size) {
+			static_assert(sizeof(T) >= sizeof(node), "recycled type too small");
+			recycler* r;
+			if (size == sizeof(T) && (r = netp::tls_get<recycler>()) != nullptr) {
+				const u32_t id = type_id<T>::get(name);
+				if (id != NETP_RECYCLER_TYPE_MAX) {
+					return r->object_malloc(id, size);
+				}
+			}
+			return netp::allocator<char>::malloc(size);
+		}
+
+		template <class T>
+		inline static void free_object(char const* name, void* p, std::size_t size) {
+			if (p == nullptr) {
+				return;
+			}
+			recycler* r;
+			if (size == sizeof(T) && (r = netp::tls_get<recycler>()) != nullptr) {
+				const u32_t id = type_id<T>::get(name);
+				if (id != NETP_RECYCLER_TYPE_MAX) {
+					r->object_free(id, p);
+					return;
+				}
+			}
+			netp::allocator<char>::free((char*)p);
+		}
+	};
+}
+#endif
@@ -8,7 +8,7 @@ namespace netp {
 	template <class _ItemT>
 	class ringbuffer {
 
-		NETP_DECLARE_NONCOPYABLE(ringbuffer<_ItemT> ) ;
+		NETP_DECLARE_NONCOPYABLE(ringbuffer) ;
 
 		typedef _ItemT _MyItemT;
 
@@ -11,6 +11,8 @@
 #include <netp/channel_handler.hpp>
 #include <netp/channel.hpp>
 #include <netp/socket.hpp>
+#include <netp/connection_pool.hpp>
+#include <netp/bump_arena.hpp>
 
 namespace netp {
 	#define __NETP_RPC_DEFAULT_TIMEOUT std::chrono::seconds(30)
@@ -60,6 +62,13 @@ namespace netp {
 			data(data_)
 		{}
 
+		void* operator new(std::size_t size) {
+			return netp::bump_arena::object_malloc(size);
+		}
+		void operator delete(void* p) {
+			netp::bump_arena::object_free(p);
+		}
+
 		void encode(NRP<netp::packet>& outp);
 		static int from_packet(NRP<netp::packet> const& inpack, NRP<rpc_message>& in_rpcm);
 	};
@@ -85,6 +94,13 @@ namespace netp {
 		NRP<netp::rpc_call_promise> callp;
 		NRP<netp::rpc_push_promise> pushp;
 		timer_timepoint_t tp_timeout;
+
+		void* operator new(std::size_t size) {
+			return netp::bump_arena::object_malloc(size);
+		}
+		void operator delete(void* p) {
+			netp::bump_arena::object_free(p);
+		}
 	};
 
 	enum rpc_write_state {
@@ -125,6 +141,8 @@ namespace netp {
 		NRP<promise<int>> m_close_promise;
 		NRP<netp::channel_handler_context> m_ctx;
 		NRP<netp::ref_base> m_rpc_ctx;
+		//messages of the calls in and out of this rpc, see NETP_RPC_ARENA_BYTES
+		NRP<netp::bump_arena> m_arena;
 
 		rpc_message_reply_queue_t m_reply_q;
 
@@ -246,6 +264,12 @@ namespace netp {
 			return rpc::dial(host, nullptr);
 		}
 
+		//the initializer of a connection_pool for rpc, the rpc is set as the ctx of the channel
+		static netp::fn_channel_initializer_t pool_initializer(netp::fn_channel_initializer_t const& fn_ch_initializer = nullptr);
+		//an rpc over a channel of pool, its cfg->initializer must be rpc::pool_initializer()
+		//hand it back by pool->release(rpc->channel()) once its calls are done, on_push and bindcall stay installed for the next user
+		static NRP<rpc_dial_promise> acquire(NRP<connection_pool> const& pool, std::string const& url);
+
 		static NRP<rpc_listen_promise> listen(std::string const& host, fn_rpc_activity_notify_t const& fn_accepted, netp::fn_channel_initializer_t const& fn_ch_initializer, NRP<socket_cfg> const& cfg);
 
 		static NRP<rpc_listen_promise> listen(std::string const& host, fn_rpc_activity_notify_t const& fn_accepted, netp::fn_channel_initializer_t const& fn_ch_initializer) {
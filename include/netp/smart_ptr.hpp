@@ -2,6 +2,7 @@
 #define _NETP_SMARTPTR_HPP_
 
 #include <netp/core/compiler.hpp>
+#include <netp/core/config.hpp>
 #include <netp/exception.hpp>
 #include <netp/memory.hpp>
 #include <netp/funcs.hpp>
@@ -579,6 +580,7 @@ public:
 #define NWP netp::weak_ptr
 
 #include <type_traits>
+#include <thread>
 
 namespace netp {
 
@@ -626,7 +628,33 @@ namespace netp {
 		}
 		__NETP_FORCE_INLINE long __ref_count() const { return __counter; }
 	};
-	
+
+	//for objects that never leave the thread(loop) that creates them, grab/drop without a lock prefixed instruction
+	//NETP_DEBUG_LOOP_CONFINED_REF asserts on every grab/drop from another thread
+	struct __loop_confined_counter:
+		private __non_atomic_counter
+	{
+#ifdef NETP_DEBUG_LOOP_CONFINED_REF
+		std::thread::id __owner;
+		__loop_confined_counter() :
+			__non_atomic_counter(),
+			__owner(std::this_thread::get_id())
+		{}
+		__NETP_FORCE_INLINE void __ref_grab() {
+			NETP_ASSERT(__owner == std::this_thread::get_id(), "loop confined ref grabbed on a foreign thread");
+			__non_atomic_counter::__ref_grab();
+		}
+		__NETP_FORCE_INLINE bool __ref_drop() {
+			NETP_ASSERT(__owner == std::this_thread::get_id(), "loop confined ref dropped on a foreign thread");
+			return __non_atomic_counter::__ref_drop();
+		}
+#else
+		using __non_atomic_counter::__ref_grab;
+		using __non_atomic_counter::__ref_drop;
+#endif
+		using __non_atomic_counter::__ref_count;
+	};
+
 	template<class ref_counter>
 	class ref_base_internal:
 		private ref_counter
@@ -693,6 +721,7 @@ template<class _Ty COMMA LIST(_CLASS_TYPE)> \
 
 	using ref_base = ref_base_internal<__atomic_counter>;
 	using non_atomic_ref_base = ref_base_internal<__non_atomic_counter>;
+	using loop_ref_base = ref_base_internal<__loop_confined_counter>;
 
 	enum class construct_from_make_ref {};
 	template <class _Ref_t>
@@ -11,6 +11,8 @@
 #include <netp/socket_base.hpp>
 #include <netp/channel.hpp>
 #include <netp/dns_resolver.hpp>
+#include <netp/traffic/rate_limiter.hpp>
+#include <netp/traffic/buffer_budget.hpp>
 
 #if defined(_NETP_WIN) && defined(NETP_ENABLE_IOCP)
 	#define NETP_DEFAULT_LISTEN_BACKLOG SOMAXCONN
@@ -23,6 +25,15 @@
 
 //in milliseconds
 #define NETP_SOCKET_BDLIMIT_TIMER_DELAY_DUR (250)
+//rfc8305, in milliseconds
+#define NETP_SOCKET_DIAL_ATTEMPT_DELAY_DUR (250)
+#define NETP_SOCKET_DIAL_RESOLUTION_DELAY_DUR (50)
+//sampling interval used by sock_buf_autotune if transport_stats_interval is 0, in milliseconds
+#define NETP_SOCKET_BUF_AUTOTUNE_INTERVAL (1000)
+//in kernel reported size
+#define NETP_SOCKET_BUF_AUTOTUNE_MIN (1024*64)
+#define NETP_SOCKET_NOTSENT_LOWAT_MIN (1024*16)
+#define NETP_SOCKET_NOTSENT_LOWAT_MAX (1024*1024)
 
 namespace netp {
 
@@ -32,7 +43,33 @@ namespace netp {
 		port_t port;
 	};
 
+	static inline bool __is_unix_socket_proto(string_t const& proto) {
+		return netp::iequals<string_t>(proto, string_t("unix")) || netp::iequals<string_t>(proto, string_t("unixgram"));
+	}
+
+	//unix:///path/to/sock, unixgram:///path/to/sock, unix://@abstract_name
 	static int parse_socket_url(const char* url, size_t len, socket_url_parse_info& info) {
+		const string_t _url(url, len);
+		const string_t::size_type schema_end = _url.find("://");
+		if (schema_end != string_t::npos && __is_unix_socket_proto(_url.substr(0, schema_end))) {
+			info.proto = _url.substr(0, schema_end);
+			info.host = _url.substr(schema_end + 3);
+			info.port = 0;
+			return info.host.length() ? netp::OK : netp::E_SOCKET_INVALID_ADDRESS;
+		}
+
+		//tcp://[::1]:80
+		if (schema_end != string_t::npos && _url.length() > schema_end + 3 && _url[schema_end + 3] == '[') {
+			const string_t::size_type host_end = _url.find("]:", schema_end + 4);
+			if (host_end == string_t::npos) {
+				return netp::E_SOCKET_INVALID_ADDRESS;
+			}
+			info.proto = _url.substr(0, schema_end);
+			info.host = _url.substr(schema_end + 4, host_end - (schema_end + 4));
+			info.port = netp::to_u32(_url.substr(host_end + 2).c_str()) & 0xFFFF;
+			return netp::is_ipv6_notation(info.host.c_str()) ? netp::OK : netp::E_SOCKET_INVALID_ADDRESS;
+		}
+
 		std::vector<string_t> _arr;
 		netp::split<string_t>(string_t(url, len), ":", _arr);
 		if (_arr.size() != 3) {
@@ -50,7 +87,13 @@ namespace netp {
 		return netp::OK;
 	}
 
+	//for unix socket, proto is set to TCP for stream and UDP for dgram, socket_api open with protocol 0
 	static inline std::tuple<int, u8_t, u8_t, u16_t> __inspect_address_info_from_dial_str(const char* dialstr ) {
+		if (netp::iequals<string_t>(dialstr, string_t("unix"))) {
+			return std::make_tuple(netp::OK, u8_t(NETP_AF_UNIX), u8_t(NETP_SOCK_STREAM), u16_t(NETP_PROTOCOL_TCP));
+		} else if (netp::iequals<string_t>(dialstr, string_t("unixgram"))) {
+			return std::make_tuple(netp::OK, u8_t(NETP_AF_UNIX), u8_t(NETP_SOCK_DGRAM), u16_t(NETP_PROTOCOL_UDP));
+		}
 		u16_t sproto = DEF_protocol_str_to_proto(dialstr);
 		u8_t family;
 		u8_t stype;
@@ -77,6 +120,9 @@ namespace netp {
 		return std::make_tuple(netp::OK, family,stype, sproto);
 	}
 
+	//tstype: SCM_TSTAMP_SND or SCM_TSTAMP_ACK, id: SOF_TIMESTAMPING_OPT_ID counter (bytes for stream, datagrams for dgram), ns: realtime clock
+	typedef std::function<void(NRP<channel> const& ch, u32_t tstype, u32_t id, long long ns)> fn_socket_tx_timestamp_t;
+
 	class socket_cfg final :
 		public ref_base
 	{
@@ -95,7 +141,19 @@ namespace netp {
 		keep_alive_vals kvals;
 		channel_buf_cfg sock_buf;
 		u32_t bdlimit; //in bit (1kb == 1024b), 0 means no limit
-		
+		bool rcv_adaptive; //stream only, read into a per-read packet sized by socket_rcv_predictor instead of the loop shared rcv buffer
+		bool write_coalesce; //stream only, writes issued in one loop iteration are flushed once at the end of the iteration with a gather write
+		channel_write_watermark wwm; //outbound queue watermark, fire writability_changed when crossed
+		NRP<netp::traffic::rate_limiter> rate_limiter; //shared across channels to cap their total outbound rate, nullptr means no limit
+		u32_t max_pacing_rate; //in byte per second, SO_MAX_PACING_RATE (kernel pacing, best with fq qdisc), 0 means not set
+		bool dial_race; //opt-in, dial by host name: resolve A and AAAA, race staggered attempts (rfc8305), first connected wins
+		u32_t dial_attempt_delay; //in milliseconds, delay between two racing attempts
+		u8_t timestamping; //socket_timestamping flags, instrumentation only, rx read path goes through recvmsg
+		fn_socket_tx_timestamp_t fn_tx_timestamp; //called on loop for TIMESTAMPING_TX
+		u32_t transport_stats_interval; //in milliseconds, tcp only, sample TCP_INFO on a loop timer for ch_get_transport_stats, 0 means off
+		bool sock_buf_autotune; //tcp only, resize SO_SNDBUF/SO_RCVBUF and TCP_NOTSENT_LOWAT by the bdp of each transport stats sample
+		NRP<netp::traffic::buffer_budget> sock_buf_budget; //shared across channels to cap the growth of their autotuned buffers, nullptr means no cap
+
 		socket_cfg( NRP<io_event_loop> const& L = nullptr ):
 			L(L),
 			fd(SOCKET(NETP_INVALID_SOCKET)),
@@ -108,22 +166,127 @@ namespace netp {
 			sockapi((netp::socket_api*)&netp::NETP_DEFAULT_SOCKAPI),
 			kvals(default_tcp_keep_alive_vals),
 			sock_buf({0}),
-			bdlimit(0)
+			bdlimit(0),
+			rcv_adaptive(false),
+			write_coalesce(false),
+			wwm({0,0}),
+			rate_limiter(nullptr),
+			max_pacing_rate(0),
+			dial_race(false),
+			dial_attempt_delay(NETP_SOCKET_DIAL_ATTEMPT_DELAY_DUR),
+			timestamping(u8_t(socket_timestamping::TIMESTAMPING_NONE)),
+			fn_tx_timestamp(nullptr),
+			transport_stats_interval(0),
+			sock_buf_autotune(false),
+			sock_buf_budget(nullptr)
 		{}
+
+		//every field but the ones of the socket itself (L, fd, family, type, proto, laddr, raddr), a new field goes here
+		void copy_options(socket_cfg const& from) {
+			option = from.option;
+			sockapi = from.sockapi;
+			kvals = from.kvals;
+			sock_buf = from.sock_buf;
+			bdlimit = from.bdlimit;
+			rcv_adaptive = from.rcv_adaptive;
+			write_coalesce = from.write_coalesce;
+			wwm = from.wwm;
+			rate_limiter = from.rate_limiter;
+			max_pacing_rate = from.max_pacing_rate;
+			dial_race = from.dial_race;
+			dial_attempt_delay = from.dial_attempt_delay;
+			timestamping = from.timestamping;
+			fn_tx_timestamp = from.fn_tx_timestamp;
+			transport_stats_interval = from.transport_stats_interval;
+			sock_buf_autotune = from.sock_buf_autotune;
+			sock_buf_budget = from.sock_buf_budget;
+		}
+
+		NRP<socket_cfg> clone() const {
+			NRP<socket_cfg> c = netp::make_ref<socket_cfg>(L);
+			c->fd = fd;
+			c->family = family;
+			c->type = type;
+			c->proto = proto;
+			c->laddr = laddr;
+			c->raddr = raddr;
+			c->copy_options(*this);
+			return c;
+		}
 	};
 
+	struct socket_dial_race_ctx;
+
 	struct socket_outbound_entry final {
 		NRP<packet> data;
 		NRP<promise<int>> write_promise;
 		address to;
 	};
 
+	//grow fast when a read fills the buffer, shrink slowly after consecutive small reads
+	class socket_rcv_predictor final {
+	public:
+		//the ladder is aligned to the pool_align_allocator table bounds, each entry leaves PACK_MIN_LEFT_CAPACITY for the packet left reserve
+		static constexpr u32_t SIZES[] = {
+			896 - PACK_MIN_LEFT_CAPACITY,
+			1920 - PACK_MIN_LEFT_CAPACITY,
+			3968 - PACK_MIN_LEFT_CAPACITY,
+			8064 - PACK_MIN_LEFT_CAPACITY,
+			16128 - PACK_MIN_LEFT_CAPACITY,
+			32256 - PACK_MIN_LEFT_CAPACITY,
+			64512 - PACK_MIN_LEFT_CAPACITY,
+			129024 - PACK_MIN_LEFT_CAPACITY
+		};
+		static constexpr u8_t SIZE_COUNT = u8_t(sizeof(SIZES) / sizeof(SIZES[0]));
+		static constexpr u8_t INIT_IDX = 1;
+		static constexpr u8_t GROW_STEP = 2;
+
+	private:
+		u8_t m_idx;
+		u8_t m_max_idx;
+		bool m_shrink_pending;
+
+	public:
+		socket_rcv_predictor( u32_t max_size = SIZES[SIZE_COUNT-1]) :
+			m_idx(0),
+			m_max_idx(0),
+			m_shrink_pending(false)
+		{
+			while ( (m_max_idx+1) < SIZE_COUNT && SIZES[m_max_idx+1] <= max_size) {
+				++m_max_idx;
+			}
+			m_idx = NETP_MIN(INIT_IDX, m_max_idx);
+		}
+
+		__NETP_FORCE_INLINE u32_t size() const { return SIZES[m_idx]; }
+
+		//nbytes: bytes filled by the last read
+		void record(u32_t nbytes) {
+			if (nbytes >= SIZES[m_idx]) {
+				m_idx = u8_t(NETP_MIN(u8_t(m_idx + GROW_STEP), m_max_idx));
+				m_shrink_pending = false;
+			} else if (m_idx > 0 && nbytes <= SIZES[m_idx-1]) {
+				if (m_shrink_pending) {
+					--m_idx;
+					m_shrink_pending = false;
+				} else {
+					m_shrink_pending = true;
+				}
+			} else {
+				m_shrink_pending = false;
+			}
+		}
+	};
+
 	class socket final :
 		public channel,
 		public socket_base
 	{
 		byte_t* m_rcv_buf_ptr;
 		u32_t m_rcv_buf_size;
+		bool m_rcv_adaptive;
+		socket_rcv_predictor m_rcv_predictor;
+		bool m_write_coalesce;
 #ifdef NETP_IO_MODE_IOCP
 		WSAOVERLAPPED* m_ol_write;
 #endif
@@ -131,30 +294,76 @@ namespace netp {
 		typedef std::deque<socket_outbound_entry, netp::allocator<socket_outbound_entry>> socket_outbound_entry_t;
 		socket_outbound_entry_t m_outbound_entry_q;
 		netp::size_t m_noutbound_bytes;
+		NRP<promise<int>> m_connect_p; //set while F_CONNECTING, ch_close aborts it
 
 
 		netp::size_t m_outbound_budget;
 		netp::size_t m_outbound_limit; //in byte
 
+		NRP<netp::traffic::rate_limiter> m_rate_limiter;
+
+		u8_t m_timestamping;
+		fn_socket_tx_timestamp_t m_fn_tx_timestamp;
+
+		u32_t m_transport_stats_interval;
+		NRP<timer> m_tm_transport_stats;
+		channel_transport_stats m_transport_stats;
+
+		bool m_sock_buf_autotune;
+		NRP<netp::traffic::buffer_budget> m_sock_buf_budget;
+		u64_t m_sock_buf_charged; //kernel bytes accounted to m_sock_buf_budget
+		u8_t m_sock_buf_locked; //0x1 snd, 0x2 rcv, set by autotune, the kernel no longer grows it
+		u32_t m_notsent_lowat;
+		long long m_autotune_last_at;
+		u64_t m_autotune_last_acked;
+		u64_t m_autotune_last_rcv;
+
+		void _do_ch_bdlimit_flush();
 		void _tmcb_BDL(NRP<timer> const& t);
+		void _tmcb_RL(NRP<timer> const& t);
+		void _tmcb_transport_stats(NRP<timer> const& t);
+		void _do_transport_stats_sampling(u32_t interval);
+		void _do_sock_buf_autotune();
+		void __sock_buf_autotune(bool snd, u64_t demand, u64_t floor);
+		void __sock_buf_charge();
+		void __sock_buf_uncharge();
 	public:
 		socket( NRP<socket_cfg> const& cfg):
 			channel(cfg->L),
 			socket_base(cfg->fd, cfg->family, cfg->type, cfg->proto, cfg->laddr, cfg->raddr, cfg->sockapi),
 			m_rcv_buf_ptr(cfg->L->channel_rcv_buf()->head()),
 			m_rcv_buf_size(u32_t(cfg->L->channel_rcv_buf()->left_right_capacity())),
+			m_rcv_adaptive(cfg->rcv_adaptive && cfg->type == NETP_SOCK_STREAM),
+			m_rcv_predictor(u32_t(cfg->L->channel_rcv_buf()->left_right_capacity())),
+			m_write_coalesce(cfg->write_coalesce && cfg->type == NETP_SOCK_STREAM),
 #ifdef NETP_IO_MODE_IOCP
 			m_ol_write(0),
 #endif
 			m_noutbound_bytes(0),
+			m_connect_p(nullptr),
 			m_outbound_budget(cfg->bdlimit),
-			m_outbound_limit(cfg->bdlimit)
+			m_outbound_limit(cfg->bdlimit),
+			m_rate_limiter(cfg->rate_limiter),
+			m_timestamping(cfg->timestamping),
+			m_fn_tx_timestamp(cfg->fn_tx_timestamp),
+			m_transport_stats_interval(cfg->transport_stats_interval),
+			m_tm_transport_stats(nullptr),
+			m_transport_stats(),
+			m_sock_buf_autotune(cfg->sock_buf_autotune && cfg->type == NETP_SOCK_STREAM),
+			m_sock_buf_budget(cfg->sock_buf_budget),
+			m_sock_buf_charged(0),
+			m_sock_buf_locked(0),
+			m_notsent_lowat(0),
+			m_autotune_last_at(0),
+			m_autotune_last_acked(0),
+			m_autotune_last_rcv(0)
 		{
 			NETP_ASSERT(cfg->L != nullptr);
 		}
 
 		~socket()
 		{
+			__sock_buf_uncharge();
 		}
 
 	public:
@@ -188,7 +397,26 @@ namespace netp {
 				return std::make_tuple(rt, nullptr);
 			}
 
+			if (cfg->max_pacing_rate != 0) {
+				rt = so->set_max_pacing_rate(cfg->max_pacing_rate);
+				if (rt != netp::OK) {
+					//not fatal, fall back to user space limit if any
+					NETP_WARN("[socket][%s]set_max_pacing_rate failed: %d", so->info().c_str(), rt);
+					rt = netp::OK;
+				}
+			}
+
 			so->ch_init();
+
+			//SOF_TIMESTAMPING_OPT_ID requires an established tcp socket, a dialing one is configured on connected
+			if (!(cfg->type == NETP_SOCK_STREAM && cfg->fd == NETP_INVALID_SOCKET)) {
+				so->__cfg_timestamping();
+				so->_do_transport_stats_sampling(so->m_transport_stats_interval);
+			}
+
+			if (cfg->wwm.high != 0) {
+				so->ch_set_write_watermark(cfg->wwm.high, cfg->wwm.low);
+			}
 			return std::make_tuple(rt, so);
 		}
 
@@ -221,16 +449,39 @@ namespace netp {
 				});
 				return;
 			}
+			__do_dial(addr, initializer, ch_dialf, cfg);
+		}
+
+	private:
+		//return the dialing socket, nullptr if failed before connect (ch_dialf set already)
+		static NRP<socket> __do_dial(address const& addr, fn_channel_initializer_t const& initializer, NRP<channel_dial_promise> const& ch_dialf, NRP<socket_cfg> const& cfg) {
+			NETP_ASSERT(cfg->L != nullptr && cfg->L->in_event_loop());
+			if (addr.family() == NETP_AF_INET || addr.family() == NETP_AF_INET6) {
+				cfg->family = u8_t(addr.family());
+			}
 
 			std::tuple<int, NRP<socket>> tupc = create(cfg);
 			int rt = std::get<0>(tupc);
 			if (rt != netp::OK) {
 				ch_dialf->set(std::make_tuple(rt, nullptr));
-				return;
+				return nullptr;
 			}
 
 			NRP<promise<int>> so_dialf = netp::make_ref<promise<int>>();
 			NRP<socket> so = std::get<1>(tupc);
+#ifdef _NETP_GNU_LINUX
+			if (cfg->family == NETP_AF_UNIX && cfg->type == NETP_SOCK_DGRAM) {
+				//an unbound unix dgram socket can not receive reply, autobind to an abstract name
+				rt = so->bind(address::from_unix_path("", 0));
+				if (rt != netp::OK) {
+					ch_dialf->set(std::make_tuple(rt, nullptr));
+					so->ch_errno() = rt;
+					so->m_chflag |= int(channel_flag::F_READ_ERROR);//for assert check
+					so->ch_close_impl(nullptr);
+					return nullptr;
+				}
+			}
+#endif
 			so_dialf->if_done([ch_dialf, so](int const& rt) {
 				if (rt == netp::OK) {
 					ch_dialf->set(std::make_tuple(rt, so));
@@ -243,8 +494,19 @@ namespace netp {
 			});
 
 			so->do_dial(addr, initializer, so_dialf);
+			return so;
 		}
 
+		//rfc8305 happy eyeballs, see socket.cpp
+		static void _dial_race_begin(string_t const& host, port_t port, fn_channel_initializer_t const& initializer, NRP<channel_dial_promise> const& ch_dialf, NRP<socket_cfg> const& cfg);
+		static void _dial_race_resolved(NRP<socket_dial_race_ctx> const& ctx, int family, int rt, std::vector<address> const& addrs);
+		static void _dial_race_start(NRP<socket_dial_race_ctx> const& ctx);
+		static void _dial_race_next(NRP<socket_dial_race_ctx> const& ctx);
+		static void _dial_race_stagger(NRP<socket_dial_race_ctx> const& ctx, u32_t id);
+		static void _dial_race_attempt_done(NRP<socket_dial_race_ctx> const& ctx, u32_t id, std::tuple<int, NRP<channel>> const& tupc);
+
+	public:
+
 		static void do_dial( netp::size_t idx, std::vector<address> const& addrs, fn_channel_initializer_t const& initializer, NRP<channel_dial_promise> const& ch_dialf, NRP<socket_cfg> const& cfg ) {
 			if (idx >= addrs.size() ) {
 				NETP_WARN("[socket]dail failed after try count: %u", idx );
@@ -281,11 +543,26 @@ namespace netp {
 				return;
 			}
 
+			if (cfg->family == NETP_AF_UNIX) {
+				do_dial(address::from_unix_path(info.host.c_str(), info.host.length()), initializer, ch_dialf, cfg);
+				return;
+			}
+
 			if (netp::is_dotipv4_decimal_notation(info.host.c_str())) {
 				do_dial(address(info.host.c_str(), info.port, cfg->family), initializer, ch_dialf, cfg);
 				return;
 			}
 
+			if (netp::is_ipv6_notation(info.host.c_str())) {
+				do_dial(address(info.host.c_str(), info.port, NETP_AF_INET6), initializer, ch_dialf, cfg);
+				return;
+			}
+
+			if (cfg->dial_race && (cfg->family == NETP_AF_INET || cfg->family == NETP_AF_INET6)) {
+				_dial_race_begin(info.host, info.port, initializer, ch_dialf, cfg);
+				return;
+			}
+
 			NRP<dns_query_promise> dnsp = netp::dns_resolver::instance()->resolve(info.host);
 			dnsp->if_done([port = info.port, initializer, ch_dialf, cfg](std::tuple<int, std::vector<ipv4_t,netp::allocator<ipv4_t>>> const& tupdns ) {
 				if ( std::get<0>(tupdns) != netp::OK) {
@@ -384,12 +661,18 @@ namespace netp {
 				return listenp;
 			}
 
-			if (!netp::is_dotipv4_decimal_notation(info.host.c_str())) {
+			address laddr;
+			if (cfg->family == NETP_AF_UNIX) {
+				laddr = address::from_unix_path(info.host.c_str(), info.host.length());
+			} else if (netp::is_dotipv4_decimal_notation(info.host.c_str())) {
+				laddr = address(info.host.c_str(), info.port, cfg->family);
+			} else if (netp::is_ipv6_notation(info.host.c_str())) {
+				cfg->family = u8_t(NETP_AF_INET6);
+				laddr = address(info.host.c_str(), info.port, NETP_AF_INET6);
+			} else {
 				listenp->set(std::make_tuple(netp::E_SOCKET_INVALID_ADDRESS, nullptr));
 				return listenp;
 			}
-
-			address laddr(info.host.c_str(), info.port, cfg->family );
 			if (cfg->L == nullptr) {
 				cfg->L = io_event_loop_group::instance()->next(NETP_DEFAULT_POLLER_TYPE);
 			}
@@ -419,7 +702,7 @@ namespace netp {
 
 	private:
 
-		//url example: tcp://0.0.0.0:80, udp://127.0.0.1:80		
+		//url example: tcp://0.0.0.0:80, udp://127.0.0.1:80, unix:///tmp/netp.sock, unixgram://@netp
 		//@todo
 		//tcp6://ipv6address
 		void do_listen_on(address const& addr, fn_channel_initializer_t const& fn_accepted, NRP<promise<int>> const& chp, NRP<socket_cfg> const& ccfg, int backlog = NETP_DEFAULT_LISTEN_BACKLOG);
@@ -463,8 +746,10 @@ namespace netp {
 				NRP<promise<int>> wp = entry.write_promise;
 				m_noutbound_bytes -= entry.data->len();
 				m_outbound_entry_q.pop_front();
-				NETP_ASSERT(wp->is_idle());
-				wp->set(ch_errno());
+				if (wp != nullptr) {
+					NETP_ASSERT(wp->is_idle());
+					wp->set(ch_errno());
+				}
 			}
 
 			socket_base::shutdown(SHUT_WR);
@@ -488,11 +773,7 @@ namespace netp {
 			ccfg->raddr = raddr;
 
 			ccfg->L = io_event_loop_group::instance()->next(L->type());
-			ccfg->sockapi = cfg->sockapi;
-			ccfg->option = cfg->option;
-			ccfg->kvals = cfg->kvals;
-			ccfg->sock_buf = cfg->sock_buf;
-			ccfg->bdlimit = cfg->bdlimit;
+			ccfg->copy_options(*cfg);
 
 			ccfg->L->execute([ccfg, initializer]() {
 				std::tuple<int, NRP<socket>> tupc = create(ccfg);
@@ -549,6 +830,19 @@ namespace netp {
 
 		void __cb_aio_accept_impl(fn_channel_initializer_t const& fn_initializer, NRP<socket_cfg> const& ccfg, int code);
 		void __cb_aio_read_impl(const int aiort_) ;
+		int __do_read_timestamping(int aiort);
+		void __do_read_errqueue();
+		void __cfg_timestamping() {
+			if (m_timestamping == u8_t(socket_timestamping::TIMESTAMPING_NONE)) {
+				return;
+			}
+			const int rt = set_timestamping(m_timestamping);
+			if (rt != netp::OK) {
+				//not fatal, instrumentation only
+				NETP_WARN("[socket][%s]set_timestamping failed: %d", info().c_str(), rt);
+				m_timestamping = u8_t(socket_timestamping::TIMESTAMPING_NONE);
+			}
+		}
 		void __cb_aio_write_impl(const int aiort_);
 
 		//@note, we need simulate a async write, so for write operation, we'll flush outbound buffer in the next loop
@@ -557,7 +851,11 @@ namespace netp {
 		//==0, flush done
 		//this api would be called right after a check of writeable of the current socket
 		int _do_ch_write_impl() ;
+		int _do_ch_writev_impl();
 		int _do_ch_write_to_impl();
+		void _do_ch_flush_deferred();
+		//write the queued entries now, or on the next write event, or at the end of the iteration if coalescing
+		void _do_ch_write_kick();
 
 		//for connected socket type
 		void _ch_do_close_listener();
@@ -566,6 +864,11 @@ namespace netp {
 		void __cb_aio_notify(fn_aio_event_t const& fn_begin_done, const int aiort_) {
 			NETP_ASSERT(L->in_event_loop());
 
+			if (aiort_ == netp::E_SOCKET_ERRQUEUE_READY) {
+				__do_read_errqueue();
+				return;
+			}
+
 			NETP_ASSERT(
 				aiort_ == netp::E_IO_EVENT_LOOP_NOTIFY_TERMINATING
 				||aiort_ == netp::OK
@@ -891,7 +1194,7 @@ namespace netp {
 			entry.data->skip(len);
 			m_noutbound_bytes -= len;
 			if (entry.data->len() == 0) {
-				entry.chp->set(netp::OK);
+				if (entry.write_promise != nullptr) { entry.write_promise->set(netp::OK); }
 				m_outbound_entry_q.pop_front();
 			}
 			socket::__async_flush_done(netp::OK);
@@ -939,6 +1242,12 @@ namespace netp {
 		__NETP_FORCE_INLINE channel_id_t ch_id() const override { return m_fd; }
 		std::string ch_info() const override { return info();}
 
+		void ch_set_rate_limiter(NRP<netp::traffic::rate_limiter> const& rl) {
+			L->execute([s = NRP<socket>(this), rl]() {
+				s->m_rate_limiter = rl;
+			});
+		}
+
 		void ch_set_bdlimit(u32_t limit) override {
 			L->execute([s = NRP<socket>(this), limit]() {
 				s->m_outbound_limit = limit;
@@ -946,7 +1255,28 @@ namespace netp {
 			});
 		};
 
+		NRP<channel_transport_stats_promise> ch_get_transport_stats() override {
+			NRP<channel_transport_stats_promise> p = netp::make_ref<channel_transport_stats_promise>();
+			L->execute([s = NRP<socket>(this), p]() {
+				if (s->m_tm_transport_stats != nullptr) {
+					p->set(std::make_tuple(netp::OK, s->m_transport_stats));
+					return;
+				}
+				channel_transport_stats stats = {};
+				const int rt = s->get_tcp_info(stats);
+				p->set(std::make_tuple(rt, stats));
+			});
+			return p;
+		}
+
+		void ch_set_transport_stats_sampling(u32_t interval) override {
+			L->execute([s = NRP<socket>(this), interval]() {
+				s->_do_transport_stats_sampling(interval);
+			});
+		}
+
 		void ch_write_impl(NRP<packet> const& outlet, NRP<promise<int>> const& chp) override ;
+		void ch_write_impl(NRP<chained_packet> const& chain, NRP<promise<int>> const& chp) override;
 		void ch_write_to_impl(NRP<packet> const& outlet, netp::address const& to, NRP<promise<int>> const& chp) override;
 
 		void ch_close_read_impl(NRP<promise<int>> const& closep) override
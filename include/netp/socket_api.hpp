@@ -15,8 +15,22 @@
 
 #define IS_ERRNO_EQUAL_CONNECTING(_errno) ((_errno==netp::E_EINPROGRESS)||(_errno==netp::E_WSAEWOULDBLOCK))
 
+#ifdef _NETP_GNU_LINUX
+	#include <linux/net_tstamp.h>
+	#include <linux/errqueue.h>
+#endif
+
 namespace netp {
 
+#ifdef _NETP_WIN
+	typedef WSABUF iov_t;
+	#define NETP_IOV_SET(iov,ptr,size) ((iov).buf=(char*)(ptr),(iov).len=(ULONG)(size))
+#else
+	typedef struct iovec iov_t;
+	#define NETP_IOV_SET(iov,ptr,size) ((iov).iov_base=(void*)(ptr),(iov).iov_len=(size_t)(size))
+#endif
+	#define NETP_SOCKET_SENDV_MAX_IOV (64)
+
 	typedef SOCKET (*fn_socket)(int family, int type, int proto);
 	typedef int(*fn_connect)(SOCKET fd, const struct sockaddr* sockaddr, socklen_t len);
 		
@@ -32,9 +46,16 @@ namespace netp {
 	typedef int(*fn_setsockopt)(SOCKET fd, int level, int option_name, void const* value, socklen_t option_len);
 
 	typedef int (*fn_send)(SOCKET fd, char const* const buf, u32_t len, int flags);
+	typedef int (*fn_sendv)(SOCKET fd, iov_t const* iov, u32_t iovcnt, int flags);
 	typedef int (*fn_recv)(SOCKET fd, char* const buf, u32_t size, int flags);
 	typedef int (*fn_sendto)(SOCKET fd, char const* buf, u32_t len, int flags, const struct sockaddr* dest_addr, socklen_t addrlen);
 	typedef int (*fn_recvfrom)(SOCKET fd, char* buff_o, u32_t size, int flags, struct sockaddr* src_addr, socklen_t* addrlen);
+#ifdef _NETP_WIN
+	typedef WSAMSG msghdr_t;
+#else
+	typedef struct msghdr msghdr_t;
+#endif
+	typedef int (*fn_recvmsg)(SOCKET fd, msghdr_t* msg, int flags);
 	typedef u32_t (*fn_recvonemsg)(SOCKET fd, byte_t* const buf_o, const u32_t bsize, address& raddr, ipv4_t& lipv4, int& ec_o, int flag);
 
 	typedef int (*fn_set_nonblocking)(SOCKET fd, bool onoff);
@@ -57,10 +78,38 @@ namespace netp {
 		fn_recvfrom recvfrom;
 		fn_recvonemsg recvonemsg;
 		fn_set_nonblocking set_nonblocking;
+		fn_sendv sendv;
+		fn_recvmsg recvmsg;
 	};
 
 	inline int netp_close(SOCKET fd) { return NETP_CLOSE_SOCKET(fd); }
 
+	inline int netp_sendv(SOCKET fd, iov_t const* iov, u32_t iovcnt, int flags) {
+#ifdef _NETP_WIN
+		DWORD nbytes = 0;
+		const int rt = ::WSASend(fd, (LPWSABUF)iov, iovcnt, &nbytes, flags, nullptr, nullptr);
+		return rt == 0 ? int(nbytes) : NETP_SOCKET_ERROR;
+#else
+		struct msghdr msg;
+		::memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = (struct iovec*)iov;
+		msg.msg_iovlen = iovcnt;
+		return (int)::sendmsg(fd, &msg, flags);
+#endif
+	}
+
+	inline int netp_recvmsg(SOCKET fd, msghdr_t* msg, int flags) {
+#ifdef _NETP_WIN
+		//WSARecvMsg is an extension function, only the linux timestamping reads go through recvmsg
+		(void)fd;
+		(void)msg;
+		(void)flags;
+		return NETP_SOCKET_ERROR;
+#else
+		return (int)::recvmsg(fd, msg, flags);
+#endif
+	}
+
 #ifdef NETP_IO_MODE_IOCP
 	namespace iocp {
 		inline SOCKET socket(int const& family, int const& type, int const& proto) {
@@ -333,6 +382,115 @@ namespace netp {
 	}
 #endif
 
+#ifdef _NETP_GNU_LINUX
+	#define NETP_TIMESPEC_TO_NS(ts) ((long long)(ts).tv_sec*1000000000LL + (long long)(ts).tv_nsec)
+
+	union timestamp_control_data {
+		struct cmsghdr cmsg;
+		u_char data[CMSG_SPACE(sizeof(struct scm_timestamping))];
+	};
+
+	//recv/recvfrom with the kernel receive timestamp (SO_TIMESTAMPING or SO_TIMESTAMPNS) in realtime ns, 0 if the kernel did not attach one
+	//from_o could be nullptr for stream socket
+	inline netp::u32_t recvmsg_timestamp(socket_api const& fn, SOCKET fd, byte_t* const buff_o, const netp::u32_t bsize, address* from_o, long long& ts_o, int& ec_o) {
+		NETP_ASSERT(fd != NETP_INVALID_SOCKET);
+		struct iovec iov[1] = { {buff_o,bsize} };
+		struct sockaddr_storage ss;
+		union timestamp_control_data cmsg;
+
+		struct msghdr msg;
+		::memset(&msg, 0, sizeof(msg));
+		msg.msg_name = from_o == nullptr ? nullptr : &ss;
+		msg.msg_namelen = from_o == nullptr ? 0 : sizeof(ss);
+		msg.msg_iov = iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = &cmsg;
+		msg.msg_controllen = sizeof(cmsg);
+
+	_recvmsg:
+		const int nbytes = fn.recvmsg(fd, &msg, 0);
+		if (NETP_LIKELY(nbytes > 0)) {
+			ts_o = 0;
+			for (struct cmsghdr* cmsgptr = CMSG_FIRSTHDR(&msg); cmsgptr != nullptr; cmsgptr = CMSG_NXTHDR(&msg, cmsgptr)) {
+				if (cmsgptr->cmsg_level != SOL_SOCKET) {
+					continue;
+				}
+				if (cmsgptr->cmsg_type == SO_TIMESTAMPING) {
+					//[0] software, [2] raw hardware
+					struct scm_timestamping const* tss = (struct scm_timestamping const*)CMSG_DATA(cmsgptr);
+					ts_o = NETP_TIMESPEC_TO_NS(tss->ts[0]);
+				} else if (cmsgptr->cmsg_type == SO_TIMESTAMPNS) {
+					struct timespec const* ts = (struct timespec const*)CMSG_DATA(cmsgptr);
+					ts_o = NETP_TIMESPEC_TO_NS(*ts);
+				}
+			}
+			if (from_o != nullptr) {
+				*from_o = netp::address((struct sockaddr const*)&ss, msg.msg_namelen);
+			}
+			ec_o = netp::OK;
+			return u32_t(nbytes);
+		} else if (nbytes == 0) {
+			//zero length datagram is legal
+			ec_o = from_o == nullptr ? netp::E_SOCKET_GRACE_CLOSE : netp::OK;
+			return 0;
+		}
+
+		const int ec = netp_socket_get_last_errno();
+		if (IS_ERRNO_EQUAL_WOULDBLOCK(ec)) {
+			ec_o = netp::E_SOCKET_READ_BLOCK;
+		} else if (ec == netp::E_EINTR) {
+			goto _recvmsg;
+		} else {
+			ec_o = ec;
+			NETP_TRACE_SOCKET_API("[netp::recvmsg_timestamp][#%d]recvmsg: %d", fd, ec);
+		}
+		return 0;
+	}
+
+	//fn(tstype, id, ns), tstype is one of SCM_TSTAMP_SND, SCM_TSTAMP_ACK, id is the SOF_TIMESTAMPING_OPT_ID counter
+	//return the number of timestamps read from the error queue
+	template <class _fn_t>
+	inline int recv_errqueue_timestamps(socket_api const& api, SOCKET fd, _fn_t const& fn) {
+		int n = 0;
+		while (true) {
+			byte_t payload[64];
+			struct iovec iov[1] = { {payload,sizeof(payload)} };
+			u_char control[CMSG_SPACE(sizeof(struct scm_timestamping)) + CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_storage))];
+			struct msghdr msg;
+			::memset(&msg, 0, sizeof(msg));
+			msg.msg_iov = iov;
+			msg.msg_iovlen = 1;
+			msg.msg_control = control;
+			msg.msg_controllen = sizeof(control);
+
+			const int nbytes = api.recvmsg(fd, &msg, MSG_ERRQUEUE);
+			if (nbytes < 0) {
+				const int ec = netp_socket_get_last_errno();
+				if (ec == netp::E_EINTR) {
+					continue;
+				}
+				break;
+			}
+
+			long long ns = 0;
+			struct sock_extended_err const* serr = nullptr;
+			for (struct cmsghdr* cmsgptr = CMSG_FIRSTHDR(&msg); cmsgptr != nullptr; cmsgptr = CMSG_NXTHDR(&msg, cmsgptr)) {
+				if (cmsgptr->cmsg_level == SOL_SOCKET && cmsgptr->cmsg_type == SO_TIMESTAMPING) {
+					struct scm_timestamping const* tss = (struct scm_timestamping const*)CMSG_DATA(cmsgptr);
+					ns = NETP_TIMESPEC_TO_NS(tss->ts[0]);
+				} else if ((cmsgptr->cmsg_level == SOL_IP && cmsgptr->cmsg_type == IP_RECVERR) || (cmsgptr->cmsg_level == SOL_IPV6 && cmsgptr->cmsg_type == IPV6_RECVERR)) {
+					serr = (struct sock_extended_err const*)CMSG_DATA(cmsgptr);
+				}
+			}
+			if (serr != nullptr && serr->ee_errno == ENOMSG && serr->ee_origin == SO_EE_ORIGIN_TIMESTAMPING) {
+				fn(u32_t(serr->ee_info), u32_t(serr->ee_data), ns);
+				++n;
+			}
+		}
+		return n;
+	}
+#endif
+
 #ifdef _NETP_WIN
 #define __SOCKET_API_NS winapi
 #else 
@@ -355,29 +513,34 @@ namespace netp {
 			(fn_recv)__SOCKET_API_NS::recv,
 			(fn_recvfrom)__SOCKET_API_NS::recvfrom,
 			(fn_recvonemsg)recvonemsg,
-			(fn_set_nonblocking)set_nonblocking
+			(fn_set_nonblocking)set_nonblocking,
+			(fn_sendv)netp_sendv,
+			(fn_recvmsg)netp_recvmsg
 	};
 	
+	//for NETP_AF_UNIX, protocol only tells the semantic (TCP for stream, UDP for dgram), the os protocol is 0
 	inline SOCKET open(socket_api const& fn, int family, int type, int protocol) {
-		return fn.socket(family, type, OS_DEF_protocol[protocol]);
+		return fn.socket(family, type, family == NETP_AF_UNIX ? 0 : OS_DEF_protocol[protocol]);
 	}
 
 	inline int connect(socket_api const& fn,SOCKET fd, address const& addr) {
-		sockaddr_in addr_in;
-		::memset(&addr_in, 0, sizeof(addr_in));
-		addr_in.sin_family = u16_t(addr.family());
-		addr_in.sin_port = addr.nport();
-		addr_in.sin_addr.s_addr = addr.nipv4();
-		return fn.connect(fd, (sockaddr*)(&addr_in), sizeof(addr_in));
+		sockaddr_storage ss;
+		const socklen_t len = addr.to_sockaddr(ss);
+		if (len == 0) {
+			netp_set_last_errno(netp::E_SOCKET_INVALID_ADDRESS);
+			return NETP_SOCKET_ERROR;
+		}
+		return fn.connect(fd, (sockaddr*)(&ss), len);
 	}
 
 	inline int bind(socket_api const& fn,SOCKET fd, address const& addr) {
-		sockaddr_in addr_in;
-		::memset(&addr_in, 0, sizeof(addr_in));
-		addr_in.sin_family = u16_t(addr.family());
-		addr_in.sin_port = addr.nport();
-		addr_in.sin_addr.s_addr = addr.nipv4();
-		return fn.bind(fd, (sockaddr*)(&addr_in), sizeof(addr_in));
+		sockaddr_storage ss;
+		const socklen_t len = addr.to_sockaddr(ss);
+		if (len == 0) {
+			netp_set_last_errno(netp::E_SOCKET_INVALID_ADDRESS);
+			return NETP_SOCKET_ERROR;
+		}
+		return fn.bind(fd, (sockaddr*)(&ss), len);
 	}
 
 	inline int shutdown(socket_api const& fn, SOCKET fd, int flag) {
@@ -393,34 +556,34 @@ namespace netp {
 	}
 
 	inline SOCKET accept(socket_api const& fn, SOCKET fd, address& addr) {
-		sockaddr_in addr_in;
-		::memset(&addr_in, 0, sizeof(addr_in));
-		socklen_t len = sizeof(addr_in);
+		sockaddr_storage ss;
+		::memset(&ss, 0, sizeof(ss));
+		socklen_t len = sizeof(ss);
 
-		SOCKET accepted_fd = fn.accept(fd, (sockaddr*)(&addr_in), &len);
+		SOCKET accepted_fd = fn.accept(fd, (sockaddr*)(&ss), &len);
 		NETP_RETURN_V_IF_MATCH((SOCKET)NETP_SOCKET_ERROR, (accepted_fd == (SOCKET)NETP_INVALID_SOCKET));
-		addr = address(addr_in);
+		addr = address((sockaddr*)(&ss), len);
 		return accepted_fd;
 	}
 
 	inline int getsockname(socket_api const& fn,SOCKET fd, address& addr) {
-		sockaddr_in addr_in;
-		::memset(&addr_in, 0, sizeof(addr_in));
+		sockaddr_storage ss;
+		::memset(&ss, 0, sizeof(ss));
 
-		socklen_t len = sizeof(addr_in);
-		int rt = fn.getsockname(fd, (sockaddr*)(&addr_in), &len);
+		socklen_t len = sizeof(ss);
+		int rt = fn.getsockname(fd, (sockaddr*)(&ss), &len);
 		NETP_RETURN_V_IF_MATCH(rt, rt == NETP_SOCKET_ERROR);
-		addr = address(addr_in);
+		addr = address((sockaddr*)(&ss), len);
 		return netp::OK;
 	}
 
 	inline int getpeername(socket_api const& fn, SOCKET fd, address& addr) {
-		sockaddr_in addr_peer;
-		::memset(&addr_peer, 0, sizeof(addr_peer));
-		socklen_t len = sizeof(addr_peer);
-		int rt = fn.getpeername(fd, (sockaddr*)(&addr_peer), &len);
+		sockaddr_storage ss;
+		::memset(&ss, 0, sizeof(ss));
+		socklen_t len = sizeof(ss);
+		int rt = fn.getpeername(fd, (sockaddr*)(&ss), &len);
 		NETP_RETURN_V_IF_MATCH(rt, rt == NETP_SOCKET_ERROR);
-		addr = address(addr_peer);
+		addr = address((sockaddr*)(&ss), len);
 		return netp::OK;
 	}
 
@@ -462,6 +625,31 @@ namespace netp {
 		return R;
 	}
 
+	//gather write, return the bytes sent, a partial write is not retried
+	inline netp::u32_t sendv(socket_api const& fn, SOCKET fd, iov_t const* iov, netp::u32_t iovcnt, int& ec_o, int flag) {
+		NETP_ASSERT(iov != nullptr);
+		NETP_ASSERT(iovcnt > 0 && iovcnt <= NETP_SOCKET_SENDV_MAX_IOV);
+	_sendv:
+		const int r = fn.sendv(fd, iov, iovcnt, flag);
+		if (NETP_LIKELY(r > 0)) {
+			ec_o = netp::OK;
+			NETP_TRACE_SOCKET_API("[netp::sendv][#%d]sendv, iovcnt: %u, sent: %d", fd, iovcnt, r);
+			return netp::u32_t(r);
+		}
+
+		NETP_ASSERT(r == -1);
+		const int ec = netp_socket_get_last_errno();
+		if (NETP_LIKELY(IS_ERRNO_EQUAL_WOULDBLOCK(ec))) {
+			ec_o = netp::E_SOCKET_WRITE_BLOCK;
+		} else if (NETP_UNLIKELY(ec == netp::E_EINTR)) {
+			goto _sendv;
+		} else {
+			NETP_TRACE_SOCKET_API("[netp::sendv][#%d]sendv failed: %d", fd, ec);
+			ec_o = ec;
+		}
+		return 0;
+	}
+
 	inline netp::u32_t recv(socket_api const& fn, SOCKET fd, byte_t* const buffer_o, netp::u32_t size, int& ec_o, int flag) {
 		NETP_ASSERT(buffer_o != nullptr);
 		NETP_ASSERT(size > 0);
@@ -510,13 +698,14 @@ namespace netp {
 		NETP_ASSERT(len > 0);
 		NETP_ASSERT(!addr.is_null());
 
-		sockaddr_in addr_in;
-		::memset(&addr_in, 0, sizeof(addr_in));
-		addr_in.sin_family = u16_t(addr.family());
-		addr_in.sin_port = addr.nport();
-		addr_in.sin_addr.s_addr = addr.nipv4();
+		sockaddr_storage ss;
+		const socklen_t sslen = addr.to_sockaddr(ss);
+		if (sslen == 0) {
+			ec_o = netp::E_SOCKET_INVALID_ADDRESS;
+			return 0;
+		}
 sendto:
-		const int nbytes = fn.sendto(fd, reinterpret_cast<const char*>(buff), (int)len, flag, reinterpret_cast<sockaddr*>(&addr_in), sizeof(addr_in));
+		const int nbytes = fn.sendto(fd, reinterpret_cast<const char*>(buff), (int)len, flag, reinterpret_cast<sockaddr*>(&ss), sslen);
 
 		if (NETP_LIKELY(nbytes > 0)) {
 			NETP_ASSERT((u32_t)nbytes == len);
@@ -540,13 +729,12 @@ sendto:
 
 	inline netp::u32_t recvfrom(socket_api const& api, SOCKET fd, byte_t* const buff_o, netp::u32_t size, address& addr_o, int& ec_o, int const& flag) {
 recvfrom:
-		sockaddr_in addr_in;
-		::memset(&addr_in, 0, sizeof(addr_in));
-		socklen_t socklen = sizeof(addr_in);
-		const int nbytes = api.recvfrom(fd, reinterpret_cast<char*>(buff_o), (int)size, flag, reinterpret_cast<sockaddr*>(&addr_in), &socklen);
+		sockaddr_storage ss;
+		socklen_t socklen = sizeof(ss);
+		const int nbytes = api.recvfrom(fd, reinterpret_cast<char*>(buff_o), (int)size, flag, reinterpret_cast<sockaddr*>(&ss), &socklen);
 
 		if (NETP_LIKELY(nbytes > 0)) {
-			addr_o = address(addr_in);
+			addr_o = address(reinterpret_cast<sockaddr*>(&ss), socklen);
 			ec_o = netp::OK;
 			NETP_TRACE_SOCKET_API("[netp::recvfrom][#%d]recvfrom() == %d", fd, nbytes);
 			return nbytes;
@@ -20,6 +20,13 @@ namespace netp {
 
 	const static int default_socket_option = int(socket_option::OPTION_NON_BLOCKING)|int(socket_option::OPTION_KEEP_ALIVE);
 
+	//kernel timestamping, linux only
+	enum socket_timestamping {
+		TIMESTAMPING_NONE = 0,
+		TIMESTAMPING_RX = 1, //software receive timestamp, the packets read are rx_stamped_packet, see packet::rx_timestamp
+		TIMESTAMPING_TX = 1<<1 //software send (and ack for tcp) timestamps read from the error queue
+	};
+
 	struct keep_alive_vals {
 		netp::u8_t	 probes;
 		netp::u8_t	 idle; //in seconds
@@ -85,6 +92,10 @@ namespace netp {
 		int _cfg_keepalive(bool onoff, keep_alive_vals const& vals);
 
 		int _cfg_broadcast(bool onoff);
+		int _cfg_max_pacing_rate(u32_t rate);
+		int _cfg_notsent_lowat(u32_t lowat);
+		int _cfg_timestamping(u8_t flags);
+		int _get_tcp_info(channel_transport_stats& stats);
 		int _cfg_option(u16_t opt, keep_alive_vals const& vlas);
 
 		int init(u16_t opt, keep_alive_vals const& kvals, channel_buf_cfg const& cbc) {
@@ -121,8 +132,9 @@ namespace netp {
 		int load_sockname() {
 			int rt = netp::getsockname(*m_api,m_fd, m_laddr);
 			if (rt == netp::OK) {
-				NETP_ASSERT(m_laddr.family() == NETP_AF_INET);
-				NETP_ASSERT(!m_laddr.is_null());
+				NETP_ASSERT(m_laddr.family() == m_family);
+				//unix socket might be unnamed
+				NETP_ASSERT(m_family == NETP_AF_UNIX || !m_laddr.is_null());
 				return netp::OK;
 			}
 			return netp_socket_get_last_errno();
@@ -132,8 +144,9 @@ namespace netp {
 		int load_peername() {
 			int rt = netp::getpeername(*m_api,m_fd, m_raddr);
 			if (rt == netp::OK) {
-				NETP_ASSERT(m_raddr.family() == NETP_AF_INET);
-				NETP_ASSERT(!m_laddr.is_null());
+				NETP_ASSERT(m_raddr.family() == m_family);
+				//unix socket might be unnamed
+				NETP_ASSERT(m_family == NETP_AF_UNIX || !m_laddr.is_null());
 				return netp::OK;
 			}
 			return netp_socket_get_last_errno();
@@ -151,6 +164,10 @@ namespace netp {
 			return m_api->setsockopt(m_fd, level, option_name, value, option_len);
 		}
 
+		__NETP_FORCE_INLINE int set_max_pacing_rate(u32_t rate) { return _cfg_max_pacing_rate(rate); }
+		__NETP_FORCE_INLINE int set_notsent_lowat(u32_t lowat) { return _cfg_notsent_lowat(lowat); }
+		__NETP_FORCE_INLINE int set_timestamping(u8_t flags) { return _cfg_timestamping(flags); }
+		__NETP_FORCE_INLINE int get_tcp_info(channel_transport_stats& stats) { return _get_tcp_info(stats); }
 		__NETP_FORCE_INLINE int turnon_nodelay() { return _cfg_nodelay(true); }
 		__NETP_FORCE_INLINE int turnoff_nodelay() { return _cfg_nodelay(false); }
 
@@ -191,6 +208,9 @@ namespace netp {
 		__NETP_FORCE_INLINE netp::u32_t send(byte_t const* const buffer, netp::u32_t size, int& ec_o, int flag = 0) {
 			return netp::send(*m_api,m_fd, buffer, size, ec_o, flag);
 		}
+		__NETP_FORCE_INLINE netp::u32_t sendv(iov_t const* iov, netp::u32_t iovcnt, int& ec_o, int flag = 0) {
+			return netp::sendv(*m_api, m_fd, iov, iovcnt, ec_o, flag);
+		}
 		__NETP_FORCE_INLINE netp::u32_t recv(byte_t* const buffer_o, netp::u32_t size, int& ec_o, int flag = 0) {
 			return netp::recv(*m_api,m_fd, buffer_o, size, ec_o, flag);
 		}
@@ -13,6 +13,7 @@
 #include <netp/mutex.hpp>
 #include <netp/thread.hpp>
 #include <netp/promise.hpp>
+#include <netp/recycler.hpp>
 
 #include <netp/logger_broker.hpp>
 
@@ -74,6 +75,8 @@ namespace netp {
 		friend class timer_broker;
 		friend class timer_broker_ts;
 	public:
+		NETP_RECYCLE_OBJECT(timer, "timer")
+
 		template <class dur, class _Fx, class... _Args>
 		inline timer(dur&& delay_, _Fx&& func, _Args&&... args):
 			callee(std::forward<_fn_timer_t>(std::bind(std::forward<_Fx>(func), std::forward<_Args>(args)...))),
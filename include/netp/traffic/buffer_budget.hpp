@@ -0,0 +1,51 @@
+#ifndef _NETP_TRAFFIC_BUFFER_BUDGET_HPP
+#define _NETP_TRAFFIC_BUFFER_BUDGET_HPP
+
+#include <atomic>
+#include <netp/core.hpp>
+#include <netp/smart_ptr.hpp>
+
+namespace netp { namespace traffic {
+
+	//byte budget for kernel socket buffers grown by socket_cfg::sock_buf_autotune
+	//thread safe, one instance is meant to be shared by all the channels it caps
+	class buffer_budget final :
+		public netp::ref_base
+	{
+		std::atomic<u64_t> m_used;
+		u64_t m_limit;
+
+	public:
+		buffer_budget(u64_t limit) :
+			m_used(0),
+			m_limit(limit)
+		{
+			NETP_ASSERT(limit > 0);
+		}
+
+		u64_t limit() const { return m_limit; }
+		u64_t used() const { return m_used.load(std::memory_order_relaxed); }
+
+		//fail if it would exceed the limit
+		bool try_acquire(u64_t n) {
+			u64_t used = m_used.load(std::memory_order_relaxed);
+			do {
+				if (used + n > m_limit) {
+					return false;
+				}
+			} while (!m_used.compare_exchange_weak(used, used + n, std::memory_order_acq_rel, std::memory_order_relaxed));
+			return true;
+		}
+
+		//for bytes committed already, might go over the limit
+		void acquire(u64_t n) {
+			m_used.fetch_add(n, std::memory_order_acq_rel);
+		}
+
+		void release(u64_t n) {
+			NETP_ASSERT(m_used.load(std::memory_order_relaxed) >= n);
+			m_used.fetch_sub(n, std::memory_order_acq_rel);
+		}
+	};
+}}
+#endif
@@ -35,7 +35,7 @@ namespace netp { namespace traffic {
 
 	public:
 		iptcp_payload_dst_handler(NRP<forwarder_iptcp_payload> const& forwarder) :
-			channel_handler_abstract(netp::CH_ACTIVITY_CONNECTED | netp::CH_ACTIVITY_CLOSED | netp::CH_ACTIVITY_READ_CLOSED | netp::CH_INBOUND_READ),
+			channel_handler_abstract(netp::CH_ACTIVITY_CONNECTED | netp::CH_ACTIVITY_CLOSED | netp::CH_ACTIVITY_READ_CLOSED | netp::CH_ACTIVITY_WRITABILITY_CHANGED | netp::CH_INBOUND_READ),
 			m_forwarder(forwarder)
 		{}
 
@@ -44,6 +44,7 @@ namespace netp { namespace traffic {
 		void connected(NRP<netp::channel_handler_context> const& ctx) override;
 		void closed(NRP<netp::channel_handler_context > const& ctx) override;
 		void read_closed(NRP<netp::channel_handler_context > const& ctx) override;
+		void writability_changed(NRP<netp::channel_handler_context> const& ctx, bool writable) override;
 		void read(NRP<netp::channel_handler_context> const& ctx, NRP<netp::packet> const& income) override;
 	};
 
@@ -78,6 +79,7 @@ namespace netp { namespace traffic {
 		void _dst_connected(NRP<netp::channel_handler_context> const& ctx);
 		void _dst_closed(NRP<netp::channel_handler_context> const& ctx);
 		void _dst_read_closed(NRP<netp::channel_handler_context> const& ctx);
+		void _dst_writability_changed(bool writable);
 		void _dst_read(NRP<netp::channel_handler_context> const& ctx, NRP<netp::packet> const& income);
 
 		void _dial_dst();
@@ -87,6 +89,7 @@ namespace netp { namespace traffic {
 		void connected(NRP<netp::channel_handler_context> const& ctx) override;
 		void closed(NRP<netp::channel_handler_context> const& ctx) override;
 		void read_closed(NRP<netp::channel_handler_context> const& ctx) override;
+		void writability_changed(NRP<netp::channel_handler_context> const& ctx, bool writable) override;
 		void read(NRP<netp::channel_handler_context> const& ctx, NRP<netp::packet> const& income) override;
 	};
 
@@ -0,0 +1,117 @@
+#ifndef _NETP_TRAFFIC_RATE_LIMITER_HPP
+#define _NETP_TRAFFIC_RATE_LIMITER_HPP
+
+#include <netp/core.hpp>
+#include <netp/smart_ptr.hpp>
+#include <netp/mutex.hpp>
+
+//burst defaults to 20ms worth of rate
+#define NETP_RATE_LIMITER_DEFAULT_BURST_DIV (50)
+#define NETP_RATE_LIMITER_BURST_MIN (1024*16)
+#define NETP_RATE_LIMITER_WAIT_MIN_NS (1000*1000)
+
+namespace netp { namespace traffic {
+
+	//token bucket in bytes, refilled by elapsed time on each acquire rather than by a periodic timer
+	//thread safe, one instance can be shared by channels of different loops to cap their total rate
+	class rate_limiter final :
+		public netp::ref_base
+	{
+		netp::spin_mutex m_mtx;
+		u64_t m_rate; //bytes per second
+		u64_t m_burst;
+		u64_t m_tokens;
+		long long m_last_ns;
+
+		static inline long long _now_ns() {
+			return netp::steady_now<std::chrono::nanoseconds>().time_since_epoch().count();
+		}
+
+		static inline u64_t _calc_burst(u64_t rate, u64_t burst) {
+			if (burst == 0) {
+				burst = rate / NETP_RATE_LIMITER_DEFAULT_BURST_DIV;
+			}
+			return burst < NETP_RATE_LIMITER_BURST_MIN ? NETP_RATE_LIMITER_BURST_MIN : burst;
+		}
+
+		//only advance m_last_ns by the time the added tokens account for, the remainder carries over
+		void _refill() {
+			const long long now = _now_ns();
+			NETP_ASSERT(now >= m_last_ns);
+			if (m_tokens >= m_burst) {
+				m_last_ns = now;
+				return;
+			}
+			const u64_t elapsed = u64_t(now - m_last_ns);
+			const u64_t full_ns = ((m_burst - m_tokens) * 1000000000ULL) / m_rate;
+			if (elapsed >= full_ns) {
+				m_tokens = m_burst;
+				m_last_ns = now;
+				return;
+			}
+			const u64_t add = (elapsed * m_rate) / 1000000000ULL;
+			if (add > 0) {
+				m_tokens += add;
+				m_last_ns += (long long)((add * 1000000000ULL) / m_rate);
+			}
+		}
+
+	public:
+		//rate in bytes per second, 0 for burst means NETP_RATE_LIMITER_DEFAULT_BURST_DIV
+		rate_limiter(u64_t rate, u64_t burst = 0) :
+			m_rate(rate),
+			m_burst(_calc_burst(rate,burst)),
+			m_tokens(m_burst),
+			m_last_ns(_now_ns())
+		{
+			NETP_ASSERT(rate > 0);
+		}
+
+		void set_rate(u64_t rate, u64_t burst = 0) {
+			NETP_ASSERT(rate > 0);
+			lock_guard<netp::spin_mutex> lg(m_mtx);
+			_refill();
+			m_rate = rate;
+			m_burst = _calc_burst(rate, burst);
+			if (m_tokens > m_burst) {
+				m_tokens = m_burst;
+			}
+		}
+
+		u64_t rate() {
+			lock_guard<netp::spin_mutex> lg(m_mtx);
+			return m_rate;
+		}
+
+		//return granted bytes, [0, want]
+		u32_t acquire(u32_t want) {
+			lock_guard<netp::spin_mutex> lg(m_mtx);
+			_refill();
+			const u32_t granted = m_tokens < want ? u32_t(m_tokens) : want;
+			m_tokens -= granted;
+			return granted;
+		}
+
+		//give back the part of a grant that was not written
+		void refund(u32_t n) {
+			lock_guard<netp::spin_mutex> lg(m_mtx);
+			m_tokens += n;
+			if (m_tokens > m_burst) {
+				m_tokens = m_burst;
+			}
+		}
+
+		//nanoseconds until min(want, burst) bytes could be granted, not less than NETP_RATE_LIMITER_WAIT_MIN_NS
+		long long wait_ns(u32_t want) {
+			lock_guard<netp::spin_mutex> lg(m_mtx);
+			_refill();
+			const u64_t need = want < m_burst ? want : m_burst;
+			if (m_tokens >= need) {
+				return NETP_RATE_LIMITER_WAIT_MIN_NS;
+			}
+			const long long ns = (long long)(((need - m_tokens) * 1000000000ULL) / m_rate);
+			return ns < NETP_RATE_LIMITER_WAIT_MIN_NS ? NETP_RATE_LIMITER_WAIT_MIN_NS : ns;
+		}
+	};
+}}
+#endif
@@ -48,23 +48,40 @@ namespace netp { namespace traffic {
 
 		repeater_outlet_q_t m_outlets;
 		netp::size_t m_outlets_nbytes;
+		netp::size_t m_inflight; //number of m_outlets (from front) handed to writer
 		repeater_state m_state;
 
 		bool m_buffer_full;
 		bool m_mark_finished;
+		bool m_watch_writability;
+		bool m_writer_writable;
 
 		void _flush_done(int rt) {
+			if (m_state == repeater_state::S_FINISHED) {
+				//pipelined write failed already
+				return;
+			}
+			if (rt == netp::E_CHANNEL_WRITE_BLOCK && m_watch_writability) {
+				//the writer is on our loop, the rejected one is the last outlet handed out, resend it on writability_changed(true)
+				NETP_ASSERT(m_inflight && m_state == repeater_state::S_WRITING);
+				m_writer_writable = false;
+				if (--m_inflight == 0) {
+					m_state = repeater_state::S_IDLE;
+				}
+				return;
+			}
 			if (rt != netp::OK) {
-				NETP_ASSERT(rt != netp::E_CHANNEL_WRITE_BLOCK);
 				event_broker_any::invoke<fn_repeater_error_event_t>(repeater_event::e_write_error, rt);
 				m_state = repeater_state::S_FINISHED;
 				return;
 			}
 
-			NETP_ASSERT(m_outlets.size() && m_state == repeater_state::S_WRITING);
+			NETP_ASSERT(m_outlets.size() && m_inflight && m_state == repeater_state::S_WRITING);
 			m_outlets_nbytes -= m_outlets.front()->len();
 			m_outlets.pop_front();
-			m_state = repeater_state::S_IDLE;
+			if (--m_inflight == 0) {
+				m_state = repeater_state::S_IDLE;
+			}
 
 			if (m_outlets.size()) {
 				_do_flush();
@@ -81,13 +98,17 @@ namespace netp { namespace traffic {
 				event_broker_any::invoke<fn_repeater_event_t>(repeater_event::e_finished);
 			}
 		}
+		//one write in flight by default
+		//with watch_writability, keep writing until the writer reports unwritable
 		void _do_flush() {
 			NETP_ASSERT(m_loop->in_event_loop());
-			if (m_state != repeater_state::S_IDLE) {
-				return;
-			}
-
-			if (m_outlets.size()) {
+			while (m_inflight < m_outlets.size()) {
+				if (m_state == repeater_state::S_FINISHED) {
+					return;
+				}
+				if (m_watch_writability ? !m_writer_writable : (m_inflight != 0)) {
+					return;
+				}
 				NRP<netp::promise<int>> wf = netp::make_ref<netp::promise<int>>();
 				wf->if_done([L = m_loop, r = NRP<_self_t>(this)](int const& rt) {
 					L->execute([r, rt]() {
@@ -95,7 +116,7 @@ namespace netp { namespace traffic {
 					});
 				});
 				m_state = repeater_state::S_WRITING;
-				m_writer->write(m_outlets.front(), wf);
+				m_writer->write(m_outlets[m_inflight++], wf);
 			}
 		}
 
@@ -105,12 +126,40 @@ namespace netp { namespace traffic {
 			m_writer(writer_),
 			m_bufsize(bufsize_>NETP_TRAFFIC_REPEATER_BUF_MAX?NETP_TRAFFIC_REPEATER_BUF_MAX: bufsize_ < NETP_TRAFFIC_REPEATER_BUF_MIN? NETP_TRAFFIC_REPEATER_BUF_MIN:bufsize_),
 			m_outlets_nbytes(0),
+			m_inflight(0),
 			m_state(repeater_state::S_IDLE),
 			m_buffer_full(false),
-			m_mark_finished(false)
+			m_mark_finished(false),
+			m_watch_writability(false),
+			m_writer_writable(true)
 		{
 		}
 
+		//opt-in, the owner forwards the writer's writability_changed to writability_changed()
+		//the writer must run on the loop of the repeater, a write it rejects with E_CHANNEL_WRITE_BLOCK pauses the repeater
+		void watch_writability() {
+			if (!m_loop->in_event_loop()) {
+				m_loop->schedule([rep = NRP<_self_t>(this)]() {
+					rep->watch_writability();
+				});
+				return;
+			}
+			m_watch_writability = true;
+		}
+
+		void writability_changed(bool writable) {
+			if (!m_loop->in_event_loop()) {
+				m_loop->schedule([rep = NRP<_self_t>(this), writable]() {
+					rep->writability_changed(writable);
+				});
+				return;
+			}
+			m_writer_writable = writable;
+			if (writable) {
+				_do_flush();
+			}
+		}
+
 		void relay(NRP<netp::packet> const& outp) {
 			if (!m_loop->in_event_loop()) {
 				m_loop->schedule([rep = NRP<_self_t>(this), outp]() {
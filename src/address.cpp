@@ -211,38 +211,204 @@ namespace netp {
 		return string_t();
 	}
 
+	bool is_ipv6_notation(const char* cstr) {
+		struct in6_addr in6;
+		return ::inet_pton(AF_INET6, cstr, &in6) == 1;
+	}
+
+	string_t ipv6tostr(ipv6_t const& ip) {
+		char addr[INET6_ADDRSTRLEN] = { 0 };
+		const char* addr_cstr = ::inet_ntop(AF_INET6, (void*)&ip, addr, INET6_ADDRSTRLEN);
+		if (NETP_LIKELY(addr_cstr != nullptr)) {
+			return string_t(addr);
+		}
+		return string_t();
+	}
+
+	ipv6_t strtoipv6(const char* str) {
+		ipv6_t ip = { {0} };
+		int rt = ::inet_pton(AF_INET6, str, &ip);
+		NETP_ASSERT(rt == 1);
+		(void)rt;
+		return ip;
+	}
+
 	address::address():
 		m_ipv4(0),
 		m_port(0),
-		m_family(u8_t(NETP_AF_UNSPEC))
+		m_family(u8_t(NETP_AF_UNSPEC)),
+		m_ipv6({ {0} }),
+		m_scope_id(0)
 	{
 	}
 
 	address::address( char const* ip, unsigned short port , int f):
 		m_ipv4(0),
 		m_port(port),
-		m_family(u8_t(f))
+		m_family(u8_t(f)),
+		m_ipv6({ {0} }),
+		m_scope_id(0)
 	{
 		NETP_ASSERT(f < 255);
 		NETP_ASSERT( ip != nullptr && netp::strlen(ip) );
+		if (f == NETP_AF_INET6 || (f == NETP_AF_UNSPEC && is_ipv6_notation(ip))) {
+			m_family = u8_t(NETP_AF_INET6);
+			m_ipv6 = strtoipv6(ip);
+			return;
+		}
 		m_ipv4  = dotiptoip(ip);
 	}
 
+	address::address(ipv6_t const& ip, port_t port, u32_t scope_id) :
+		m_ipv4(0),
+		m_port(port),
+		m_family(u8_t(NETP_AF_INET6)),
+		m_ipv6(ip),
+		m_scope_id(scope_id)
+	{
+	}
+
 	address::address( sockaddr_in const& sockaddr_in_ ):
 		m_ipv4(ntohl(sockaddr_in_.sin_addr.s_addr)),
 		m_port(ntohs(sockaddr_in_.sin_port)),
-		m_family(u8_t(sockaddr_in_.sin_family))
+		m_family(u8_t(sockaddr_in_.sin_family)),
+		m_ipv6({ {0} }),
+		m_scope_id(0)
+	{
+	}
+
+	address::address(sockaddr const* sa, socklen_t len) :
+		m_ipv4(0),
+		m_port(0),
+		m_family(u8_t(sa->sa_family)),
+		m_ipv6({ {0} }),
+		m_scope_id(0)
 	{
+		switch (sa->sa_family) {
+		case NETP_AF_INET6:
+		{
+			NETP_ASSERT(len >= socklen_t(sizeof(sockaddr_in6)));
+			sockaddr_in6 const* in6 = reinterpret_cast<sockaddr_in6 const*>(sa);
+			::memcpy(&m_ipv6, &in6->sin6_addr, sizeof(m_ipv6));
+			m_port = ntohs(in6->sin6_port);
+			m_scope_id = in6->sin6_scope_id;
+		}
+		break;
+		case NETP_AF_INET:
+		{
+			NETP_ASSERT(len >= socklen_t(sizeof(sockaddr_in)));
+			sockaddr_in const* in4 = reinterpret_cast<sockaddr_in const*>(sa);
+			m_ipv4 = ntohl(in4->sin_addr.s_addr);
+			m_port = ntohs(in4->sin_port);
+		}
+		break;
+#ifndef _NETP_WIN
+		case NETP_AF_UNIX:
+		{
+			//unnamed (autobind not done, or peer of a connected stream) if len == sizeof(sa_family_t)
+			sockaddr_un const* un = reinterpret_cast<sockaddr_un const*>(sa);
+			const netp::size_t off = offsetof(sockaddr_un, sun_path);
+			if (len > socklen_t(off)) {
+				netp::size_t plen = len - off;
+				if (un->sun_path[0] != '\0') {
+					//pathname, might include the trailing '\0'
+					plen = netp::strlen(un->sun_path);
+				}
+				if (plen > 0) {
+					m_unix = netp::make_ref<address_unix_path>(un->sun_path, plen);
+				}
+			}
+		}
+		break;
+#endif
+		default:
+		{
+			(void)len;
+		}
+		}
+	}
+
+	address address::from_unix_path(const char* path, netp::size_t len) {
+		address addr;
+		addr.m_family = u8_t(NETP_AF_UNIX);
+		if (len == 0) {
+			return addr;
+		}
+		addr.m_unix = netp::make_ref<address_unix_path>(path, len);
+		if (path[0] == '@') {
+			addr.m_unix->path[0] = '\0';
+		}
+		return addr;
+	}
+
+	string_t const& address::unix_path() const {
+		static const string_t __unnamed;
+		return m_unix == nullptr ? __unnamed : m_unix->path;
+	}
+
+	socklen_t address::to_sockaddr(sockaddr_storage& ss) const {
+		switch (m_family) {
+		case NETP_AF_INET6:
+		{
+			sockaddr_in6* in6 = reinterpret_cast<sockaddr_in6*>(&ss);
+			::memset(in6, 0, sizeof(sockaddr_in6));
+			in6->sin6_family = u16_t(NETP_AF_INET6);
+			in6->sin6_port = nport();
+			::memcpy(&in6->sin6_addr, &m_ipv6, sizeof(m_ipv6));
+			in6->sin6_scope_id = m_scope_id;
+			return sizeof(sockaddr_in6);
+		}
+		break;
+#ifndef _NETP_WIN
+		case NETP_AF_UNIX:
+		{
+			sockaddr_un* un = reinterpret_cast<sockaddr_un*>(&ss);
+			//pathname needs room for the trailing '\0'
+			string_t const& path = unix_path();
+			const netp::size_t maxlen = is_unix_abstract() ? NETP_UNIX_PATH_MAX : NETP_UNIX_PATH_MAX-1;
+			if (path.length() > maxlen) {
+				return 0;
+			}
+			::memset(un, 0, sizeof(sockaddr_un));
+			un->sun_family = u16_t(NETP_AF_UNIX);
+			::memcpy(un->sun_path, path.data(), path.length());
+			//empty path: sizeof(sa_family_t), linux autobind to an abstract name on bind
+			return socklen_t(offsetof(sockaddr_un, sun_path) + path.length() + (is_unix_abstract() || path.empty() ? 0 : 1));
+		}
+		break;
+#endif
+		default:
+		{
+			//ipv4, m_family is copied as is
+			sockaddr_in* in4 = reinterpret_cast<sockaddr_in*>(&ss);
+			::memset(in4, 0, sizeof(sockaddr_in));
+			in4->sin_family = u16_t(m_family);
+			in4->sin_port = nport();
+			in4->sin_addr.s_addr = nipv4();
+			return sizeof(sockaddr_in);
+		}
+		}
 	}
 
 	address::~address() {
 	}
 
 	const string_t address::dotip() const {
+		if (m_family == NETP_AF_INET6) {
+			return ipv6tostr(m_ipv6);
+		}
 		return ipv4todotip(m_ipv4);
 	}
 
 	string_t address::to_string() const {
+		if (m_family == NETP_AF_UNIX) {
+			if (is_unix_abstract()) {
+				return "unix:@" + unix_path().substr(1);
+			}
+			return "unix:" + unix_path();
+		} else if (m_family == NETP_AF_INET6) {
+			return "[" + dotip() + "]:" + netp::to_string(hport());
+		}
 		char info[32] = { 0 };
 		int rtval = snprintf(const_cast<char*>(info), sizeof(info) / sizeof(info[0]), "%s:%d", dotip().c_str(), hport());
 		NETP_ASSERT(rtval > 0);
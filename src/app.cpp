@@ -342,6 +342,7 @@ namespace netp {
 	}
 
 	void app::___event_loop_init() {
+		__allocator_cfg_init();
 		netp::io_event_loop_group::instance()->init(m_cfg.poller_count, m_cfg.poller_cfgs);
 		NETP_INFO("[app]init loop done");
 #ifdef _NETP_WIN
@@ -371,6 +372,38 @@ namespace netp {
 			exit(dnsp->get());
 		}
 		NETP_INFO("[app]init dns done");
+		__allocator_stats_init();
+	}
+
+	void app::__allocator_cfg_init() {
+#ifdef USE_POOL
+		//before the loops are launched, they read the decay interval at launch
+		for (u8_t t = 0; t < TABLE::T_COUNT; ++t) {
+			pool_align_allocator::cfg_entries_limit(t, m_cfg.allocator_entries_limit[t]);
+		}
+		pool_align_allocator::cfg_decay_interval(m_cfg.allocator_decay_interval);
+#endif
+	}
+
+	void app::__allocator_stats_init() {
+#ifdef USE_POOL
+		if (m_cfg.allocator_stats_interval == 0) {
+			return;
+		}
+		NRP<io_event_loop> L = io_event_loop_group::instance()->next();
+		//the timer lives in the timer broker of L, a raw L does not hold the loop from terminating, the relaunch fails once it is terminated
+		NRP<netp::timer> tm = netp::make_ref<netp::timer>(std::chrono::milliseconds(m_cfg.allocator_stats_interval), [hook = m_cfg.allocator_stats_hook, L = L.get()](NRP<netp::timer> const& t) {
+			pool_align_allocator_stats stats;
+			pool_align_allocator::stats_all(stats);
+			if (hook != nullptr) {
+				hook(stats);
+			} else {
+				pool_align_allocator::stats_dump(stats);
+			}
+			L->launch(t, netp::make_ref<netp::promise<int>>());
+		});
+		L->launch(tm, netp::make_ref<netp::promise<int>>());
+#endif
 	}
 
 	void app::___event_loop_deinit() {
@@ -22,6 +22,15 @@
 		(void)err; \
 	}
 
+#define VOID_FIRE_HANDLER_DEFAULT_IMPL_BOOL_1(NAME,FLAG,HANDLER_NAME) \
+	void HANDLER_NAME::NAME(NRP<channel_handler_context> const& ctx, bool b) { \
+		/*ctx->fire_##NAME(b); */\
+		NETP_ASSERT(CH_H_FLAG & FLAG); \
+		NETP_THROW(#FLAG"MUST IMPL ITS OWN "#NAME); \
+		(void)ctx; \
+		(void)b; \
+	}
+
 #define VOID_HANDLER_DEFAULT_IMPL_0(NAME,FLAG,HANDLER_NAME) \
 	void HANDLER_NAME::NAME(NRP<channel_handler_context> const& ctx) { \
 		/*ctx->NAME(); */\
@@ -47,6 +56,7 @@ namespace netp {
 	VOID_FIRE_HANDLER_DEFAULT_IMPL_INT_1(error, CH_ACTIVITY_ERROR, channel_handler_abstract)
 	VOID_FIRE_HANDLER_DEFAULT_IMPL_0(read_closed, CH_ACTIVITY_READ_CLOSED, channel_handler_abstract)
 	VOID_FIRE_HANDLER_DEFAULT_IMPL_0(write_closed, CH_ACTIVITY_WRITE_CLOSED, channel_handler_abstract)
+	VOID_FIRE_HANDLER_DEFAULT_IMPL_BOOL_1(writability_changed, CH_ACTIVITY_WRITABILITY_CHANGED, channel_handler_abstract)
 	
 	//VOID_FIRE_HANDLER_DEFAULT_IMPL_0(write_block, CH_ACTIVITY_WRITE_BLOCK, channel_handler_abstract)
 	//VOID_FIRE_HANDLER_DEFAULT_IMPL_0(write_unblock, CH_ACTIVITY_WRITE_UNBLOCK, channel_handler_abstract)
@@ -137,6 +147,12 @@ namespace netp {
 		(void)ctx;
 	}
 
+	void channel_handler_tail::writability_changed(NRP<channel_handler_context> const& ctx, bool writable) {
+		NETP_TRACE_CHANNEL("[#%d][tail]channel writability changed: %d, no action", ctx->ch->ch_id(), writable);
+		(void)ctx;
+		(void)writable;
+	}
+
 	void channel_handler_tail::read(NRP<channel_handler_context> const& ctx, NRP<packet> const& income) {
 		//NETP_ASSERT(ctx->ch != nullptr);
 		NETP_ERR("[#%d][tail]channel read, we reach the end of the pipeline , please check your pipeline configure, no action", ctx->ch->ch_id() );
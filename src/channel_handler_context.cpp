@@ -5,7 +5,11 @@
 namespace netp {
 
 	channel_handler_context::channel_handler_context(NRP<netp::channel> const& ch_, NRP<channel_handler_abstract> const& h):
-		L(ch_->L), ch(ch_), H_FLAG(h->CH_H_FLAG), P(nullptr), N(nullptr), H(h)
+		L(ch_->L), ch(ch_), H_FLAG(h->CH_H_FLAG), H_HEADROOM(h->CH_H_HEADROOM), P(nullptr), N(nullptr), H(h)
 	{
 	}
+
+	void channel_handler_context::__write_failed(NRP<promise<int>> const& chp, int code) const {
+		ch->ch_write_failed(chp, code);
+	}
 }
\ No newline at end of file
@@ -5,7 +5,8 @@ namespace netp {
 
 	channel_pipeline::channel_pipeline(NRP<channel> const& ch):
 		m_loop(ch->L),
-		m_ch(ch)
+		m_ch(ch),
+		m_headroom(0)
 	{
 		NETP_TRACE_CHANNEL("channel_pipeline::channel_pipeline()");
 	}
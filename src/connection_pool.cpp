@@ -0,0 +1,318 @@
+#include <netp/core.hpp>
+#include <netp/logger_broker.hpp>
+#include <netp/connection_pool.hpp>
+
+namespace netp {
+
+	connection_pool::connection_pool(NRP<connection_pool_cfg> const& cfg, NRP<io_event_loop> const& L_) :
+		m_L(L_),
+		m_cfg(cfg),
+		m_closed(false)
+	{
+		NETP_ASSERT(m_cfg != nullptr);
+		NETP_ASSERT(m_cfg->max_per_host > 0);
+		if (m_cfg->sock_cfg == nullptr) {
+			m_cfg->sock_cfg = netp::make_ref<socket_cfg>();
+		}
+	}
+
+	connection_pool::~connection_pool() {
+		for (loop_pool_map_t::iterator it = m_loop_pools.begin(); it != m_loop_pools.end(); ++it) {
+			NETP_ASSERT(it->second->owners.size() == 0);
+		}
+	}
+
+	NRP<connection_pool::loop_pool> connection_pool::_loop_pool(NRP<io_event_loop> const& L) {
+		lock_guard<spin_mutex> lg(m_mtx);
+		loop_pool_map_t::iterator it = m_loop_pools.find(L.get());
+		if (it != m_loop_pools.end()) {
+			return it->second;
+		}
+		NRP<loop_pool> lp = netp::make_ref<loop_pool>(L, m_closed);
+		m_loop_pools.insert({ L.get(), lp });
+		return lp;
+	}
+
+	NRP<channel_dial_promise> connection_pool::acquire(string_t const& url) {
+		NRP<io_event_loop> L = m_L;
+		if (L == nullptr) {
+			L = io_event_loop::current();
+			if (L == nullptr) {
+				L = io_event_loop_group::instance()->next();
+			}
+		}
+		NRP<loop_pool> lp = _loop_pool(L);
+		NRP<channel_dial_promise> dp = netp::make_ref<channel_dial_promise>();
+		L->execute([pool = NRP<connection_pool>(this), lp, url, dp]() {
+			pool->_do_acquire(lp, url, dp);
+		});
+		return dp;
+	}
+
+	void connection_pool::release(NRP<channel> const& ch, bool reuse) {
+		NETP_ASSERT(ch != nullptr);
+		NRP<loop_pool> lp = _loop_pool(ch->L);
+		ch->L->execute([pool = NRP<connection_pool>(this), lp, ch, reuse]() {
+			pool->_do_release(lp, ch, reuse);
+		});
+	}
+
+	void connection_pool::close() {
+		std::vector<NRP<loop_pool>> lps;
+		{
+			lock_guard<spin_mutex> lg(m_mtx);
+			m_closed = true;
+			for (loop_pool_map_t::iterator it = m_loop_pools.begin(); it != m_loop_pools.end(); ++it) {
+				lps.push_back(it->second);
+			}
+		}
+		for (netp::size_t i = 0; i < lps.size(); ++i) {
+			lps[i]->L->execute([pool = NRP<connection_pool>(this), lp = lps[i]]() {
+				pool->_do_close(lp);
+			});
+		}
+	}
+
+	bool connection_pool::_is_healthy(NRP<channel> const& ch) {
+		const int unhealthy = int(channel_flag::F_READ_ERROR) | int(channel_flag::F_READ_SHUTDOWNING) | int(channel_flag::F_READ_SHUTDOWN) |
+			int(channel_flag::F_WRITE_ERROR) | int(channel_flag::F_WRITE_SHUTDOWNING) | int(channel_flag::F_WRITE_SHUTDOWN) | int(channel_flag::F_WRITE_SHUTDOWN_PENDING) |
+			int(channel_flag::F_FIN_RECEIVED) | int(channel_flag::F_CLOSE_PENDING) | int(channel_flag::F_CLOSING) | int(channel_flag::F_CLOSED);
+		if ((ch->ch_flag() & unhealthy) || !(ch->ch_flag() & int(channel_flag::F_CONNECTED))) {
+			return false;
+		}
+		return m_cfg->health_check == nullptr || m_cfg->health_check(ch);
+	}
+
+	void connection_pool::_do_acquire(NRP<loop_pool> const& lp, string_t const& url, NRP<channel_dial_promise> const& dp) {
+		NETP_ASSERT(lp->L->in_event_loop());
+		if (lp->closed) {
+			dp->set(std::make_tuple(netp::E_CONNECTION_POOL_CLOSED, nullptr));
+			return;
+		}
+
+		NRP<host_entry> h = _host(lp, url);
+		//most recently released first, the least likely to have been closed by the peer
+		while (h->idles.size()) {
+			NRP<channel> ch = h->idles.back().ch;
+			h->idles.pop_back();
+			if (_is_healthy(ch)) {
+				dp->set(std::make_tuple(netp::OK, ch));
+				return;
+			}
+			NETP_TRACE_SOCKET("[connection_pool][%s]drop unhealthy idle channel: %s", url.c_str(), ch->ch_info().c_str());
+			//account it here, _ch_closed skips it, h stays in hosts as we dial or wait on it right below
+			lp->owners.erase(ch.get());
+			NETP_ASSERT(h->nconn > 0);
+			--h->nconn;
+			ch->ch_close();
+		}
+
+		if (h->nconn < m_cfg->max_per_host) {
+			_dial(lp, h, dp);
+			return;
+		}
+
+		if (h->waitings.size() >= m_cfg->max_waiting_per_host) {
+			dp->set(std::make_tuple(netp::E_CONNECTION_POOL_EXHAUSTED, nullptr));
+			return;
+		}
+		h->waitings.push_back(dp);
+	}
+
+	NRP<connection_pool::host_entry> connection_pool::_host(NRP<loop_pool> const& lp, string_t const& url) {
+		host_map_t::iterator it = lp->hosts.find(url);
+		if (it != lp->hosts.end()) {
+			return it->second;
+		}
+		NRP<host_entry> h = netp::make_ref<host_entry>(url);
+		lp->hosts.insert({ url, h });
+		return h;
+	}
+
+	void connection_pool::_dial(NRP<loop_pool> const& lp, NRP<host_entry> const& h, NRP<channel_dial_promise> const& dp) {
+		NETP_ASSERT(lp->L->in_event_loop());
+		++h->nconn;
+		++h->ndialing;
+
+		NRP<socket_cfg> cfg = m_cfg->sock_cfg->clone();
+		cfg->L = lp->L;
+		NRP<channel_dial_promise> ch_dp = netp::make_ref<channel_dial_promise>();
+		ch_dp->if_done([pool = NRP<connection_pool>(this), lp, h, dp](std::tuple<int, NRP<channel>> const& tupc) {
+			pool->_dial_done(lp, h, dp, tupc);
+		});
+		socket::do_dial(h->url.c_str(), h->url.length(), m_cfg->initializer, ch_dp, cfg);
+	}
+
+	void connection_pool::_dial_done(NRP<loop_pool> const& lp, NRP<host_entry> const& h, NRP<channel_dial_promise> const& dp, std::tuple<int, NRP<channel>> const& tupc) {
+		NETP_ASSERT(lp->L->in_event_loop());
+		NETP_ASSERT(h->ndialing > 0 && h->nconn > 0);
+		--h->ndialing;
+
+		const int rt = std::get<0>(tupc);
+		if (rt != netp::OK) {
+			--h->nconn;
+			dp->set(tupc);
+			//let the waitings try their own dial, the destination might be back
+			_slot_available(lp, h);
+			return;
+		}
+
+		NRP<channel> const& ch = std::get<1>(tupc);
+		NETP_ASSERT(ch->L == lp->L);
+		lp->owners.insert({ ch.get(), h });
+		ch->ch_close_promise()->if_done([pool = NRP<connection_pool>(this), lp, h, ch](int const&) {
+			pool->_ch_closed(lp, h, ch);
+		});
+
+		if (lp->closed) {
+			dp->set(std::make_tuple(netp::E_CONNECTION_POOL_CLOSED, nullptr));
+			ch->ch_close();
+			return;
+		}
+		dp->set(tupc);
+	}
+
+	void connection_pool::_ch_closed(NRP<loop_pool> const& lp, NRP<host_entry> const& h, NRP<channel> const& ch) {
+		NETP_ASSERT(lp->L->in_event_loop());
+		owner_map_t::iterator it = lp->owners.find(ch.get());
+		if (it == lp->owners.end()) {
+			//dropped by _do_acquire, accounted there
+			return;
+		}
+		lp->owners.erase(it);
+
+		for (idle_list_t::iterator iit = h->idles.begin(); iit != h->idles.end(); ++iit) {
+			if (iit->ch == ch) {
+				h->idles.erase(iit);
+				break;
+			}
+		}
+		NETP_ASSERT(h->nconn > 0);
+		--h->nconn;
+		_slot_available(lp, h);
+	}
+
+	void connection_pool::_slot_available(NRP<loop_pool> const& lp, NRP<host_entry> const& h) {
+		while (h->waitings.size() && h->nconn < m_cfg->max_per_host) {
+			NRP<channel_dial_promise> dp = h->waitings.front();
+			h->waitings.pop_front();
+			_dial(lp, h, dp);
+		}
+		if (h->nconn == 0 && h->waitings.size() == 0) {
+			lp->hosts.erase(h->url);
+		}
+	}
+
+	void connection_pool::_do_release(NRP<loop_pool> const& lp, NRP<channel> const& ch, bool reuse) {
+		NETP_ASSERT(lp->L->in_event_loop());
+		owner_map_t::iterator it = lp->owners.find(ch.get());
+		if (it == lp->owners.end()) {
+			//closed already, accounted in _ch_closed
+			NETP_ASSERT(ch->ch_flag() & int(channel_flag::F_CLOSED));
+			return;
+		}
+
+		NRP<host_entry> h = it->second;
+		if (lp->closed || !reuse || !_is_healthy(ch)) {
+			ch->ch_close();
+			return;
+		}
+
+		if (h->waitings.size()) {
+			NRP<channel_dial_promise> dp = h->waitings.front();
+			h->waitings.pop_front();
+			dp->set(std::make_tuple(netp::OK, ch));
+			return;
+		}
+
+		if (h->idles.size() >= m_cfg->max_idle_per_host) {
+			ch->ch_close();
+			return;
+		}
+		h->idles.push_back({ ch, timer_clock_t::now() });
+		_idle_timer_check(lp);
+	}
+
+	void connection_pool::_do_close(NRP<loop_pool> const& lp) {
+		NETP_ASSERT(lp->L->in_event_loop());
+		if (lp->closed) {
+			return;
+		}
+		lp->closed = true;
+
+		std::vector<NRP<channel>> idles;
+		std::vector<NRP<channel_dial_promise>> waitings;
+		for (host_map_t::iterator it = lp->hosts.begin(); it != lp->hosts.end(); ++it) {
+			NRP<host_entry> const& h = it->second;
+			for (idle_list_t::iterator iit = h->idles.begin(); iit != h->idles.end(); ++iit) {
+				idles.push_back(iit->ch);
+			}
+			waitings.insert(waitings.end(), h->waitings.begin(), h->waitings.end());
+			h->waitings.clear();
+		}
+		for (netp::size_t i = 0; i < waitings.size(); ++i) {
+			waitings[i]->set(std::make_tuple(netp::E_CONNECTION_POOL_CLOSED, nullptr));
+		}
+		for (netp::size_t i = 0; i < idles.size(); ++i) {
+			idles[i]->ch_close();
+		}
+	}
+
+	void connection_pool::_idle_timer_check(NRP<loop_pool> const& lp) {
+		if (lp->tm_idle != nullptr || (m_cfg->idle_timeout == 0 && m_cfg->health_check_interval == 0)) {
+			return;
+		}
+		u32_t interval = m_cfg->idle_timeout >> 1;
+		if (interval == 0 || (m_cfg->health_check_interval != 0 && m_cfg->health_check_interval < interval)) {
+			interval = m_cfg->health_check_interval;
+		}
+		if (interval < NETP_CONNECTION_POOL_IDLE_CHECK_MIN) {
+			interval = NETP_CONNECTION_POOL_IDLE_CHECK_MIN;
+		}
+		lp->tm_idle = netp::make_ref<netp::timer>(std::chrono::milliseconds(interval), &connection_pool::_tmcb_idle, NRP<connection_pool>(this), lp, std::placeholders::_1);
+		lp->L->launch(lp->tm_idle);
+	}
+
+	//close the expired and, if health_check_interval is set, the unhealthy idle channels
+	void connection_pool::_tmcb_idle(NRP<loop_pool> const& lp, NRP<timer> const& t) {
+		NETP_ASSERT(lp->L->in_event_loop());
+		NETP_ASSERT(t.get() == lp->tm_idle.get());
+		const timer_timepoint_t expire = timer_clock_t::now() - std::chrono::milliseconds(m_cfg->idle_timeout);
+		const bool check_health = m_cfg->health_check_interval != 0;
+
+		std::vector<NRP<channel>> dropped;
+		bool has_idle = false;
+		for (host_map_t::iterator it = lp->hosts.begin(); it != lp->hosts.end(); ++it) {
+			idle_list_t& idles = it->second->idles;
+			//released in time order, the oldest is at front
+			while (m_cfg->idle_timeout != 0 && idles.size() && idles.front().since <= expire) {
+				NETP_TRACE_SOCKET("[connection_pool]close expired idle channel: %s", idles.front().ch->ch_info().c_str());
+				dropped.push_back(idles.front().ch);
+				idles.pop_front();
+			}
+			if (check_health) {
+				idle_list_t::iterator iit = idles.begin();
+				while (iit != idles.end()) {
+					if (_is_healthy(iit->ch)) {
+						++iit;
+						continue;
+					}
+					NETP_TRACE_SOCKET("[connection_pool]close unhealthy idle channel: %s", iit->ch->ch_info().c_str());
+					dropped.push_back(iit->ch);
+					iit = idles.erase(iit);
+				}
+			}
+			has_idle = has_idle || idles.size();
+		}
+
+		for (netp::size_t i = 0; i < dropped.size(); ++i) {
+			dropped[i]->ch_close();
+		}
+
+		if (has_idle && !lp->closed) {
+			lp->L->launch(t);
+		} else {
+			lp->tm_idle = nullptr;
+		}
+	}
+}
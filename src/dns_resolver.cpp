@@ -199,6 +199,37 @@ namespace netp {
 		NETP_DELETE(adq);
 	}
 
+	static void dns_submit_a6_cb(struct dns_ctx* ctx, struct dns_rr_a6* result, void* data) {
+		NETP_ASSERT(ctx != NULL);
+		NETP_ASSERT(data != NULL);
+		async_dns_query6* adq = (async_dns_query6*)data;
+		NETP_ASSERT(adq->dnsquery_p != nullptr);
+		if (result == NULL) {
+			int code = dns_status(ctx);
+			NETP_ASSERT(code != netp::OK);
+			NETP_ASSERT(code >= ::DNS_E_BADQUERY && code <= ::DNS_E_TEMPFAIL);
+			NETP_ERR("[dns_resolver]dns resolve6 failed: %d:%s", code, dns_strerror(code));
+			adq->dnsquery_p->set(std::make_tuple(dns_error_map[NETP_ABS(code)], std::vector<ipv6_t, netp::allocator<ipv6_t>>()));
+			NETP_DELETE(adq);
+			return;
+		}
+
+		std::vector<ipv6_t, netp::allocator<ipv6_t>> ipv6s;
+		for (int i = 0; i < result->dnsa6_nrr; ++i) {
+			ipv6_t ip;
+			::memcpy(&ip, &result->dnsa6_addr[i], sizeof(ip));
+			ipv6s.push_back(ip);
+		}
+
+		if (ipv6s.size()) {
+			adq->dnsquery_p->set(std::make_tuple(netp::OK, ipv6s));
+		} else {
+			adq->dnsquery_p->set(std::make_tuple(netp::E_DNS_DOMAIN_NO_DATA, ipv6s));
+		}
+		dns_free_ptr(result);
+		NETP_DELETE(adq);
+	}
+
 	void dns_resolver::_do_resolve(string_t const& domain, NRP<dns_query_promise> const& p) {
 		NETP_ASSERT(m_loop->in_event_loop());
 		if ( (m_flag& dns_resolver_flag::f_running) == 0) {
@@ -229,6 +260,44 @@ namespace netp {
 		}
 	}
 
+	void dns_resolver::_do_resolve6(string_t const& domain, NRP<dns_query6_promise> const& p) {
+		NETP_ASSERT(m_loop->in_event_loop());
+		if ((m_flag & dns_resolver_flag::f_running) == 0) {
+			p->set(std::make_tuple(netp::E_INVALID_STATE, std::vector<ipv6_t, netp::allocator<ipv6_t>>()));
+			return;
+		}
+		NETP_ASSERT(m_dns_ctx != NULL);
+
+		async_dns_query6* adq = new async_dns_query6();
+		adq->dnsr = this;
+		adq->dnsquery_p = p;
+		struct dns_query* q = dns_submit_a6(m_dns_ctx, domain.c_str(), 0, dns_submit_a6_cb, (void*)adq);
+		if (q == NULL) {
+			NETP_DELETE(adq);
+
+			int code = dns_status(m_dns_ctx);
+			NETP_ASSERT(code != netp::OK);
+			NETP_ASSERT(code >= ::DNS_E_BADQUERY && code <= ::DNS_E_TEMPFAIL);
+			NETP_ERR("[dns_resolver]dns resolve6 failed: %d:%s", code, dns_strerror(code));
+			p->set(std::make_tuple(dns_error_map[NETP_ABS(code)], std::vector<ipv6_t, netp::allocator<ipv6_t>>()));
+			return;
+		}
+
+		dns_timeouts(m_dns_ctx, -1, 0);
+		if ((m_flag & f_timeout_timer) == 0) {
+			m_flag |= f_timeout_timer;
+			m_loop->launch(m_tm_dnstimeout, netp::make_ref<netp::promise<int>>());
+		}
+	}
+
+	NRP<dns_query6_promise> dns_resolver::resolve6(string_t const& domain) {
+		NRP<dns_query6_promise> dnsp = netp::make_ref<dns_query6_promise>();
+		m_loop->execute([dnsr = this, domain, dnsp]() {
+			dnsr->_do_resolve6(domain, dnsp);
+		});
+		return dnsp;
+	}
+
 	NRP<dns_query_promise> dns_resolver::resolve(string_t const& domain) {
 		NRP<dns_query_promise> dnsp = netp::make_ref<dns_query_promise>();
 		m_loop->execute([dnsr=this, domain, dnsp]() {
@@ -37,7 +37,7 @@ namespace netp { namespace handler {
 			case parse_state::S_READ_CONTENT:
 			{
 				if (_income->len() >= m_size) {
-					NRP<netp::packet> __income_for_fire = netp::make_ref<netp::packet>(_income->head(), m_size);
+					NRP<netp::packet> __income_for_fire = _income->slice(0, m_size);
 					_income->skip(m_size);
 					ctx->fire_read(__income_for_fire);
 					m_state = parse_state::S_READ_LEN;
@@ -53,6 +53,12 @@ namespace netp { namespace handler {
 	}
 
 	void hlen::write(NRP<channel_handler_context> const& ctx, NRP<packet> const& outlet, NRP<promise<int>> const& chp) {
+		//in place only if nobody else sees the packet, the writer might keep it for another write, a slice shares the bytes left of its head
+		if (outlet.ref_count() == 1 && !outlet->is_shared()) {
+			outlet->write_left<u32_t>(outlet->len() & 0xFFFFFFFF);
+			ctx->write(outlet, chp);
+			return;
+		}
 		NRP<netp::packet> lenoutlet = netp::make_ref<netp::packet>(outlet->head(), outlet->len());
 		lenoutlet->write_left<u32_t>(outlet->len() & 0xFFFFFFFF);
 		ctx->write(lenoutlet, chp);
@@ -9,6 +9,8 @@ namespace netp { namespace handler {
 		NETP_ASSERT(m_http_parser == nullptr);
 		m_http_parser = netp::make_ref<netp::http::parser>();
 		m_http_parser->init(netp::http::HPT_BOTH);
+		//the parser replaces it when it is full and still held by earlier messages
+		m_http_parser->arena = m_arena_bytes != 0 ? netp::make_ref<netp::bump_arena>(m_arena_bytes) : nullptr;
 
 		if (NETP_UNLIKELY(is_httpu)) {
 			m_http_parser->on_headers_complete = std::bind(&http::http_on_headers_complete_from, NRP<http>(this), std::placeholders::_1, std::placeholders::_2);
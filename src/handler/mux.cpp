@@ -19,7 +19,7 @@ namespace netp { namespace handler {
 			//remote fin not send and local write not error, we have to report wnd to remote
 			NRP<packet> ufp = mux_stream_make_frame(m_id, FRAME_UWND, m_rcv_data_inc, 0);
 			m_rcv_data_inc = 0;//reset
-			m_transport_mux->__do_mux_write(std::move(ufp), netp::make_ref<netp::promise<int>>());
+			m_transport_mux->__do_mux_write(std::move(ufp), nullptr);
 		}
 	}
 
@@ -35,7 +35,7 @@ namespace netp { namespace handler {
 		}
 	}
 
-	void mux_stream::_ch_flush_done(const int aiort_, u16_t wt) {
+	void mux_stream::_ch_flush_done(const int aiort_, u16_t wt, u8_t flag) {
 		NETP_ASSERT(L->in_event_loop());
 		NETP_ASSERT(m_chflag & int(channel_flag::F_WRITING));
 		NETP_ASSERT( (m_chflag& int(channel_flag::F_CLOSED)) ==0 );
@@ -46,12 +46,11 @@ namespace netp { namespace handler {
 				NETP_ASSERT(m_outlets_q.size());
 				const mux_stream_outbound_entry& f_entry = m_outlets_q.front();
 
-				mux_stream_frame_header* fh = (mux_stream_frame_header*)f_entry.data->head();
-				NETP_ASSERT(fh->H.dlen == wt); //test check
-				NETP_ASSERT(m_snd_dynamic >= (fh->H.dlen));
+				//the transport may prepend its own header in place, do not read the frame back
+				NETP_ASSERT(m_snd_dynamic >= wt);
 				m_snd_dynamic -= wt;
 
-				if ((fh->H.flag) & FRAME_FIN) {
+				if (flag & FRAME_FIN) {
 					NETP_TRACE_STREAM("[muxs][s%u][fin]write done", m_id);
 					NETP_ASSERT((m_chflag & int(channel_flag::F_WRITE_SHUTDOWN_PENDING)) || (m_chflag & int(channel_flag::F_CLOSE_PENDING)));
 				}
@@ -60,6 +59,10 @@ namespace netp { namespace handler {
 					f_entry.wp->set(netp::OK);
 				}
 				m_outlets_q.pop();
+				NETP_ASSERT(m_outlets_q_nbytes >= wt);
+				m_outlets_q_nbytes -= wt;
+				//handler might write in writability_changed, F_WRITING keeps it queued
+				ch_check_writability(m_outlets_q_nbytes);
 				m_chflag &= ~int(channel_flag::F_WRITING);
 
 				if (m_outlets_q.empty()) {
@@ -89,7 +92,7 @@ namespace netp { namespace handler {
 			mux_stream_outbound_entry& f_entry = m_outlets_q.front();
 			mux_stream_frame_header* fh = (mux_stream_frame_header*)f_entry.data->head();
 			if (fh->H.dlen > m_snd_dynamic) {
-				NETP_TRACE_STREAM("[muxs][s%u]stream write block, set block,m_snd_wnd: %u, queue bytes: %u, m_snd_dynamic: %u, incoming: %u", m_id, m_snd_wnd, m_outlets_q_nbytes, m_snd_dynamic, f.data->len());
+				NETP_TRACE_STREAM("[muxs][s%u]stream write block, set block,m_snd_wnd: %u, queue bytes: %u, m_snd_dynamic: %u, incoming: %u", m_id, m_snd_wnd, m_outlets_q_nbytes, m_snd_dynamic, fh->H.dlen);
 				m_chflag |= int(channel_flag::F_BDLIMIT);
 				return;
 			}
@@ -110,9 +113,9 @@ namespace netp { namespace handler {
 			}
 
 			m_chflag |= int(channel_flag::F_WRITING);
-			NRP<promise<int>> write_p = netp::make_ref<netp::promise<int>>();
-			write_p->if_done([muxs = NRP<mux_stream>(this),wt=fh->H.dlen](int const& rt) {
-				muxs->_ch_flush_done(rt,wt);
+			NRP<loop_promise<int>> write_p = netp::make_ref<netp::loop_promise<int>>();
+			write_p->if_done([muxs = NRP<mux_stream>(this),wt=fh->H.dlen, flag=fh->H.flag](int const& rt) {
+				muxs->_ch_flush_done(rt,wt,flag);
 			});
 
 			m_transport_mux->__do_mux_write(f_entry.data, write_p);
@@ -125,7 +128,7 @@ namespace netp { namespace handler {
 
 		ch_set_active();
 		m_chflag |= int(channel_flag::F_CONNECTING);
-		NRP<promise<int>> write_p = netp::make_ref<promise<int>>();
+		NRP<loop_promise<int>> write_p = netp::make_ref<loop_promise<int>>();
 		write_p->if_done([s = NRP<mux_stream>(this), initializer, dialp](int const& rt) {
 			s->L->execute([s, initializer, dialp, rt]() {
 				if (rt != netp::OK) {
@@ -160,7 +163,9 @@ namespace netp { namespace handler {
 		m_rcv_data_inc(0),
 		m_snd_dynamic(0),
 		m_frame_data_size_max(u32_t(mux_->m_frame_data_size_max)),
+		m_frame_headroom(NETP_MUX_STREAM_FRAME_HEADER_LEN + mux_->m_transport_ctx->headroom()),
 		m_transport_mux(mux_),
+		m_outlets_q_nbytes(0),
 		m_fin_enqueue_done(false)
 	{
 		NETP_TRACE_STREAM("[s%u]mux_stream::mux_stream()", m_id);
@@ -220,7 +225,7 @@ namespace netp { namespace handler {
 				m_rcv_data_inc += u32_t(data->len());
 
 				//this might be the last reply from local to remote
-				m_transport_mux->__do_mux_write(mux_stream_make_frame(m_id, FRAME_RST, 0, 0), netp::make_ref<netp::promise<int>>());
+				m_transport_mux->__do_mux_write(mux_stream_make_frame(m_id, FRAME_RST, 0, 0), nullptr);
 				NETP_TRACE_STREAM("[muxs][s%u][data]nbytes, fin received already,ignore data, and reply a rst", m_id, data->len());
 				break;
 			}
@@ -308,7 +313,9 @@ namespace netp { namespace handler {
 
 		if (rt == netp::OK) {
 			NETP_ASSERT(m_entries_lastit != m_entries.end());
-			m_entries_lastit->wp->set(netp::OK);
+			if (m_entries_lastit->wp != nullptr) {
+				m_entries_lastit->wp->set(netp::OK);
+			}
 			if (m_entries_lastit == m_entries_writeit) {
 				m_entries_writeit = m_entries_lastit_prev;
 			}
@@ -367,9 +374,11 @@ namespace netp { namespace handler {
 		m_transport_ctx->write(m_entries_lastit->data, std::move(wp_));
 	}
 
-	void mux::__do_mux_write(NRP<netp::packet> const& outlet, NRP<netp::promise<int>> const& wp) {
+	void mux::__do_mux_write(NRP<netp::packet> const& outlet, NRP<netp::loop_promise<int>> const& wp) {
 		if (m_write_state == mux_transport_write_state::S_CLOSED) {
-			wp->set(netp::E_CHANNEL_WRITE_CLOSED);
+			if (wp != nullptr) {
+				wp->set(netp::E_CHANNEL_WRITE_CLOSED);
+			}
 			return;
 		}
 		m_entries_writeit=m_entries.insert_after(m_entries_writeit,{ outlet,wp,0 });
@@ -408,7 +417,9 @@ namespace netp { namespace handler {
 		//cancel all outlet
 
 		for (auto& it : m_entries) {
-			it.wp->set(netp::E_MUX_STREAM_TRANSPORT_CLOSED);
+			if (it.wp != nullptr) {
+				it.wp->set(netp::E_MUX_STREAM_TRANSPORT_CLOSED);
+			}
 		}
 
 		m_entries.clear();
@@ -464,7 +475,7 @@ namespace netp { namespace handler {
 
 		if (flag >= mux_stream_frame_flag::FRAME_MUX_STREAM_MESSAGE_TYPE_MAX) {
 			NETP_TRACE_STREAM("[muxs][s%u][rst]invalid stream message type, ignore", id);
-			__do_mux_write(mux_stream_make_frame(id, FRAME_RST, 0, 0), netp::make_ref<netp::promise<int>>());
+			__do_mux_write(mux_stream_make_frame(id, FRAME_RST, 0, 0), nullptr);
 			return;
 		}
 
@@ -489,7 +500,7 @@ namespace netp { namespace handler {
 			std::tie(ec, s) = __do_open_stream(id, { sndwnd,rcvwnd });
 			if (ec != netp::OK) {
 				NETP_WARN("[mux][s%u][syn]accept stream failed: %d", id, ec);
-				__do_mux_write(mux_stream_make_frame(id, FRAME_RST, 0, 0), netp::make_ref<netp::promise<int>>());
+				__do_mux_write(mux_stream_make_frame(id, FRAME_RST, 0, 0), nullptr);
 				return;
 			}
 
@@ -516,6 +527,6 @@ namespace netp { namespace handler {
 		}
 
 		NETP_TRACE_STREAM("[mux][s%u][%u]stream not found, reply rst, len: %u", id, flag, income->len());
-		__do_mux_write(mux_stream_make_frame(id, FRAME_RST, 0, 0), netp::make_ref<netp::promise<int>>());
+		__do_mux_write(mux_stream_make_frame(id, FRAME_RST, 0, 0), nullptr);
 	}
 }}
@@ -56,12 +56,12 @@ namespace netp { namespace handler {
 	void tls::write(NRP<channel_handler_context> const& ctx, NRP<packet> const& outlet, NRP<promise<int>> const& chp) {
 			NETP_ASSERT( ctx == m_ctx);
 			if(m_state != tls_state::S_TRANSFER) {
-				chp->set(netp::E_CHANNEL_INVALID_STATE);
+				ctx->ch->ch_write_failed(chp, netp::E_CHANNEL_INVALID_STATE);
 				return ;
 			}
 
 			if(m_write_state == tls_write_state::S_WRITE_SHUTDOWN) {
-				chp->set(netp::E_CHANNEL_WRITE_CLOSED);
+				ctx->ch->ch_write_failed(chp, netp::E_CHANNEL_WRITE_CLOSED);
 				return;
 			}
 			m_outlets.push({outlet, chp});
@@ -73,7 +73,9 @@ namespace netp { namespace handler {
 		while (m_outlets.size()) {
 			tls_outlet& outlet = m_outlets.front();
 			NETP_WARN("[tls]cancel write, nbytes: %u", outlet.outlet->len() );
-			outlet.write_p->set(netp::E_CHANNEL_CLOSED);
+			if (outlet.write_p != nullptr) {
+				outlet.write_p->set(netp::E_CHANNEL_CLOSED);
+			}
 			m_outlets.pop();
 		}
 	}
@@ -105,8 +107,9 @@ namespace netp { namespace handler {
 
 		NETP_ASSERT( m_outlets.size() );
 		tls_outlet& outlet = m_outlets.front();
-		NETP_ASSERT(outlet.write_p != nullptr);
-		outlet.write_p->set(netp::OK);
+		if (outlet.write_p != nullptr) {
+			outlet.write_p->set(netp::OK);
+		}
 		m_outlets.pop();
 
 		__tls_try_interleave_flush();
@@ -177,7 +180,8 @@ namespace netp { namespace handler {
 		}
 
 		NETP_ASSERT(m_ctx != nullptr);
-		NRP<netp::packet> outp = netp::make_ref<netp::packet>(buf, length);
+		NRP<netp::packet> outp = m_ctx->make_packet(length);
+		outp->write(buf, length);
 		if(m_write_state == tls_write_state::S_APPDATE_WRITE_PREPARE) {
 			m_write_state = tls_write_state::S_APPDATE_WRITING;
 			NRP<netp::promise<int>> f = m_ctx->write(outp);
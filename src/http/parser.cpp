@@ -47,6 +47,10 @@ namespace netp { namespace http {
 	inline static int _on_message_begin(http_parser* p_) {
 		parser* p = (parser*)p_->data;
 		NETP_ASSERT(p != nullptr);
+		//let the last message go first, the arena rewinds if nobody else holds it, a full one still held is replaced
+		p->message_tmp = nullptr;
+		p->arena = netp::bump_arena::renew(p->arena);
+		netp::bump_arena::scope _arena_scope(p->arena);
 		p->message_tmp = netp::make_ref<netp::http::message>();
 		p->message_tmp->H = netp::make_ref<netp::http::header>();
 		return 0;
@@ -143,6 +147,15 @@ namespace netp { namespace http {
 		return 0;
 	}
 
+	//the header nodes go to the arena of the message while parsing, to netp::allocator once it is full
+	inline static void _set_header(parser* p) {
+		NETP_ASSERT(p->field_tmp.length());
+		netp::bump_arena::scope _arena_scope(p->arena);
+		p->message_tmp->H->set(p->field_tmp, p->field_value_tmp);
+		p->field_tmp.clear();
+		p->field_value_tmp.clear();
+	}
+
 	inline static int _on_header_field(http_parser* p_, char const* data, ::size_t len) {
 		parser* p = (parser*)p_->data;
 		NETP_ASSERT(p != nullptr);
@@ -151,10 +164,7 @@ namespace netp { namespace http {
 		}
 
 		if (p->last_h == last_header_element::VALUE) {
-			NETP_ASSERT(p->field_tmp.length());
-			p->message_tmp->H->set(p->field_tmp, p->field_value_tmp);
-			p->field_tmp.clear();
-			p->field_value_tmp.clear();
+			_set_header(p);
 		}
 
 		p->field_tmp += string_t(data, len);
@@ -176,10 +186,7 @@ namespace netp { namespace http {
 		NETP_ASSERT(p != nullptr);
 
 		if (p->last_h == last_header_element::VALUE) {
-			NETP_ASSERT(p->field_tmp.length());
-			p->message_tmp->H->set(p->field_tmp, p->field_value_tmp);
-			p->field_tmp.clear();
-			p->field_value_tmp.clear();
+			_set_header(p);
 			p->last_h = last_header_element::NONE;
 		}
 
@@ -224,6 +231,8 @@ namespace netp { namespace http {
 		on_message_complete(nullptr),
 		on_chunk_header(nullptr),
 		on_chunk_complete(nullptr),
+		message_tmp(nullptr),
+		arena(nullptr),
 		last_h(last_header_element::NONE)
 	{
 	}
@@ -111,9 +111,28 @@ namespace netp {
 		(void)c;
 	}
 
+	void io_event_loop::__allocator_decay_init() {
+#ifdef USE_POOL
+		const u32_t interval = pool_align_allocator::decay_interval();
+		if (interval == 0) {
+			return;
+		}
+		//same as the stats timer of app, the relaunch fails once the loop is terminated
+		NRP<netp::timer> tm = netp::make_ref<netp::timer>(std::chrono::milliseconds(interval), [L = this](NRP<netp::timer> const& t) {
+			tls_get<netp::pool_align_allocator_t>()->decay();
+			L->launch(t, netp::make_ref<netp::promise<int>>());
+		});
+		launch(tm);
+#endif
+	}
+
 		//@NOTE: promise to execute all task already in tq or tq_standby
 		void io_event_loop::__run() {
 			init();
+#ifdef USE_POOL
+			//flushed at the end of every iteration
+			tls_get<netp::pool_align_allocator_t>()->remote_batching(true);
+#endif
 			u8_t _SL = u8_t(loop_state::S_LAUNCHING);
 			const bool rt = m_state.compare_exchange_strong(_SL, u8_t(loop_state::S_RUNNING), std::memory_order_acq_rel, std::memory_order_acquire);
 			NETP_ASSERT(rt == true);
@@ -142,6 +161,10 @@ namespace netp {
 					}
 					__do_execute_act();
 					_do_poll(_calc_wait_dur_in_nano());
+					__do_execute_defer();
+#ifdef USE_POOL
+					tls_get<netp::pool_align_allocator_t>()->flush_remote();
+#endif
 				}
 			}
 			catch (...) {
@@ -162,6 +185,10 @@ namespace netp {
 				}
 				m_tq_standby.clear();
 			}
+			//the standby tasks might defer, a deferred task might defer again
+			while (m_tq_defer.size()) {
+				__do_execute_defer();
+			}
 			deinit();
 		}
 
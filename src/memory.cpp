@@ -1,4 +1,13 @@
+#include <atomic>
+#include <mutex>
+
+#include <netp/core.hpp>
+#ifdef _NETP_MSVC
+	#include <intrin.h>
+#endif
+
 #include <netp/memory.hpp>
+#include <netp/logger_broker.hpp>
 
 namespace netp {
 
@@ -98,7 +107,7 @@ const static size_t TABLE_5[TABLE_SIZE::S7] = {
 	//end for ((128+256+512+1024+2048+4096)*16)*16=(8064*16)*16=126K*16=2016K=258048*8
 };
 */
-#define SLOT_MAX(t) (((t) == 0) ? u8_t(16):u8_t(8))
+#define SLOT_MAX(t) (((t) >= TABLE::T6) ? u8_t(15):u8_t(16))
 
 #ifdef _DEBUG
 	#define ___FACTOR (1)
@@ -115,15 +124,18 @@ const static size_t TABLE_5[TABLE_SIZE::S7] = {
 //object pool does not suit for large memory gap objects, so when object size incres, reduce count greatly
 //slot count
 //[128,384,896,1920,3968,8064,126k,2M]
+//T1-T5 have twice the slots of the 8 slot layout, the limit per slot is halved to keep the bytes retained per table
+//T6, T7 sum up to 135 bounds over 15 slots instead of 72 over 8, the limit per slot is halved too (8*135 < 16*72)
+//the T7 limit can not go below 1, a full debug T7 holds 135 bounds instead of 72
 	const static u32_t TABLE_SLOT_ENTRIES_INIT_LIMIT[TABLE::T_COUNT] = {
 		1024*2*(INIT_FACTOR),
-		1024*(INIT_FACTOR),
-		512* (INIT_FACTOR),
-		1024*(INIT_FACTOR),//2k
-		32*(INIT_FACTOR),
-		8*INIT_FACTOR,
-		2 * INIT_FACTOR,
-		NETP_MAX(1,1*(INIT_FACTOR>>1))
+		512*(INIT_FACTOR),
+		256* (INIT_FACTOR),
+		512*(INIT_FACTOR),//2k
+		16*(INIT_FACTOR),
+		4*INIT_FACTOR,
+		1 * INIT_FACTOR,
+		NETP_MAX(1,1*(INIT_FACTOR>>2))
 	};
 
 	const static size_t TABLE_UP_BOUND[TABLE::T_COUNT+1] = {
@@ -138,6 +150,24 @@ const static size_t TABLE_5[TABLE_SIZE::S7] = {
 		258048 * 8
 	};
 
+	inline u8_t __bsr(size_t v) {
+		NETP_ASSERT(v != 0);
+#if defined(_NETP_MSVC) && defined(_NETP_AM64)
+		unsigned long idx;
+		_BitScanReverse64(&idx, v);
+		return u8_t(idx);
+#elif defined(_NETP_MSVC)
+		unsigned long idx;
+		_BitScanReverse(&idx, v);
+		return u8_t(idx);
+#else
+		return u8_t((sizeof(unsigned long long) << 3) - 1 - __builtin_clzll(v));
+#endif
+	}
+
+	//T0: 16 slots of 8 bytes
+	//T1-T5: 16 slots of 2^(t+3) bytes, TABLE_UP_BOUND[t] == 2^(t+7)-128
+	//T6, T7: 15 slots of TABLE_UP_BOUND[t] bytes starting at 2*TABLE_UP_BOUND[t], every bound of the 8 slot layout is still a class
 	inline void calc_SIZE_by_TABLE_SLOT(size_t& size, u8_t table, u8_t slot) {
 		switch (table) {
 		case TABLE::T0:
@@ -151,53 +181,93 @@ const static size_t TABLE_5[TABLE_SIZE::S7] = {
 		case TABLE::T4:
 		case TABLE::T5:
 		{
-			size= TABLE_UP_BOUND[table] + ((slot+1) << (table+4));
+			size= TABLE_UP_BOUND[table] + (size_t(slot+1) << (table+3));
 		}
 		break;
 		case TABLE::T6:
 		case TABLE::T7:
 		{
-			size= (TABLE_UP_BOUND[table ] * ((slot+1))<<1);
+			size= TABLE_UP_BOUND[table] * (slot+2);
 		}
 		break;
 		}
 	}
 
+	//round size up to its class, table is left untouched if size is out of the tables
 	inline void calc_TABLE_SLOT(size_t& size, u8_t& table, u8_t& slot) {
-		for (u8_t t = 1; t < (TABLE::T_COUNT+1); ++t) {
-			if (size <= TABLE_UP_BOUND[t]) {
-				table = (--t);
-				break;
-			}
+		if (size <= TABLE_UP_BOUND[TABLE::T1]) {
+			table = TABLE::T0;
+			slot = size == 0 ? 0 : u8_t((size - 1) >> 3);
+			size = size_t(slot + 1) << 3;
+		} else if (size <= TABLE_UP_BOUND[TABLE::T6]) {
+			table = u8_t(__bsr(size + 127) - 7);
+			slot = u8_t((size - TABLE_UP_BOUND[table] - 1) >> (table + 3));
+			size = TABLE_UP_BOUND[table] + (size_t(slot + 1) << (table + 3));
+		} else if (size <= TABLE_UP_BOUND[TABLE::T7]) {
+			table = TABLE::T6;
+			slot = u8_t((size - 1) / TABLE_UP_BOUND[TABLE::T6] - 1);
+			size = TABLE_UP_BOUND[TABLE::T6] * (slot + 2);
+		} else if (size <= TABLE_UP_BOUND[TABLE::T_COUNT]) {
+			table = TABLE::T7;
+			slot = u8_t((size - 1) / TABLE_UP_BOUND[TABLE::T7] - 1);
+			size = TABLE_UP_BOUND[TABLE::T7] * (slot + 2);
 		}
+	}
 
-		if(table == TABLE::T0)
-		{
-			slot = u8_t(size >> 3);
-			(size % 8) != 0 ? ++slot : 0;
-			size = (slot << 3);
-			--slot;
-			return;
-		}
-		else if(table < TABLE::T6)
-		{
-			size -= TABLE_UP_BOUND[table];
-			slot = u8_t(size >> (table + 4));
-			(size % size_t(1 << (table + 4))) != 0 ? ++slot : 0;
-			size = TABLE_UP_BOUND[table] + (slot << (table + 4));
-			--slot;
-			return;
-		} 
-		else if(table < TABLE::T_COUNT)
-		{
-			const size_t LIMIT = TABLE_UP_BOUND[table];
-			for (u8_t j = 0; j < 8; ++j) {
-				if (size <= (((j + 1) << 1) * LIMIT)) {
-					size = (((j + 1) << 1) * LIMIT);
-					slot = j;
-					return;
-				}
-			}
+	void pool_align_allocator::size_class(size_t& size, u8_t& table, u8_t& slot) {
+		table = TABLE::T_COUNT;
+		slot = u8_t(-1);
+		calc_TABLE_SLOT(size, table, slot);
+	}
+
+	//[owner][table|slot][align offset] right before the address returned, aligned_free still works on it
+#define POOL_BLOCK_HEADER (3)
+#define POOL_BLOCK_OWNER(ptr) (*((u8_t*)(ptr)-3))
+#define POOL_BLOCK_TABLE_SLOT(ptr) (*((u8_t*)(ptr)-2))
+
+	inline void* pool_aligned_malloc(std::size_t size, std::size_t alignment) {
+		void* original = std::malloc(size + alignment + POOL_BLOCK_HEADER - 1);
+		if (original == 0) return 0;
+		void* aligned = reinterpret_cast<void*>(((reinterpret_cast<std::size_t>(original) + POOL_BLOCK_HEADER - 1) & ~(std::size_t(alignment - 1))) + alignment);
+		*(reinterpret_cast<char*>(aligned) - 1) = u8_t(size_t(aligned) - size_t(original));
+		return aligned;
+	}
+
+	struct pool_align_allocator_owner {
+		std::atomic<bool> used;
+		std::atomic<void*> remote_head; //blocks pushed back by other threads, linked by their first word
+		std::atomic<bool> trim_request; //set by trim_all, served by flush_remote
+		pool_align_allocator* allocator; //guarded by __pool_stats_mutex
+	};
+
+	//an owner slot outlives its thread, blocks pushed after the owner exits are reclaimed by the next thread that takes the slot
+	static pool_align_allocator_owner __pool_owners[NETP_POOL_ALLOCATOR_OWNER_MAX];
+
+	static std::mutex __pool_stats_mutex;
+	//counters of the exited allocators
+	static pool_align_allocator_stats __pool_stats_retired;
+
+	//0 for TABLE_SLOT_ENTRIES_INIT_LIMIT
+	static std::atomic<u32_t> __pool_entries_limit[TABLE::T_COUNT];
+	static std::atomic<u32_t> __pool_decay_interval(0);
+
+	void pool_align_allocator::cfg_entries_limit(u8_t t, u32_t limit) {
+		NETP_ASSERT(t < TABLE::T_COUNT);
+		__pool_entries_limit[t].store(limit, std::memory_order_relaxed);
+	}
+
+	void pool_align_allocator::cfg_decay_interval(u32_t interval) {
+		__pool_decay_interval.store(interval, std::memory_order_relaxed);
+	}
+
+	u32_t pool_align_allocator::decay_interval() {
+		return __pool_decay_interval.load(std::memory_order_relaxed);
+	}
+
+	void pool_align_allocator::_entries_limit_update() {
+		for (u8_t t = 0; t < TABLE::T_COUNT; ++t) {
+			const u32_t limit = __pool_entries_limit[t].load(std::memory_order_relaxed);
+			set_slot_entries_limit(t, limit != 0 ? limit : TABLE_SLOT_ENTRIES_INIT_LIMIT[t]);
 		}
 	}
 
@@ -208,8 +278,8 @@ const static size_t TABLE_5[TABLE_SIZE::S7] = {
 		}
 
 		for (size_t i = 0; i < (capacity >> 2); ++i) {
-			size_t size = t==TABLE::T0 ? (slot + 1) << (3) : 
-				TABLE_UP_BOUND[t] + ((slot + 1) << (t + 4));
+			size_t size;
+			calc_SIZE_by_TABLE_SLOT(size, t, slot);
 
 			pool_align_allocator::free(pool_align_allocator::malloc(size, NETP_DEFAULT_ALIGN));
 		}
@@ -236,7 +306,13 @@ const static size_t TABLE_5[TABLE_SIZE::S7] = {
 		}
 	}
 
-	pool_align_allocator::pool_align_allocator() {
+	pool_align_allocator::pool_align_allocator():
+		m_owner(0),
+		m_remote_batching(false),
+		m_remote_dirty_count(0)
+	{
+		::memset(m_remote_batches, 0, sizeof(m_remote_batches));
+		::memset(m_low_water, 0, sizeof(m_low_water));
 		init();
 	}
 
@@ -245,18 +321,281 @@ const static size_t TABLE_5[TABLE_SIZE::S7] = {
 	}
 
 	void pool_align_allocator::init() {
+		for (u32_t i = 1; i < NETP_POOL_ALLOCATOR_OWNER_MAX; ++i) {
+			bool _used = false;
+			if (__pool_owners[i].used.compare_exchange_strong(_used, true, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+				m_owner = u8_t(i);
+				break;
+			}
+		}
+		if (m_owner != 0) {
+			__pool_owners[m_owner].trim_request.store(false, std::memory_order_relaxed);
+			std::lock_guard<std::mutex> lg(__pool_stats_mutex);
+			__pool_owners[m_owner].allocator = this;
+		}
+		_entries_limit_update();
 		for (u8_t t = 0; t < TABLE::T_COUNT; ++t) {
 			m_tables[t] = new std::vector<void*>[SLOT_MAX(t)];
-			set_slot_entries_limit(t, TABLE_SLOT_ENTRIES_INIT_LIMIT[t]);
+		}
+		//blocks pushed back to the slot after its last owner exited, every table must be there before we take them
+		_remote_reclaim();
+		for (u8_t t = 0; t < TABLE::T_COUNT; ++t) {
 			init_table(t, m_tables[t]);
 		}
 	}
 
 	void pool_align_allocator::deinit() {
+		flush_remote();
 		for (u8_t t = 0; t < TABLE::T_COUNT; ++t) {
 			free_table(t,m_tables[t]);
 			delete[] m_tables[t];
 		}
+		{
+			std::lock_guard<std::mutex> lg(__pool_stats_mutex);
+			_stats_accumulate(__pool_stats_retired, false);
+			if (m_owner != 0) {
+				__pool_owners[m_owner].allocator = nullptr;
+			}
+		}
+		if (m_owner != 0) {
+			__pool_owners[m_owner].used.store(false, std::memory_order_release);
+		}
+	}
+
+	void pool_align_allocator::_stats_accumulate(pool_align_allocator_stats& stats, bool with_gauges) const {
+		for (u8_t t = 0; t < TABLE::T_COUNT; ++t) {
+			for (u8_t slot = 0; slot < SLOT_MAX(t); ++slot) {
+				class_counters const& c = m_classes[t][slot];
+				pool_align_allocator_class_stats& cs = stats.classes[t][slot];
+				cs.alloc += c.alloc.get();
+				cs.hit += c.hit.get();
+				cs.free += c.free.get();
+				if (with_gauges) {
+					cs.cached += c.cached.get();
+					cs.cached_peak += c.cached_peak.get();
+				}
+			}
+			if (with_gauges) {
+				stats.cached_bytes[t] += m_cached_bytes[t].get();
+				stats.cached_bytes_peak[t] += m_cached_bytes_peak[t].get();
+			}
+		}
+		stats.large_alloc += m_large_alloc.get();
+		stats.large_free += m_large_free.get();
+		stats.system_alloc += m_system_alloc.get();
+		stats.system_free += m_system_free.get();
+		stats.remote_free += m_remote_free.get();
+		stats.remote_flush += m_remote_flush.get();
+		stats.remote_reclaim += m_remote_reclaim.get();
+		stats.trimmed += m_trimmed.get();
+	}
+
+	inline static void __stats_init(pool_align_allocator_stats& stats) {
+		::memset(&stats, 0, sizeof(stats));
+		for (u8_t t = 0; t < TABLE::T_COUNT; ++t) {
+			for (u8_t slot = 0; slot < SLOT_MAX(t); ++slot) {
+				size_t size;
+				calc_SIZE_by_TABLE_SLOT(size, t, slot);
+				stats.classes[t][slot].size = size;
+			}
+		}
+	}
+
+	void pool_align_allocator::stats(pool_align_allocator_stats& stats) const {
+		__stats_init(stats);
+		_stats_accumulate(stats, true);
+		stats.threads = 1;
+	}
+
+	void pool_align_allocator::stats_all(pool_align_allocator_stats& stats) {
+		__stats_init(stats);
+		std::lock_guard<std::mutex> lg(__pool_stats_mutex);
+		for (u8_t t = 0; t < TABLE::T_COUNT; ++t) {
+			for (u8_t slot = 0; slot < SLOT_MAX(t); ++slot) {
+				pool_align_allocator_class_stats const& r = __pool_stats_retired.classes[t][slot];
+				stats.classes[t][slot].alloc = r.alloc;
+				stats.classes[t][slot].hit = r.hit;
+				stats.classes[t][slot].free = r.free;
+			}
+		}
+		stats.large_alloc = __pool_stats_retired.large_alloc;
+		stats.large_free = __pool_stats_retired.large_free;
+		stats.system_alloc = __pool_stats_retired.system_alloc;
+		stats.system_free = __pool_stats_retired.system_free;
+		stats.remote_free = __pool_stats_retired.remote_free;
+		stats.remote_flush = __pool_stats_retired.remote_flush;
+		stats.remote_reclaim = __pool_stats_retired.remote_reclaim;
+		stats.trimmed = __pool_stats_retired.trimmed;
+
+		for (u32_t i = 1; i < NETP_POOL_ALLOCATOR_OWNER_MAX; ++i) {
+			if (__pool_owners[i].allocator != nullptr) {
+				__pool_owners[i].allocator->_stats_accumulate(stats, true);
+				++stats.threads;
+			}
+		}
+	}
+
+	void pool_align_allocator::stats_dump(pool_align_allocator_stats const& stats) {
+		NETP_INFO("[allocator]threads: %u, system alloc: %llu, system free: %llu, large alloc: %llu, large free: %llu, remote free: %llu, remote flush: %llu, remote reclaim: %llu, trimmed: %llu",
+			stats.threads, stats.system_alloc, stats.system_free, stats.large_alloc, stats.large_free, stats.remote_free, stats.remote_flush, stats.remote_reclaim, stats.trimmed);
+		for (u8_t t = 0; t < TABLE::T_COUNT; ++t) {
+			NETP_INFO("[allocator]table: %u, cached bytes: %llu, peak: %llu", t, stats.cached_bytes[t], stats.cached_bytes_peak[t]);
+			for (u8_t slot = 0; slot < SLOT_MAX(t); ++slot) {
+				pool_align_allocator_class_stats const& cs = stats.classes[t][slot];
+				if (cs.alloc == 0 && cs.free == 0) {
+					continue;
+				}
+				NETP_INFO("[allocator]size: %llu, alloc: %llu, hit: %llu, free: %llu, cached: %llu, peak: %llu",
+					cs.size, cs.alloc, cs.hit, cs.free, cs.cached, cs.cached_peak);
+			}
+		}
+	}
+
+	void pool_align_allocator::_local_free(void* ptr, u8_t t, u8_t slot) {
+		NETP_ASSERT(t < TABLE::T_COUNT);
+		NETP_ASSERT(SLOT_MAX(t) > slot);
+		std::vector<void*>& table_slot = *(m_tables[t] + slot);
+
+		if ((table_slot.size() < m_entries_limit[t])) {
+			table_slot.push_back(ptr);
+			size_t size;
+			calc_SIZE_by_TABLE_SLOT(size, t, slot);
+			_cached_add(t, slot, size);
+			return;
+		}
+
+		m_system_free.incre();
+		netp::aligned_free(ptr);
+	}
+
+	void pool_align_allocator::_remote_free(void* ptr, u8_t owner) {
+		remote_batch& b = m_remote_batches[owner];
+		*((void**)ptr) = b.head;
+		if (b.head == nullptr) {
+			b.tail = ptr;
+			if (!b.dirty) {
+				b.dirty = true;
+				m_remote_dirty[m_remote_dirty_count++] = owner;
+			}
+		}
+		b.head = ptr;
+		m_remote_free.incre();
+		if (++b.count == NETP_POOL_ALLOCATOR_REMOTE_BATCH || !m_remote_batching) {
+			_remote_push(owner);
+		}
+	}
+
+	void pool_align_allocator::_remote_push(u8_t owner) {
+		remote_batch& b = m_remote_batches[owner];
+		NETP_ASSERT(b.head != nullptr);
+		std::atomic<void*>& remote_head = __pool_owners[owner].remote_head;
+		void* h = remote_head.load(std::memory_order_relaxed);
+		do {
+			*((void**)b.tail) = h;
+		} while (!remote_head.compare_exchange_weak(h, b.head, std::memory_order_release, std::memory_order_relaxed));
+		b.head = nullptr;
+		b.tail = nullptr;
+		b.count = 0;
+		m_remote_flush.incre();
+	}
+
+	bool pool_align_allocator::_remote_reclaim() {
+		if (m_owner == 0 || __pool_owners[m_owner].remote_head.load(std::memory_order_relaxed) == nullptr) {
+			return false;
+		}
+		void* ptr = __pool_owners[m_owner].remote_head.exchange(nullptr, std::memory_order_acquire);
+		while (ptr != nullptr) {
+			void* next = *((void**)ptr);
+			const u8_t slot_ = POOL_BLOCK_TABLE_SLOT(ptr);
+			_local_free(ptr, (slot_ >> 4), (slot_ & 0xf));
+			m_remote_reclaim.incre();
+			ptr = next;
+		}
+		return true;
+	}
+
+	void pool_align_allocator::remote_batching(bool on) {
+		if (!on) {
+			flush_remote();
+		}
+		m_remote_batching = on;
+	}
+
+	void pool_align_allocator::flush_remote() {
+		for (u32_t i = 0; i < m_remote_dirty_count; ++i) {
+			//a full batch has been pushed already, its owner stays listed
+			remote_batch& b = m_remote_batches[m_remote_dirty[i]];
+			if (b.head != nullptr) {
+				_remote_push(m_remote_dirty[i]);
+			}
+			b.dirty = false;
+		}
+		m_remote_dirty_count = 0;
+		_remote_reclaim();
+		if (m_owner != 0 && NETP_UNLIKELY(__pool_owners[m_owner].trim_request.load(std::memory_order_relaxed))) {
+			__pool_owners[m_owner].trim_request.store(false, std::memory_order_relaxed);
+			trim();
+		}
+	}
+
+	size_t pool_align_allocator::_release_front(u8_t t, u8_t slot, size_t n) {
+		std::vector<void*>& table_slot = *(m_tables[t] + slot);
+		NETP_ASSERT(n <= table_slot.size());
+		//the front ones are the least recently freed
+		for (size_t i = 0; i < n; ++i) {
+			netp::aligned_free(table_slot[i]);
+		}
+		table_slot.erase(table_slot.begin(), table_slot.begin() + n);
+		size_t size;
+		calc_SIZE_by_TABLE_SLOT(size, t, slot);
+		m_classes[t][slot].cached.sub(n);
+		m_cached_bytes[t].sub(size * n);
+		m_system_free.add(n);
+		m_trimmed.add(n);
+		return size * n;
+	}
+
+	void pool_align_allocator::decay() {
+		_entries_limit_update();
+		for (u8_t t = 0; t < TABLE::T_COUNT; ++t) {
+			for (u8_t slot = 0; slot < SLOT_MAX(t); ++slot) {
+				std::vector<void*>& table_slot = *(m_tables[t] + slot);
+				const size_t idle = m_low_water[t][slot] < table_slot.size() ? m_low_water[t][slot] : table_slot.size();
+				size_t n = (idle + 1) >> 1;
+				if ((table_slot.size() - n) > m_entries_limit[t]) {
+					n = table_slot.size() - m_entries_limit[t];
+				}
+				if (n != 0) {
+					_release_front(t, slot, n);
+				}
+				m_low_water[t][slot] = u32_t(table_slot.size());
+			}
+		}
+	}
+
+	size_t pool_align_allocator::trim() {
+		_entries_limit_update();
+		_remote_reclaim();
+		size_t bytes = 0;
+		for (u8_t t = 0; t < TABLE::T_COUNT; ++t) {
+			for (u8_t slot = 0; slot < SLOT_MAX(t); ++slot) {
+				std::vector<void*>& table_slot = *(m_tables[t] + slot);
+				if (table_slot.size() != 0) {
+					bytes += _release_front(t, slot, table_slot.size());
+				}
+				std::vector<void*>().swap(table_slot);
+				m_low_water[t][slot] = 0;
+			}
+		}
+		return bytes;
+	}
+
+	void pool_align_allocator::trim_all() {
+		for (u32_t i = 1; i < NETP_POOL_ALLOCATOR_OWNER_MAX; ++i) {
+			if (__pool_owners[i].used.load(std::memory_order_acquire)) {
+				__pool_owners[i].trim_request.store(true, std::memory_order_relaxed);
+			}
+		}
 	}
 
 	void* pool_align_allocator::malloc(size_t size, size_t align_size) {
@@ -269,16 +608,27 @@ const static size_t TABLE_5[TABLE_SIZE::S7] = {
 			NETP_ASSERT(slot != size_t(-1));
 			NETP_ASSERT(SLOT_MAX(t) > slot);
 			std::vector<void*>& table_slot = *(m_tables[t] + slot);
+			m_classes[t][slot].alloc.incre();
 
-			if (table_slot.size()) {
+			if (table_slot.size() || (_remote_reclaim() && table_slot.size())) {
 				uptr = (u8_t*)table_slot.back();
 				table_slot.pop_back();
+				POOL_BLOCK_OWNER(uptr) = m_owner;
+				m_classes[t][slot].hit.incre();
+				_cached_sub(t, slot, size);
+				if (table_slot.size() < m_low_water[t][slot]) {
+					m_low_water[t][slot] = u32_t(table_slot.size());
+				}
 				return uptr;
 			}
+		} else {
+			m_large_alloc.incre();
 		}
-		uptr = (u8_t*)netp::aligned_malloc(size, align_size);
+		m_system_alloc.incre();
+		uptr = (u8_t*)netp::pool_aligned_malloc(size, align_size);
 		if (NETP_LIKELY(uptr != 0)) {
-			*(uptr - 2) = ((t << 4) | (slot & 0xf));
+			POOL_BLOCK_TABLE_SLOT(uptr) = ((t << 4) | (slot & 0xf));
+			POOL_BLOCK_OWNER(uptr) = m_owner;
 		}
 		return uptr;
 	}
@@ -286,23 +636,22 @@ const static size_t TABLE_5[TABLE_SIZE::S7] = {
 	void pool_align_allocator::free(void* ptr) {
 		if (NETP_UNLIKELY(ptr == nullptr)) { return; }
 
-		u8_t& slot_ = *((u8_t*)ptr-2);
+		const u8_t slot_ = POOL_BLOCK_TABLE_SLOT(ptr);
 		u8_t t = (slot_ >>4);
 		u8_t slot = (slot_ & 0xf);
 		if (NETP_UNLIKELY(t == T_COUNT)) {
+			m_large_free.incre();
+			m_system_free.incre();
 			return netp::aligned_free(ptr);
 		}
 
-		NETP_ASSERT(t < TABLE::T_COUNT);
-		NETP_ASSERT(SLOT_MAX(t) > slot);
-		std::vector<void*>& table_slot = *(m_tables[t] + slot);
-
-		if ((table_slot.size() < m_entries_limit[t])) {
-			table_slot.push_back(ptr);
+		m_classes[t][slot].free.incre();
+		const u8_t owner = POOL_BLOCK_OWNER(ptr);
+		if (NETP_UNLIKELY(owner != m_owner && owner != 0)) {
+			_remote_free(ptr, owner);
 			return;
 		}
-
-		netp::aligned_free(ptr);
+		_local_free(ptr, t, slot);
 	}
 
 
@@ -327,6 +676,13 @@ const static size_t TABLE_5[TABLE_SIZE::S7] = {
 			if (table_slot.size()) {
 				uptr = (u8_t*)table_slot.back();
 				table_slot.pop_back();
+				POOL_BLOCK_OWNER(uptr) = m_owner;
+				m_classes[t][slot].alloc.incre();
+				m_classes[t][slot].hit.incre();
+				_cached_sub(t, slot, size);
+				if (table_slot.size() < m_low_water[t][slot]) {
+					m_low_water[t][slot] = u32_t(table_slot.size());
+				}
 			}
 		}
 
@@ -339,7 +695,7 @@ const static size_t TABLE_5[TABLE_SIZE::S7] = {
 			}
 		}
 
-		u8_t old_slot = *((u8_t*)ptr - 2);
+		u8_t old_slot = POOL_BLOCK_TABLE_SLOT(ptr);
 		u8_t old_t = (old_slot >> 4);
 		old_slot = (old_slot&0xf);
 		size_t old_size=0;
@@ -0,0 +1,273 @@
+#include <netp/core.hpp>
+
+#ifdef _NETP_WIN
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+#endif
+
+#include <netp/logger_broker.hpp>
+#include <netp/packet_pool.hpp>
+
+namespace netp {
+
+	std::atomic<u32_t> __packet_arena_count(0);
+
+	struct packet_arena_entry {
+		std::atomic<bool> used;
+		std::atomic<byte_t*> base; //nullptr once unmapped
+		std::atomic<netp::size_t> size;
+		std::atomic<void*> remote_head; //buffers pushed back by other threads, [next][capacity] in the first bytes
+	};
+
+	//an entry with buffers still out when its pool is gone keeps its mapping and is never reused
+	static packet_arena_entry __packet_arenas[NETP_PACKET_ARENA_MAX];
+
+	static byte_t* __packet_arena_map(netp::size_t size, bool& huge) {
+#ifdef _NETP_WIN
+		huge = false;
+		return (byte_t*)::VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+		void* p;
+#ifdef MAP_HUGETLB
+		p = ::mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+		if (p != MAP_FAILED) {
+			huge = true;
+			return (byte_t*)p;
+		}
+#endif
+		huge = false;
+		p = ::mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (p == MAP_FAILED) {
+			return nullptr;
+		}
+#ifdef MADV_HUGEPAGE
+		::madvise(p, size, MADV_HUGEPAGE);
+#endif
+		//fault it in after the advice, so THP can back it with huge pages
+		for (netp::size_t off = 0; off < size; off += 4096) {
+			*((volatile byte_t*)p + off) = 0;
+		}
+		return (byte_t*)p;
+#endif
+	}
+
+	static void __packet_arena_unmap(byte_t* base, netp::size_t size) {
+#ifdef _NETP_WIN
+		(void)size;
+		::VirtualFree(base, 0, MEM_RELEASE);
+#else
+		::munmap(base, size);
+#endif
+	}
+
+	packet_pool::packet_pool(netp::size_t max_bytes, netp::size_t arena_bytes) :
+		m_max_bytes(max_bytes),
+		m_arena(-1),
+		m_arena_base(nullptr),
+		m_arena_carved_count(0)
+	{
+		::memset(&m_stats, 0, sizeof(m_stats));
+		if (arena_bytes != 0) {
+			_arena_init(arena_bytes);
+		}
+	}
+
+	packet_pool::~packet_pool() {
+		if (m_arena != -1) {
+			_arena_reclaim();
+		}
+		u64_t arena_back = 0;
+		for (netp::size_t i = 0; i < m_objects.size(); ++i) {
+			netp::allocator<char>::free((char*)m_objects[i]);
+		}
+		for (int c = 0; c < NETP_PACKET_POOL_BUF_CLASS_COUNT; ++c) {
+			for (netp::size_t i = 0; i < m_bufs[c].size(); ++i) {
+				if (m_arena != -1 && m_bufs[c][i] >= m_arena_base && m_bufs[c][i] < (m_arena_base + m_stats.arena_bytes)) {
+					++arena_back;
+					continue;
+				}
+				netp::allocator<byte_t>::free(m_bufs[c][i]);
+			}
+		}
+		if (m_arena != -1) {
+			if (arena_back == m_arena_carved_count) {
+				_arena_deinit();
+			} else {
+				NETP_WARN("[packet_pool]arena kept mapped, buffers out: %llu", (m_arena_carved_count - arena_back));
+			}
+		}
+	}
+
+	void packet_pool::_arena_init(netp::size_t arena_bytes) {
+		arena_bytes = ((arena_bytes + NETP_PACKET_ARENA_PAGE_SIZE - 1) / NETP_PACKET_ARENA_PAGE_SIZE) * NETP_PACKET_ARENA_PAGE_SIZE;
+		int arena = -1;
+		for (int i = 0; i < NETP_PACKET_ARENA_MAX; ++i) {
+			bool _used = false;
+			if (__packet_arenas[i].used.compare_exchange_strong(_used, true, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+				arena = i;
+				break;
+			}
+		}
+		if (arena == -1) {
+			NETP_WARN("[packet_pool]no arena slot left, arena disabled");
+			return;
+		}
+		bool huge;
+		byte_t* base = __packet_arena_map(arena_bytes, huge);
+		if (base == nullptr) {
+			NETP_WARN("[packet_pool]map arena failed: %d, arena disabled", netp_last_errno());
+			__packet_arenas[arena].used.store(false, std::memory_order_release);
+			return;
+		}
+		__packet_arenas[arena].size.store(arena_bytes, std::memory_order_relaxed);
+		__packet_arenas[arena].base.store(base, std::memory_order_release);
+		__packet_arena_count.fetch_add(1, std::memory_order_release);
+
+		m_arena = arena;
+		m_arena_base = base;
+		m_stats.arena_bytes = arena_bytes;
+		m_stats.arena_huge_page = huge ? 1 : 0;
+		NETP_INFO("[packet_pool]arena mapped, bytes: %llu, huge page: %u", m_stats.arena_bytes, m_stats.arena_huge_page);
+	}
+
+	void packet_pool::_arena_deinit() {
+		packet_arena_entry& e = __packet_arenas[m_arena];
+		e.base.store(nullptr, std::memory_order_release);
+		__packet_arena_count.fetch_sub(1, std::memory_order_release);
+		__packet_arena_unmap(m_arena_base, m_stats.arena_bytes);
+		NETP_ASSERT(e.remote_head.load(std::memory_order_acquire) == nullptr);
+		e.used.store(false, std::memory_order_release);
+		m_arena = -1;
+		m_arena_base = nullptr;
+	}
+
+	int packet_pool::_arena_of(byte_t const* p) {
+		for (int i = 0; i < NETP_PACKET_ARENA_MAX; ++i) {
+			byte_t const* base = __packet_arenas[i].base.load(std::memory_order_acquire);
+			if (base != nullptr && p >= base && p < (base + __packet_arenas[i].size.load(std::memory_order_relaxed))) {
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	byte_t* packet_pool::_arena_carve(netp::size_t class_size) {
+		if ((m_stats.arena_carved + class_size) > m_stats.arena_bytes) {
+			return nullptr;
+		}
+		byte_t* p = m_arena_base + m_stats.arena_carved;
+		m_stats.arena_carved += class_size;
+		++m_arena_carved_count;
+		return p;
+	}
+
+	void packet_pool::_arena_free(byte_t* p, netp::size_t capacity) {
+		netp::size_t class_size;
+		const int cls = buf_class(capacity, class_size);
+		NETP_ASSERT(cls >= 0 && class_size == capacity);
+		m_bufs[cls].push_back(p);
+		++m_stats.bufs;
+	}
+
+	void packet_pool::_arena_remote_free(int arena, byte_t* p, netp::size_t capacity) {
+		std::atomic<void*>& remote_head = __packet_arenas[arena].remote_head;
+		*((netp::size_t*)(p + sizeof(void*))) = capacity;
+		void* h = remote_head.load(std::memory_order_relaxed);
+		do {
+			*((void**)p) = h;
+		} while (!remote_head.compare_exchange_weak(h, p, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	bool packet_pool::_arena_reclaim() {
+		std::atomic<void*>& remote_head = __packet_arenas[m_arena].remote_head;
+		if (remote_head.load(std::memory_order_relaxed) == nullptr) {
+			return false;
+		}
+		byte_t* p = (byte_t*)remote_head.exchange(nullptr, std::memory_order_acquire);
+		while (p != nullptr) {
+			byte_t* next = *((byte_t**)p);
+			_arena_free(p, *((netp::size_t*)(p + sizeof(void*))));
+			++m_stats.arena_remote;
+			p = next;
+		}
+		return true;
+	}
+
+	int packet_pool::buf_class(netp::size_t n, netp::size_t& class_size) {
+		if (n <= NETP_PACKET_POOL_BUF_CLASS_MIN) {
+			class_size = NETP_PACKET_POOL_BUF_CLASS_MIN;
+			return 0;
+		}
+		if (n > NETP_PACKET_POOL_BUF_CLASS_MAX) {
+			return -1;
+		}
+		//2^b <= n-1 < 2^(b+1), split into 4 steps of 2^(b-2)
+		const netp::size_t m = n - 1;
+		int b = 7;
+		while ((m >> (b + 1)) != 0) {
+			++b;
+		}
+		const netp::size_t q = m >> (b - 2);
+		class_size = (q + 1) << (b - 2);
+		return ((b - 7) << 2) + int(q - 4) + 1;
+	}
+
+	void* packet_pool::object_malloc() {
+		if (m_objects.size()) {
+			void* p = m_objects.back();
+			m_objects.pop_back();
+			++m_stats.object_hit;
+			--m_stats.objects;
+			return p;
+		}
+		++m_stats.object_miss;
+		return netp::allocator<char>::malloc(NETP_PACKET_POOL_OBJECT_SIZE);
+	}
+
+	void packet_pool::object_free(void* p) {
+		if (m_objects.size() >= NETP_PACKET_POOL_OBJECT_MAX) {
+			netp::allocator<char>::free((char*)p);
+			return;
+		}
+		m_objects.push_back(p);
+		++m_stats.objects;
+	}
+
+	byte_t* packet_pool::buf_malloc(int cls, netp::size_t class_size) {
+		NETP_ASSERT(cls >= 0 && cls < NETP_PACKET_POOL_BUF_CLASS_COUNT);
+		std::vector<byte_t*>& bufs = m_bufs[cls];
+		if (bufs.size() || (m_arena != -1 && _arena_reclaim() && bufs.size())) {
+			byte_t* p = bufs.back();
+			bufs.pop_back();
+			++m_stats.buf_hit;
+			--m_stats.bufs;
+			if (m_arena == -1 || p < m_arena_base || p >= (m_arena_base + m_stats.arena_bytes)) {
+				m_stats.bytes -= class_size;
+			}
+			return p;
+		}
+		++m_stats.buf_miss;
+		if (m_arena != -1) {
+			byte_t* p = _arena_carve(class_size);
+			if (p != nullptr) {
+				return p;
+			}
+		}
+		return netp::allocator<byte_t>::malloc(class_size, NETP_DEFAULT_ALIGN);
+	}
+
+	bool packet_pool::buf_free(byte_t* p, netp::size_t capacity) {
+		netp::size_t class_size;
+		const int cls = buf_class(capacity, class_size);
+		//capacity changed by a realloc does not fit a class
+		if (cls < 0 || class_size != capacity || (m_stats.bytes + capacity) > m_max_bytes) {
+			++m_stats.buf_drop;
+			return false;
+		}
+		m_bufs[cls].push_back(p);
+		++m_stats.bufs;
+		m_stats.bytes += capacity;
+		return true;
+	}
+}
@@ -0,0 +1,65 @@
+#include <netp/core.hpp>
+#include <netp/mutex.hpp>
+#include <netp/logger_broker.hpp>
+#include <netp/recycler.hpp>
+
+namespace netp {
+
+	static netp::spin_mutex __recycler_type_mutex;
+	static std::atomic<u32_t> __recycler_type_count(0);
+	static char const* __recycler_type_keys[NETP_RECYCLER_TYPE_MAX];
+	static char __recycler_type_names[NETP_RECYCLER_TYPE_MAX][NETP_RECYCLER_TYPE_NAME_MAX];
+	static netp::size_t __recycler_type_sizes[NETP_RECYCLER_TYPE_MAX];
+
+	recycler::recycler(u32_t max) :
+		m_max(max)
+	{
+		::memset(m_slots, 0, sizeof(m_slots));
+	}
+
+	recycler::~recycler() {
+		for (u32_t i = 0; i < NETP_RECYCLER_TYPE_MAX; ++i) {
+			node* n = m_slots[i].head;
+			while (n != nullptr) {
+				node* next = n->next;
+				netp::allocator<char>::free((char*)n);
+				n = next;
+			}
+		}
+	}
+
+	//called once per type from a function local static, the count is published after the name and size
+	//types of one name and one size share a slot, promise<int> and promise<bool> for example
+	u32_t recycler::register_type(char const* name, netp::size_t size) {
+		lock_guard<spin_mutex> lg(__recycler_type_mutex);
+		const u32_t id = __recycler_type_count.load(std::memory_order_relaxed);
+		for (u32_t i = 0; i < id; ++i) {
+			if (__recycler_type_sizes[i] == size && ::strcmp(__recycler_type_keys[i], name) == 0) {
+				return i;
+			}
+		}
+		if (id == NETP_RECYCLER_TYPE_MAX) {
+			NETP_WARN("[recycler]type registry full, %s<%zu> goes to netp::allocator, raise NETP_RECYCLER_TYPE_MAX", name, size);
+			return NETP_RECYCLER_TYPE_MAX;
+		}
+		__recycler_type_keys[id] = name;
+		::snprintf(__recycler_type_names[id], NETP_RECYCLER_TYPE_NAME_MAX, "%s<%zu>", name, size);
+		__recycler_type_sizes[id] = size;
+		__recycler_type_count.store(id + 1, std::memory_order_release);
+		return id;
+	}
+
+	u32_t recycler::type_count() {
+		return __recycler_type_count.load(std::memory_order_acquire);
+	}
+
+	char const* recycler::type_name(u32_t id) {
+		NETP_ASSERT(id < type_count());
+		return __recycler_type_names[id];
+	}
+
+	netp::size_t recycler::type_size(u32_t id) {
+		NETP_ASSERT(id < type_count());
+		return __recycler_type_sizes[id];
+	}
+}
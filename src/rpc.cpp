@@ -43,7 +43,7 @@ namespace netp {
 			}
 		}
 
-		in_rpcm = netp::make_ref<rpc_message>((rpc_message_type)t, id, code, netp::make_ref<netp::packet>(inpack->head(), plen));
+		in_rpcm = netp::make_ref<rpc_message>((rpc_message_type)t, id, code, inpack->slice(0, plen));
 		inpack->skip(plen);
 		return netp::OK;
 	}
@@ -244,6 +244,8 @@ namespace netp {
 			return;
 		}
 
+		m_arena = netp::bump_arena::renew(m_arena);
+		netp::bump_arena::scope _arena_scope(m_arena);
 		NRP<netp::rpc_message> m = netp::make_ref<netp::rpc_message>(netp::rpc_message_type::T_REQ, api_id, data);
 		NRP<netp::rpc_req_message> req_r = netp::make_ref<netp::rpc_req_message>();
 		req_r->state = netp::rpc_req_message_state::S_WAIT_WRITE;
@@ -267,6 +269,8 @@ namespace netp {
 			return;
 		}
 		NETP_ASSERT(data->len());
+		m_arena = netp::bump_arena::renew(m_arena);
+		netp::bump_arena::scope _arena_scope(m_arena);
 		NRP<netp::rpc_message> m = netp::make_ref<netp::rpc_message>(netp::rpc_message_type::T_DATA, 0, data);
 		NRP<netp::rpc_req_message> req_r = netp::make_ref<netp::rpc_req_message>();
 		req_r->state = netp::rpc_req_message_state::S_WAIT_WRITE;
@@ -353,7 +357,16 @@ namespace netp {
 	void rpc::read(NRP<netp::channel_handler_context> const& ctx, NRP<netp::packet> const& income) {
 		NETP_ASSERT(m_loop->in_event_loop());
 		NRP<rpc_message> in;
-		int rt = rpc_message::from_packet(income,in);
+		NRP<rpc_message> r;
+		int rt;
+		{
+			m_arena = netp::bump_arena::renew(m_arena);
+			netp::bump_arena::scope _arena_scope(m_arena);
+			rt = rpc_message::from_packet(income, in);
+			if (rt == netp::OK && in->type == rpc_message_type::T_REQ) {
+				r = netp::make_ref<rpc_message>(netp::rpc_message_type::T_RESP, in->id);
+			}
+		}
 
 		if (NETP_UNLIKELY(rt != netp::OK)) {
 			NETP_WARN("[rpc][%s]invalid rpc message parsed, close rpc", ctx->ch->ch_info().c_str() );
@@ -367,7 +380,7 @@ namespace netp {
 		case rpc_message_type::T_REQ:
 		{
 			TRACE_RPC("[rpc]call in, id: %u, api code: %d, data len: %u", in->id, in->code, in->data == nullptr ? 0 : in->data->len());
-			NRP<rpc_message> r = netp::make_ref<rpc_message>(netp::rpc_message_type::T_RESP, in->id);
+			NETP_ASSERT(r != nullptr);
 			try {
 				NRP<netp::rpc_call_promise> f = netp::make_ref<netp::rpc_call_promise>();
 				f->if_done([r, rpc_ = NRP<rpc>(this)]( std::tuple<int, NRP<packet>> const& tupp) {
@@ -452,6 +465,7 @@ namespace netp {
 		m_loop(L),
 		m_wstate(rpc_write_state::S_WRITE_CLOSED),
 		m_fn_on_push(nullptr),
+		m_arena(NETP_RPC_ARENA_BYTES != 0 ? netp::make_ref<netp::bump_arena>(NETP_RPC_ARENA_BYTES) : nullptr),
 		m_queue_size(NETP_RPC_QUEUE_SIZE)
 	{
 	}
@@ -527,6 +541,36 @@ namespace netp {
 		return dial(host.c_str(), host.length(), fn_ch_initializer, cfg);
 	}
 
+	netp::fn_channel_initializer_t rpc::pool_initializer(netp::fn_channel_initializer_t const& fn_ch_initializer) {
+		return [fn_ch_initializer](NRP<netp::channel> const& ch) {
+			if (fn_ch_initializer != nullptr) {
+				fn_ch_initializer(ch);
+			}
+			ch->pipeline()->add_last(netp::make_ref<netp::handler::hlen>());
+			NRP<netp::rpc> rpc = netp::make_ref<netp::rpc>(ch->L);
+			ch->pipeline()->add_last(rpc);
+			ch->set_ctx(rpc);
+		};
+	}
+
+	NRP<rpc_dial_promise> rpc::acquire(NRP<connection_pool> const& pool, std::string const& url) {
+		NRP<netp::rpc_dial_promise> rdf = netp::make_ref<netp::rpc_dial_promise>();
+		pool->acquire(url)->if_done([rdf](std::tuple<int, NRP<netp::channel>> const& tupc) {
+			if (std::get<0>(tupc) != netp::OK) {
+				rdf->set(std::make_tuple(std::get<0>(tupc), nullptr));
+				return;
+			}
+			NRP<netp::channel> const& ch = std::get<1>(tupc);
+			//a new channel is handed out right before its connected event, the rpc gets its ctx on that event
+			ch->L->schedule([rdf, ch]() {
+				NRP<netp::rpc> rpc = ch->get_ctx<netp::rpc>();
+				NETP_ASSERT(rpc != nullptr, "the initializer of the pool is not rpc::pool_initializer");
+				rdf->set(std::make_tuple(netp::OK, rpc));
+			});
+		});
+		return rdf;
+	}
+
 	NRP<rpc_listen_promise> rpc::listen(std::string const& host, fn_rpc_activity_notify_t const& fn_accepted, netp::fn_channel_initializer_t const& fn_ch_initializer, NRP<socket_cfg> const& cfg ) {
 		return netp::socket::listen_on(host.c_str(), host.length(), __decorate_initializer(fn_accepted, nullptr, fn_ch_initializer), cfg);
 	}
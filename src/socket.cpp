@@ -4,6 +4,11 @@
 
 namespace netp {
 
+	constexpr u32_t socket_rcv_predictor::SIZES[];
+	constexpr u8_t socket_rcv_predictor::SIZE_COUNT;
+	constexpr u8_t socket_rcv_predictor::INIT_IDX;
+	constexpr u8_t socket_rcv_predictor::GROW_STEP;
+
 	int socket::connect(address const& addr) {
 		if (m_chflag & (int(channel_flag::F_CONNECTING) | int(channel_flag::F_CONNECTED) | int(channel_flag::F_LISTENING) | int(channel_flag::F_CLOSED)) ) {
 			return netp::E_SOCKET_INVALID_STATE;
@@ -27,9 +32,15 @@ namespace netp {
 
 		int rt = connect(addr);
 		if (IS_ERRNO_EQUAL_CONNECTING(rt)) {
+			m_connect_p = p;
 			ch_aio_connect([so=NRP<socket>(this), p](const int aiort_) {
 				//NRP< promise<int>> __p__barrier(p);we dont need this line if act executed in Q
 				so->ch_aio_end_connect();
+				if (so->m_connect_p == nullptr) {
+					//aborted by ch_close
+					return;
+				}
+				so->m_connect_p = nullptr;
 				p->set(aiort_);
 			});
 		} else {
@@ -39,6 +50,19 @@ namespace netp {
 		}
 	}
 
+	//flush the writes held by F_BDLIMIT, a pending rate limiter retry owns the next flush
+	void socket::_do_ch_bdlimit_flush() {
+		NETP_ASSERT(L->in_event_loop());
+		if ((m_chflag & int(channel_flag::F_BDLIMIT)) == 0 || (m_chflag & int(channel_flag::F_RATE_LIMIT_TIMER))) {
+			return;
+		}
+		NETP_ASSERT( !(m_chflag & (int(channel_flag::F_WRITE_BARRIER)|int(channel_flag::F_WATCH_WRITE))));
+		m_chflag &= ~int(channel_flag::F_BDLIMIT);
+		m_chflag |= int(channel_flag::F_WRITE_BARRIER);
+		__cb_aio_write_impl(netp::OK);
+		m_chflag &= ~int(channel_flag::F_WRITE_BARRIER);
+	}
+
 	void socket::_tmcb_BDL(NRP<timer> const& t) {
 		NETP_ASSERT(L->in_event_loop());
 		NETP_ASSERT(m_outbound_limit > 0);
@@ -57,16 +81,200 @@ namespace netp {
 			m_outbound_budget += tokens;
 			L->launch(t);
 		}
+		_do_ch_bdlimit_flush();
+	}
+
+	void socket::_tmcb_RL(NRP<timer> const& t) {
+		(void)t;
+		NETP_ASSERT(L->in_event_loop());
+		NETP_ASSERT(m_chflag&int(channel_flag::F_RATE_LIMIT_TIMER));
+		m_chflag &= ~int(channel_flag::F_RATE_LIMIT_TIMER);
+		if (m_chflag & (int(channel_flag::F_WRITE_SHUTDOWN)|int(channel_flag::F_WRITE_ERROR)|int(channel_flag::F_IO_EVENT_LOOP_NOTIFY_TERMINATING))) {
+			return;
+		}
+		_do_ch_bdlimit_flush();
+	}
+
+	void socket::_do_transport_stats_sampling(u32_t interval) {
+		NETP_ASSERT(L->in_event_loop());
+		m_transport_stats_interval = interval;
+		//a running timer stops itself once it is replaced
+		m_tm_transport_stats = nullptr;
+		if (interval == 0 && m_sock_buf_autotune) {
+			interval = NETP_SOCKET_BUF_AUTOTUNE_INTERVAL;
+		}
+		if (interval == 0 || (m_chflag & (int(channel_flag::F_CLOSED) | int(channel_flag::F_LISTENING)))) {
+			return;
+		}
+		int rt = get_tcp_info(m_transport_stats);
+		if (rt != netp::OK) {
+			NETP_WARN("[socket][%s]get_tcp_info failed: %d, transport stats sampling off", info().c_str(), rt);
+			return;
+		}
+		if (m_sock_buf_autotune && m_sock_buf_charged == 0) {
+			//start from what the kernel gave us, counted even if it is over the budget already
+			m_autotune_last_at = m_transport_stats.sampled_at;
+			m_autotune_last_acked = m_transport_stats.bytes_acked;
+			m_autotune_last_rcv = m_transport_stats.bytes_received;
+			__sock_buf_charge();
+		}
+		m_tm_transport_stats = netp::make_ref<netp::timer>(std::chrono::milliseconds(interval), &socket::_tmcb_transport_stats, NRP<socket>(this), std::placeholders::_1);
+		L->launch(m_tm_transport_stats);
+	}
+
+	void socket::_tmcb_transport_stats(NRP<timer> const& t) {
+		NETP_ASSERT(L->in_event_loop());
+		if (t.get() != m_tm_transport_stats.get()) {
+			return;
+		}
+		//a closed socket has released its charge and dropped the timer in _ch_do_close_read_write
+		NETP_ASSERT((m_chflag & int(channel_flag::F_CLOSED)) == 0);
+		if (m_chflag & int(channel_flag::F_IO_EVENT_LOOP_NOTIFY_TERMINATING)) {
+			m_tm_transport_stats = nullptr;
+			__sock_buf_uncharge();
+			return;
+		}
+		if (get_tcp_info(m_transport_stats) != netp::OK) {
+			m_tm_transport_stats = nullptr;
+			__sock_buf_uncharge();
+			return;
+		}
+		if (m_sock_buf_autotune) {
+			_do_sock_buf_autotune();
+		}
+		L->launch(t);
+	}
 
-		if (m_chflag & int(channel_flag::F_BDLIMIT)) {
-			NETP_ASSERT( !(m_chflag & (int(channel_flag::F_WRITE_BARRIER)|int(channel_flag::F_WATCH_WRITE))));
-			m_chflag &= ~int(channel_flag::F_BDLIMIT);
-			m_chflag |= int(channel_flag::F_WRITE_BARRIER);
-			__cb_aio_write_impl(netp::OK);
-			m_chflag &= ~int(channel_flag::F_WRITE_BARRIER);
+	void socket::__sock_buf_charge() {
+		const u64_t size = u64_t(m_sock_buf.sndbuf_size) + m_sock_buf.rcvbuf_size;
+		if (m_sock_buf_budget != nullptr) {
+			if (size > m_sock_buf_charged) {
+				m_sock_buf_budget->acquire(size - m_sock_buf_charged);
+			} else if (size < m_sock_buf_charged) {
+				m_sock_buf_budget->release(m_sock_buf_charged - size);
+			}
+		}
+		m_sock_buf_charged = size;
+	}
+
+	void socket::__sock_buf_uncharge() {
+		if (m_sock_buf_budget != nullptr && m_sock_buf_charged != 0) {
+			m_sock_buf_budget->release(m_sock_buf_charged);
 		}
+		m_sock_buf_charged = 0;
 	}
 
+	//grow by 2x once the demand reaches 3/4 of the current size (demand is doubled for the kernel bookkeeping overhead, as tcp_wmem/tcp_rmem do)
+	//a smaller buffer throttles the measured demand in turn, so only an idle direction is shrunk (by half each interval), or one over the budget (down to its demand)
+	void socket::__sock_buf_autotune(bool snd, u64_t demand, u64_t floor) {
+		//an unlocked buffer is grown by the kernel itself, start from what it is now
+		int rt = snd ? set_snd_buffer_size(0) : set_rcv_buffer_size(0);
+		if (rt != netp::OK) {
+			return;
+		}
+		__sock_buf_charge();
+
+		const u32_t cur = snd ? m_sock_buf.sndbuf_size : m_sock_buf.rcvbuf_size;
+		const u32_t max = snd ? u32_t(channel_buf_range::CH_BUF_SND_MAX_SIZE) : u32_t(channel_buf_range::CH_BUF_RCV_MAX_SIZE);
+		const u8_t locked = snd ? 0x1 : 0x2;
+		demand <<= 1;
+
+		u64_t target = cur;
+		if (demand == 0) {
+			target = cur >> 1;
+		} else if (demand >= (u64_t(cur) - (cur>>2))) {
+			//setting it caps it by wmem_max/rmem_max, which is far below what the kernel would grow to, leave the growth to the kernel until we have taken it over
+			if (m_sock_buf_locked & locked) {
+				target = u64_t(cur) << 1;
+			}
+		}
+		if (m_sock_buf_budget != nullptr && m_sock_buf_budget->used() > m_sock_buf_budget->limit() && demand < target) {
+			target = demand;
+		}
+		if (target < floor) {
+			target = cur < floor ? cur : floor;
+		} else if (target > max) {
+			target = max;
+		}
+		if (target == cur) {
+			return;
+		}
+		if (target > cur) {
+			if (m_sock_buf_budget != nullptr && !m_sock_buf_budget->try_acquire(target - cur)) {
+				NETP_TRACE_SOCKET("[socket][%s]sock buf autotune, budget exhausted, used: %llu, limit: %llu", info().c_str(), m_sock_buf_budget->used(), m_sock_buf_budget->limit());
+				return;
+			}
+			m_sock_buf_charged += (target - cur);
+		}
+
+#ifdef _NETP_GNU_LINUX
+		//linux doubles the value set, and reports the doubled one
+		const u32_t size = u32_t(target >> 1);
+#else
+		const u32_t size = u32_t(target);
+#endif
+		rt = snd ? set_snd_buffer_size(size) : set_rcv_buffer_size(size);
+		if (rt == netp::OK) {
+			m_sock_buf_locked |= locked;
+		} else {
+			NETP_WARN("[socket][%s]sock buf autotune, set %s buffer failed: %d", info().c_str(), snd ? "snd" : "rcv", rt);
+		}
+		//account what the kernel really gives
+		__sock_buf_charge();
+		NETP_TRACE_SOCKET("[socket][%s]sock buf autotune, %s: %u -> %u, demand: %llu", info().c_str(), snd ? "snd" : "rcv", cur, snd ? m_sock_buf.sndbuf_size : m_sock_buf.rcvbuf_size, demand );
+	}
+
+	void socket::_do_sock_buf_autotune() {
+		NETP_ASSERT(L->in_event_loop());
+		channel_transport_stats const& stats = m_transport_stats;
+		const u64_t rtt = stats.min_rtt != 0 ? stats.min_rtt : stats.rtt; //in us
+		const long long dt = stats.sampled_at - m_autotune_last_at; //in ms
+		const u64_t acked = stats.bytes_acked - m_autotune_last_acked;
+		const u64_t received = stats.bytes_received - m_autotune_last_rcv;
+		m_autotune_last_at = stats.sampled_at;
+		m_autotune_last_acked = stats.bytes_acked;
+		m_autotune_last_rcv = stats.bytes_received;
+		if (rtt == 0 || dt <= 0) {
+			return;
+		}
+
+		//cwnd and delivery rate keep their last values on an idle connection, only count them if something was sent in this interval
+		u64_t snd_bdp = 0;
+		if (acked != 0) {
+			snd_bdp = (stats.delivery_rate * rtt) / 1000000;
+			const u64_t cwnd_bytes = u64_t(stats.snd_cwnd) * stats.snd_mss;
+			if (cwnd_bytes > snd_bdp) {
+				snd_bdp = cwnd_bytes;
+			}
+		}
+		//rcv_space is what the kernel itself sizes the receive buffer by
+		const u64_t rcv_bdp = received != 0 ? stats.rcv_space : 0;
+		//a buffer of a few segments at least, or the window stalls
+		u64_t floor = u64_t(stats.snd_mss) << 2;
+		if (floor < NETP_SOCKET_BUF_AUTOTUNE_MIN) {
+			floor = NETP_SOCKET_BUF_AUTOTUNE_MIN;
+		}
+		__sock_buf_autotune(true, snd_bdp, floor);
+		__sock_buf_autotune(false, rcv_bdp, floor);
+
+		//keep about half a bdp of unsent bytes in the kernel, the rest waits in our outbound queue
+		u64_t lowat = snd_bdp >> 1;
+		if (lowat < NETP_SOCKET_NOTSENT_LOWAT_MIN) {
+			lowat = NETP_SOCKET_NOTSENT_LOWAT_MIN;
+		} else if (lowat > NETP_SOCKET_NOTSENT_LOWAT_MAX) {
+			lowat = NETP_SOCKET_NOTSENT_LOWAT_MAX;
+		}
+		const u64_t diff = lowat > m_notsent_lowat ? lowat - m_notsent_lowat : m_notsent_lowat - lowat;
+		if (m_notsent_lowat != 0 && diff < (m_notsent_lowat >> 2)) {
+			return;
+		}
+		const int rt = set_notsent_lowat(u32_t(lowat));
+		if (rt != netp::OK) {
+			NETP_WARN("[socket][%s]sock buf autotune, set_notsent_lowat failed: %d", info().c_str(), rt);
+			return;
+		}
+		m_notsent_lowat = u32_t(lowat);
+	}
 
 	int socket::bind(netp::address const& addr) {
 		if (m_chflag & int(channel_flag::F_CLOSED)) {
@@ -90,6 +298,34 @@ namespace netp {
 		return rt;
 	}
 
+#ifndef _NETP_WIN
+	//a socket file left by a dead listener fails the bind with EADDRINUSE
+	//remove it only if it is a socket and no one answers on it, never touch a regular file or a live listener
+	static void __unlink_stale_unix_socket(address const& addr, int type) {
+		string_t const& path = addr.unix_path();
+		struct stat st;
+		if (::lstat(path.c_str(), &st) != 0 || !S_ISSOCK(st.st_mode)) {
+			return;
+		}
+		sockaddr_storage ss;
+		const socklen_t slen = addr.to_sockaddr(ss);
+		if (slen == 0) {
+			return;
+		}
+		const int fd = ::socket(AF_UNIX, type, 0);
+		if (fd < 0) {
+			return;
+		}
+		const int rt = ::connect(fd, reinterpret_cast<sockaddr*>(&ss), slen);
+		const int ec = errno;
+		NETP_CLOSE_SOCKET(fd);
+		if (rt != 0 && ec == ECONNREFUSED) {
+			NETP_INFO("[socket]unlink stale unix socket: %s", path.c_str());
+			::unlink(path.c_str());
+		}
+	}
+#endif
+
 	void socket::do_listen_on(address const& addr, fn_channel_initializer_t const& fn_accepted_initializer, NRP<promise<int>> const& chp, NRP<socket_cfg> const& ccfg, int backlog ) {
 		if (!L->in_event_loop()) {
 			L->schedule([_this=NRP<socket>(this), addr, fn_accepted_initializer, chp,ccfg, backlog]() ->void {
@@ -98,6 +334,11 @@ namespace netp {
 			return;
 		}
 
+#ifndef _NETP_WIN
+		if (m_family == NETP_AF_UNIX && !addr.is_null() && !addr.is_unix_abstract()) {
+			__unlink_stale_unix_socket(addr, m_type);
+		}
+#endif
 		//int rt = -10043;
 		int rt = socket::bind(addr);
 		if (rt != netp::OK) {
@@ -190,6 +431,8 @@ namespace netp {
 		if (rt != netp::OK ) {
 			goto _set_fail_and_return;
 		}
+		__cfg_timestamping();
+		_do_transport_stats_sampling(m_transport_stats_interval);
 
 #ifdef _NETP_WIN
 		//not sure linux os behaviour, to test
@@ -219,8 +462,10 @@ namespace netp {
 				fn_ch_initialize(NRP<channel>(this));
 			}
 		} catch(netp::exception const& e) {
+			//a throwing initializer fails the dial as the other exceptions do, the channel is not connected without its pipeline
 			NETP_ASSERT(e.code() != netp::OK );
 			rt = e.code();
+			goto _set_fail_and_return;
 		} catch(std::exception const& e) {
 			rt = netp_socket_get_last_errno();
 			if (rt == netp::OK) {
@@ -308,7 +553,9 @@ namespace netp {
 		NETP_ASSERT(L->in_event_loop());
 		NETP_ASSERT(!ch_is_listener());
 		int aiort = aiort_;
-		if (m_protocol == u8_t(NETP_PROTOCOL_UDP)) {
+		if (NETP_UNLIKELY(m_timestamping & u8_t(socket_timestamping::TIMESTAMPING_RX))) {
+			aiort = __do_read_timestamping(aiort);
+		} else if (m_protocol == u8_t(NETP_PROTOCOL_UDP)) {
 			while (aiort == netp::OK) {
 				NETP_ASSERT((m_chflag & (int(channel_flag::F_READ_SHUTDOWNING))) ==0 );
 				if (NETP_UNLIKELY(m_chflag & ( int(channel_flag::F_READ_SHUTDOWN) | int(channel_flag::F_CLOSE_PENDING)/*ignore the left read buffer, cuz we're closing it*/))) { return; }
@@ -317,6 +564,22 @@ namespace netp {
 					channel::ch_fire_readfrom(netp::make_ref<netp::packet>(m_rcv_buf_ptr, nbytes),m_raddr );
 				}
 			}
+		} else if (m_rcv_adaptive) {
+			//read into a right sized packet and hand it over to the pipeline without copy
+			while (aiort == netp::OK) {
+				NETP_ASSERT( (m_chflag&(int(channel_flag::F_READ_SHUTDOWNING))) == 0);
+				if (NETP_UNLIKELY(m_chflag & (int(channel_flag::F_READ_SHUTDOWN)|int(channel_flag::F_READ_ERROR) | int(channel_flag::F_CLOSE_PENDING) | int(channel_flag::F_CLOSING)))) { return; }
+				NRP<netp::packet> inbound = L->channel_rcv_packet(m_rcv_predictor.size());
+				netp::u32_t nbytes = socket_base::recv(inbound->tail(), m_rcv_predictor.size(), aiort);
+				if (NETP_LIKELY(nbytes > 0)) {
+					m_rcv_predictor.record(nbytes);
+					inbound->incre_write_idx(nbytes);
+					channel::ch_fire_read(inbound);
+				} else {
+					//the last read of a drain is EAGAIN most of the time, keep the packet for the next read on this loop
+					L->channel_rcv_packet_unfilled(std::move(inbound));
+				}
+			}
 		} else {
 			//in case socket object be destructed during ch_read
 			while (aiort == netp::OK) {
@@ -354,6 +617,53 @@ namespace netp {
 		}
 	}
 
+	//epoll keeps reporting EPOLLERR for a non empty error queue, drain it even if nobody reads or TIMESTAMPING_TX is off
+	void socket::__do_read_errqueue() {
+#ifdef _NETP_GNU_LINUX
+		netp::recv_errqueue_timestamps(*m_api, m_fd, [so = this](u32_t tstype, u32_t id, long long ns) {
+			if ((so->m_timestamping & u8_t(socket_timestamping::TIMESTAMPING_TX)) && so->m_fn_tx_timestamp != nullptr) {
+				so->m_fn_tx_timestamp(NRP<channel>(so), tstype, id, ns);
+			}
+		});
+#endif
+	}
+
+	//every packet read carries its stamps, see rx_stamped_packet
+	int socket::__do_read_timestamping(int aiort) {
+#ifdef _NETP_GNU_LINUX
+		const bool is_udp = (m_protocol == u8_t(NETP_PROTOCOL_UDP));
+		packet_rx_timestamp ts = { 0, L->poll_timestamp() };
+		while (aiort == netp::OK) {
+			NETP_ASSERT((m_chflag & (int(channel_flag::F_READ_SHUTDOWNING))) == 0);
+			if (NETP_UNLIKELY(m_chflag & (int(channel_flag::F_READ_SHUTDOWN) | int(channel_flag::F_READ_ERROR) | int(channel_flag::F_CLOSE_PENDING) | int(channel_flag::F_CLOSING)))) { break; }
+			if (m_rcv_adaptive) {
+				NRP<netp::rx_stamped_packet> inbound = netp::make_ref<netp::rx_stamped_packet>(m_rcv_predictor.size());
+				netp::u32_t nbytes = netp::recvmsg_timestamp(*m_api, m_fd, inbound->tail(), m_rcv_predictor.size(), nullptr, ts.kernel, aiort);
+				if (NETP_LIKELY(nbytes > 0)) {
+					m_rcv_predictor.record(nbytes);
+					inbound->incre_write_idx(nbytes);
+					inbound->set_rx_timestamp(ts);
+					channel::ch_fire_read(inbound);
+				}
+				continue;
+			}
+			netp::u32_t nbytes = netp::recvmsg_timestamp(*m_api, m_fd, m_rcv_buf_ptr, m_rcv_buf_size, is_udp ? &m_raddr : nullptr, ts.kernel, aiort);
+			if (NETP_LIKELY(nbytes > 0)) {
+				if (is_udp) {
+					channel::ch_fire_readfrom(netp::make_ref<netp::rx_stamped_packet>(m_rcv_buf_ptr, nbytes, ts), m_raddr);
+				} else {
+					channel::ch_fire_read(netp::make_ref<netp::rx_stamped_packet>(m_rcv_buf_ptr, nbytes, ts));
+				}
+			}
+		}
+		return aiort;
+#else
+		//_cfg_timestamping always fails
+		NETP_ASSERT(!"timestamping not supported");
+		return aiort;
+#endif
+	}
+
 	void socket::__cb_aio_write_impl(const int aiort_) {
 		int aiort = aiort_;
 		NETP_ASSERT( (m_chflag&(int(channel_flag::F_WRITE_SHUTDOWNING)|int(channel_flag::F_BDLIMIT)|int(channel_flag::F_CLOSING) )) == 0 );
@@ -374,6 +684,8 @@ namespace netp {
 					socket::_do_ch_write_impl():
 					socket::_do_ch_write_to_impl() ;
 				m_chflag &= ~int(channel_flag::F_WRITING);
+				//once a pass, the queue only drains in the loops above
+				ch_check_writability(m_noutbound_bytes, m_sock_buf.sndbuf_size);
 			}
 		}
 
@@ -435,6 +747,11 @@ namespace netp {
 		NETP_ASSERT( m_chflag&(int(channel_flag::F_WRITE_BARRIER)|int(channel_flag::F_WATCH_WRITE)) );
 		NETP_ASSERT( (m_chflag&int(channel_flag::F_BDLIMIT)) ==0);
 
+		//the coalesced writes of an iteration, the segments of a chained_packet, or the entries queued while the socket was blocked
+		if (m_outbound_limit == 0 && m_rate_limiter == nullptr && m_outbound_entry_q.size() > 1) {
+			return _do_ch_writev_impl();
+		}
+
 		//there might be a chance to be blocked a while in this loop, if set trigger another write
 		int _errno = netp::OK;
 		while ( _errno == netp::OK && m_outbound_entry_q.size() ) {
@@ -449,9 +766,22 @@ namespace netp {
 					return netp::E_CHANNEL_BDLIMIT;
 				}
 			}
+			if (m_rate_limiter != nullptr) {
+				const netp::u32_t granted = m_rate_limiter->acquire(u32_t(wlen));
+				if (granted == 0) {
+					NETP_ASSERT((m_chflag & int(channel_flag::F_RATE_LIMIT_TIMER)) == 0);
+					m_chflag |= int(channel_flag::F_RATE_LIMIT_TIMER);
+					L->launch(netp::make_ref<netp::timer>(std::chrono::nanoseconds(m_rate_limiter->wait_ns(u32_t(wlen))), &socket::_tmcb_RL, NRP<socket>(this), std::placeholders::_1));
+					return netp::E_CHANNEL_BDLIMIT;
+				}
+				wlen = granted;
+			}
 
 			NETP_ASSERT((wlen > 0) && (wlen <= m_noutbound_bytes));
 			netp::u32_t nbytes = socket_base::send(entry.data->head(), u32_t(wlen), _errno);
+			if (m_rate_limiter != nullptr && nbytes < wlen) {
+				m_rate_limiter->refund(u32_t(wlen - nbytes));
+			}
 			if (NETP_LIKELY(nbytes > 0)) {
 				m_noutbound_bytes -= nbytes;
 				if (m_outbound_limit != 0 ) {
@@ -465,7 +795,7 @@ namespace netp {
 
 				if (NETP_LIKELY(nbytes == dlen)) {
 					NETP_ASSERT(_errno == netp::OK);
-					entry.write_promise->set(netp::OK);
+					if (entry.write_promise != nullptr) { entry.write_promise->set(netp::OK); }
 					m_outbound_entry_q.pop_front();
 				} else {
 					entry.data->skip(nbytes); //ewouldblock or bdlimit
@@ -476,6 +806,65 @@ namespace netp {
 		return _errno;
 	}
 
+	//gather write of the queued entries, bdlimit is not taken into account here
+	int socket::_do_ch_writev_impl() {
+		NETP_ASSERT(m_outbound_limit == 0);
+		iov_t iov[NETP_SOCKET_SENDV_MAX_IOV];
+
+		int _errno = netp::OK;
+		while (_errno == netp::OK && m_outbound_entry_q.size()) {
+			NETP_ASSERT((m_noutbound_bytes) > 0);
+			u32_t iovcnt = 0;
+			socket_outbound_entry_t::iterator it = m_outbound_entry_q.begin();
+			while (it != m_outbound_entry_q.end() && iovcnt < NETP_SOCKET_SENDV_MAX_IOV) {
+				NETP_IOV_SET(iov[iovcnt], it->data->head(), it->data->len());
+				++iovcnt;
+				++it;
+			}
+
+			netp::u32_t nbytes = socket_base::sendv(iov, iovcnt, _errno);
+			m_noutbound_bytes -= nbytes;
+			while (nbytes > 0) {
+				socket_outbound_entry& entry = m_outbound_entry_q.front();
+				const netp::size_t dlen = entry.data->len();
+				if (nbytes >= dlen) {
+					nbytes -= u32_t(dlen);
+					if (entry.write_promise != nullptr) { entry.write_promise->set(netp::OK); }
+					m_outbound_entry_q.pop_front();
+				} else {
+					entry.data->skip(nbytes);
+					nbytes = 0;
+				}
+			}
+		}
+		return _errno;
+	}
+
+	void socket::_do_ch_flush_deferred() {
+		NETP_ASSERT(L->in_event_loop());
+		NETP_ASSERT(m_chflag & int(channel_flag::F_WRITE_FLUSH_PENDING));
+		m_chflag &= ~int(channel_flag::F_WRITE_FLUSH_PENDING);
+		if (m_outbound_entry_q.size() == 0) {
+			//a close or a close_write that waited for this flush
+			if ((m_chflag & (int(channel_flag::F_WRITE_BARRIER) | int(channel_flag::F_WATCH_WRITE) | int(channel_flag::F_BDLIMIT) | int(channel_flag::F_CLOSING))) == 0) {
+				if (m_chflag & int(channel_flag::F_CLOSE_PENDING)) {
+					_ch_do_close_read_write();
+				} else if (m_chflag & int(channel_flag::F_WRITE_SHUTDOWN_PENDING)) {
+					_ch_do_close_write();
+				}
+			}
+			return;
+		}
+		//a aio write or a close would take care of the left entries
+		if ( (m_chflag & (int(channel_flag::F_WRITE_BARRIER) | int(channel_flag::F_WATCH_WRITE) | int(channel_flag::F_BDLIMIT) | int(channel_flag::F_WRITE_ERROR) | int(channel_flag::F_WRITE_SHUTDOWNING) | int(channel_flag::F_WRITE_SHUTDOWN) | int(channel_flag::F_CLOSING)))) {
+			return;
+		}
+
+		m_chflag |= int(channel_flag::F_WRITE_BARRIER);
+		__cb_aio_write_impl(netp::OK);
+		m_chflag &= ~int(channel_flag::F_WRITE_BARRIER);
+	}
+
 	int socket::_do_ch_write_to_impl() {
 
 		NETP_ASSERT(m_outbound_entry_q.size() != 0, "%s, flag: %u", info().c_str(), m_chflag);
@@ -492,8 +881,14 @@ namespace netp {
 			//hold a copy before we do pop it from queue
 			nbytes == entry.data->len() ? NETP_ASSERT(_errno == netp::OK):NETP_ASSERT(_errno != netp::OK);
 			m_noutbound_bytes -= entry.data->len();
-			entry.write_promise->set(_errno);
+			NRP<promise<int>> wp = entry.write_promise;
 			m_outbound_entry_q.pop_front();
+			if (_errno == netp::OK) {
+				if (wp != nullptr) { wp->set(netp::OK); }
+			} else {
+				//the promise callback might close the channel
+				ch_write_failed(wp, _errno);
+			}
 		}
 		return _errno;
 	}
@@ -506,6 +901,12 @@ namespace netp {
 		m_chflag |= int(channel_flag::F_CLOSED);
 		socket::_do_aio_end_accept();
 		aio_end();
+#ifndef _NETP_WIN
+		//remove the socket file we bound, abstract names go away with the fd
+		if (m_family == NETP_AF_UNIX && !m_laddr.is_null() && !m_laddr.is_unix_abstract()) {
+			::unlink(m_laddr.unix_path().c_str());
+		}
+#endif
 		NETP_TRACE_SOCKET("[socket][%s]ch_do_close_listener end", info().c_str());
 	}
 
@@ -530,6 +931,10 @@ namespace netp {
 		NETP_ASSERT(m_outbound_entry_q.size() == 0);
 		NETP_ASSERT(m_noutbound_bytes == 0);
 
+		//give the budget back now, not on the next sample, a running timer stops itself once it is replaced
+		m_tm_transport_stats = nullptr;
+		__sock_buf_uncharge();
+
 		aio_end();
 	}
 
@@ -541,12 +946,12 @@ namespace netp {
 			prt = (netp::E_OP_INPROCESS);
 		} else if (m_chflag&int(channel_flag::F_WRITE_SHUTDOWN_PENDING)) {
 			NETP_ASSERT((m_chflag&int(channel_flag::F_WRITE_ERROR)) == 0);
-			NETP_ASSERT(m_chflag&(int(channel_flag::F_WRITING)|int(channel_flag::F_WATCH_WRITE)) );
+			NETP_ASSERT(m_chflag&(int(channel_flag::F_WRITING)|int(channel_flag::F_WATCH_WRITE)|int(channel_flag::F_WRITE_FLUSH_PENDING)) );
 			NETP_ASSERT(m_outbound_entry_q.size());
 			prt = (netp::E_CHANNEL_WRITE_SHUTDOWNING);
 		} else if (m_chflag & int(channel_flag::F_WRITE_SHUTDOWN)) {
 			prt = (netp::E_CHANNEL_WRITE_CLOSED);
-		} else if (m_chflag & (int(channel_flag::F_WRITING)|int(channel_flag::F_WATCH_WRITE)|int(channel_flag::F_BDLIMIT)) ) {
+		} else if (m_chflag & (int(channel_flag::F_WRITING)|int(channel_flag::F_WATCH_WRITE)|int(channel_flag::F_BDLIMIT)|int(channel_flag::F_WRITE_FLUSH_PENDING)) ) {
 			//write set ok might trigger ch_close_write|ch_close
 			NETP_ASSERT(m_outbound_entry_q.size());
 			m_chflag |= int(channel_flag::F_WRITE_SHUTDOWN_PENDING);
@@ -571,7 +976,7 @@ namespace netp {
 			_ch_do_close_listener();
 		} else if (m_chflag & (int(channel_flag::F_CLOSE_PENDING)|int(channel_flag::F_CLOSING)) ) {
 			prt = (netp::E_OP_INPROCESS);
-		} else if (m_chflag & (int(channel_flag::F_WRITING)|int(channel_flag::F_WATCH_WRITE)|int(channel_flag::F_BDLIMIT)) ) {
+		} else if ((m_chflag & (int(channel_flag::F_WRITING)|int(channel_flag::F_WATCH_WRITE)|int(channel_flag::F_BDLIMIT)|int(channel_flag::F_WRITE_FLUSH_PENDING))) && (m_chflag & int(channel_flag::F_CONNECTING)) == 0) {
 			//wait for write done event
 			NETP_ASSERT( ((m_chflag&int(channel_flag::F_WRITE_ERROR)) == 0) );
 
@@ -579,9 +984,15 @@ namespace netp {
 			m_chflag |= int(channel_flag::F_CLOSE_PENDING);
 			prt = (netp::E_CHANNEL_CLOSING);
 		} else {
-			if ((m_chflag & int(channel_flag::F_CONNECTING)) && ch_errno() == netp::OK) {
-				m_chflag |= int(channel_flag::F_WRITE_ERROR);
-				ch_errno() = (netp::E_CHANNEL_ABORT);
+			//abort a connect in progress (a loser of a dial race), its dial fails with E_CHANNEL_ABORT
+			NRP<promise<int>> connp;
+			if (m_chflag & int(channel_flag::F_CONNECTING)) {
+				ch_aio_end_connect();
+				connp.swap(m_connect_p);
+				if (ch_errno() == netp::OK) {
+					m_chflag |= int(channel_flag::F_WRITE_ERROR);
+					ch_errno() = (netp::E_CHANNEL_ABORT);
+				}
 			}
 
 			if (ch_errno() != netp::OK) {
@@ -594,6 +1005,9 @@ namespace netp {
 				NETP_ASSERT(m_outbound_entry_q.size() == 0);
 			}
 			_ch_do_close_read_write();
+			if (connp != nullptr) {
+				connp->set(netp::E_CHANNEL_ABORT);
+			}
 		}
 
 		if (closep) { closep->set(prt); }
@@ -601,28 +1015,28 @@ namespace netp {
 
 #define __CH_WRITEABLE_CHECK__( outlet, chp)  \
 		NETP_ASSERT(outlet->len() > 0); \
-		NETP_ASSERT(chp != nullptr); \
  \
 		if (m_chflag&(int(channel_flag::F_READ_ERROR) | int(channel_flag::F_WRITE_ERROR))) { \
-			chp->set(netp::E_CHANNEL_READ_WRITE_ERROR); \
+			ch_write_failed(chp, netp::E_CHANNEL_READ_WRITE_ERROR); \
 			return ; \
 		} \
  \
 		if ((m_chflag&int(channel_flag::F_WRITE_SHUTDOWN)) != 0) { \
-			chp->set(netp::E_CHANNEL_WRITE_CLOSED); \
+			ch_write_failed(chp, netp::E_CHANNEL_WRITE_CLOSED); \
 			return; \
 		} \
  \
 		if (m_chflag&(int(channel_flag::F_WRITE_SHUTDOWN_PENDING)|int(channel_flag::F_WRITE_SHUTDOWNING) | int(channel_flag::F_CLOSE_PENDING) | int(channel_flag::F_CLOSING)) ) { \
-			chp->set(netp::E_CHANNEL_WRITE_SHUTDOWNING); \
+			ch_write_failed(chp, netp::E_CHANNEL_WRITE_SHUTDOWNING); \
 			return ; \
 		} \
  \
 		const u32_t outlet_len = (u32_t)outlet->len(); \
 		if ( (m_noutbound_bytes > 0) && (m_noutbound_bytes + outlet_len > m_sock_buf.sndbuf_size)) { \
 			NETP_ASSERT(m_noutbound_bytes > 0); \
-			NETP_ASSERT(m_chflag&(int(channel_flag::F_WRITE_BARRIER)|int(channel_flag::F_WATCH_WRITE))); \
-			chp->set(netp::E_CHANNEL_WRITE_BLOCK); \
+			NETP_ASSERT(m_chflag&(int(channel_flag::F_WRITE_BARRIER)|int(channel_flag::F_WATCH_WRITE)|int(channel_flag::F_WRITE_FLUSH_PENDING)|int(channel_flag::F_BDLIMIT))); \
+			ch_write_blocked(); \
+			ch_write_failed(chp, netp::E_CHANNEL_WRITE_BLOCK); \
 			return; \
 		} \
 
@@ -635,8 +1049,45 @@ namespace netp {
 			chp
 		});
 		m_noutbound_bytes += outlet_len;
+		_do_ch_write_kick();
+	}
 
+	void socket::ch_write_impl(NRP<chained_packet> const& chain, NRP<promise<int>> const& chp)
+	{
+		NETP_ASSERT(L->in_event_loop());
+		if (m_type != u8_t(NETP_SOCK_STREAM)) {
+			//a segment would go out as a datagram of its own
+			ch_write_impl(chain->to_packet(), chp);
+			return;
+		}
+		__CH_WRITEABLE_CHECK__(chain, chp)
+		//an entry per segment, the gather write sends them together, the last one carries chp
+		const netp::size_t nsegs = chain->segment_count();
+		netp::size_t i = 0;
+		chain->for_each_segment([this, nsegs, &i, &chp](byte_t const* ptr, netp::size_t len) {
+			m_outbound_entry_q.push_back({
+				netp::make_ref<netp::packet>(ptr, len),
+				(++i == nsegs) ? chp : NRP<promise<int>>(nullptr)
+			});
+		});
+		m_noutbound_bytes += outlet_len;
+		_do_ch_write_kick();
+	}
+
+	void socket::_do_ch_write_kick() {
 		if (m_chflag&(int(channel_flag::F_WRITE_BARRIER)|int(channel_flag::F_WATCH_WRITE)|int(channel_flag::F_BDLIMIT))) {
+			ch_check_writability(m_noutbound_bytes, m_sock_buf.sndbuf_size);
+			return;
+		}
+
+		if (m_write_coalesce) {
+			if ((m_chflag & int(channel_flag::F_WRITE_FLUSH_PENDING)) == 0) {
+				m_chflag |= int(channel_flag::F_WRITE_FLUSH_PENDING);
+				L->defer([so = NRP<socket>(this)]() {
+					so->_do_ch_flush_deferred();
+				});
+			}
+			ch_check_writability(m_noutbound_bytes, m_sock_buf.sndbuf_size);
 			return;
 		}
 
@@ -648,6 +1099,7 @@ namespace netp {
 #else
 		ch_aio_write();
 #endif
+		ch_check_writability(m_noutbound_bytes, m_sock_buf.sndbuf_size);
 	}
 
 	void socket::ch_write_to_impl(NRP<packet> const& outlet, netp::address const& to, NRP<promise<int>> const& chp) {
@@ -662,6 +1114,7 @@ namespace netp {
 		m_noutbound_bytes += outlet_len;
 
 		if (m_chflag & (int(channel_flag::F_WRITE_BARRIER)|int(channel_flag::F_WATCH_WRITE)) ) {
+			ch_check_writability(m_noutbound_bytes, m_sock_buf.sndbuf_size);
 			return;
 		}
 
@@ -673,6 +1126,261 @@ namespace netp {
 #else
 		ch_aio_write();
 #endif
+		ch_check_writability(m_noutbound_bytes, m_sock_buf.sndbuf_size);
 	}
 
+	struct socket_dial_race_ctx final :
+		public netp::ref_base
+	{
+		string_t host;
+		port_t port;
+		fn_channel_initializer_t initializer;
+		NRP<channel_dial_promise> ch_dialf;
+		NRP<socket_cfg> cfg;
+
+		std::vector<address> addrs6;
+		std::vector<address> addrs4;
+		netp::size_t idx6;
+		netp::size_t idx4;
+		bool next6;
+
+		std::vector<std::pair<u32_t, NRP<socket>>> attempts;
+		u32_t seq;
+		u32_t stagger_id; //id of the pending attempt timer, 0 for none
+		u32_t won_id; //id of the attempt that ran the user initializer
+		int last_err;
+		bool resolved6;
+		bool resolved4;
+		bool started;
+		bool won;
+		bool done;
+
+		socket_dial_race_ctx():
+			port(0),
+			idx6(0),
+			idx4(0),
+			next6(true),
+			seq(0),
+			stagger_id(0),
+			won_id(0),
+			last_err(netp::E_SOCKET_NO_AVAILABLE_ADDR),
+			resolved6(false),
+			resolved4(false),
+			started(false),
+			won(false),
+			done(false)
+		{}
+
+		//interleave address families, v6 first
+		bool pick(address& addr) {
+			const bool has6 = idx6 < addrs6.size();
+			const bool has4 = idx4 < addrs4.size();
+			if (has6 && (next6 || !has4)) {
+				addr = addrs6[idx6++];
+				next6 = false;
+				return true;
+			}
+			if (has4) {
+				addr = addrs4[idx4++];
+				next6 = true;
+				return true;
+			}
+			return false;
+		}
+	};
+
+	void socket::_dial_race_begin(string_t const& host, port_t port, fn_channel_initializer_t const& initializer, NRP<channel_dial_promise> const& ch_dialf, NRP<socket_cfg> const& cfg) {
+		if (cfg->L == nullptr) {
+			cfg->L = io_event_loop_group::instance()->next();
+		}
+		if (!cfg->L->in_event_loop()) {
+			cfg->L->schedule([host, port, initializer, ch_dialf, cfg]() {
+				socket::_dial_race_begin(host, port, initializer, ch_dialf, cfg);
+			});
+			return;
+		}
+
+		NRP<socket_dial_race_ctx> ctx = netp::make_ref<socket_dial_race_ctx>();
+		ctx->host = host;
+		ctx->port = port;
+		ctx->ch_dialf = ch_dialf;
+		ctx->cfg = cfg;
+		ctx->initializer = initializer;
+
+		NRP<io_event_loop> L = cfg->L;
+		NRP<dns_query6_promise> dnsp6 = netp::dns_resolver::instance()->resolve6(host);
+		dnsp6->if_done([L, ctx](std::tuple<int, std::vector<ipv6_t, netp::allocator<ipv6_t>>> const& tupdns) {
+			std::vector<address> addrs;
+			if (std::get<0>(tupdns) == netp::OK) {
+				std::vector<ipv6_t, netp::allocator<ipv6_t>> const& ipv6s = std::get<1>(tupdns);
+				for (netp::size_t i = 0; i < ipv6s.size(); ++i) {
+					addrs.push_back(address(ipv6s[i], ctx->port));
+				}
+			}
+			const int rt = std::get<0>(tupdns);
+			L->execute([ctx, rt, addrs]() {
+				socket::_dial_race_resolved(ctx, NETP_AF_INET6, rt, addrs);
+			});
+		});
+
+		NRP<dns_query_promise> dnsp4 = netp::dns_resolver::instance()->resolve(host);
+		dnsp4->if_done([L, ctx](std::tuple<int, std::vector<ipv4_t, netp::allocator<ipv4_t>>> const& tupdns) {
+			std::vector<address> addrs;
+			if (std::get<0>(tupdns) == netp::OK) {
+				std::vector<ipv4_t, netp::allocator<ipv4_t>> const& ipv4s = std::get<1>(tupdns);
+				for (netp::size_t i = 0; i < ipv4s.size(); ++i) {
+					address __a;
+					__a.setipv4(ipv4s[i]);
+					__a.setport(ctx->port);
+					__a.setfamily(NETP_AF_INET);
+					addrs.push_back(__a);
+				}
+			}
+			const int rt = std::get<0>(tupdns);
+			L->execute([ctx, rt, addrs]() {
+				socket::_dial_race_resolved(ctx, NETP_AF_INET, rt, addrs);
+			});
+		});
+	}
+
+	void socket::_dial_race_resolved(NRP<socket_dial_race_ctx> const& ctx, int family, int rt, std::vector<address> const& addrs) {
+		NETP_ASSERT(ctx->cfg->L->in_event_loop());
+		if (ctx->done) {
+			return;
+		}
+		if (rt != netp::OK) {
+			NETP_TRACE_SOCKET("[socket]dial race, resolve %s for %s failed: %d", family == NETP_AF_INET6 ? "AAAA" : "A", ctx->host.c_str(), rt);
+			ctx->last_err = rt;
+		}
+
+		if (family == NETP_AF_INET6) {
+			ctx->resolved6 = true;
+			ctx->addrs6.insert(ctx->addrs6.end(), addrs.begin(), addrs.end());
+			_dial_race_start(ctx);
+			return;
+		}
+
+		ctx->resolved4 = true;
+		ctx->addrs4.insert(ctx->addrs4.end(), addrs.begin(), addrs.end());
+		if (ctx->resolved6 || addrs.size() == 0) {
+			_dial_race_start(ctx);
+			return;
+		}
+
+		//A answered first, give AAAA a short while
+		ctx->cfg->L->launch(netp::make_ref<netp::timer>(std::chrono::milliseconds(NETP_SOCKET_DIAL_RESOLUTION_DELAY_DUR), [ctx](NRP<netp::timer> const&) {
+			_dial_race_start(ctx);
+		}));
+	}
+
+	void socket::_dial_race_start(NRP<socket_dial_race_ctx> const& ctx) {
+		if (ctx->done) {
+			return;
+		}
+		if (!ctx->started) {
+			ctx->started = true;
+			_dial_race_next(ctx);
+			return;
+		}
+		//new addresses while racing, start one now if no attempt is in flight, or put them on the stagger schedule
+		if (ctx->attempts.size() == 0) {
+			_dial_race_next(ctx);
+		} else if (ctx->stagger_id == 0) {
+			_dial_race_stagger(ctx, ++ctx->seq);
+		}
+	}
+
+	void socket::_dial_race_stagger(NRP<socket_dial_race_ctx> const& ctx, u32_t id) {
+		ctx->stagger_id = id;
+		ctx->cfg->L->launch(netp::make_ref<netp::timer>(std::chrono::milliseconds(ctx->cfg->dial_attempt_delay), [ctx, id](NRP<netp::timer> const&) {
+			if (id == ctx->stagger_id) {
+				ctx->stagger_id = 0;
+				_dial_race_next(ctx);
+			}
+		}));
+	}
+
+	void socket::_dial_race_next(NRP<socket_dial_race_ctx> const& ctx) {
+		NETP_ASSERT(ctx->cfg->L->in_event_loop());
+		if (ctx->done) {
+			return;
+		}
+		//invalidate the pending attempt timer
+		const u32_t id = ++ctx->seq;
+		ctx->stagger_id = 0;
+		address addr;
+		if (!ctx->pick(addr)) {
+			if (ctx->attempts.size() == 0 && ctx->resolved6 && ctx->resolved4) {
+				NETP_WARN("[socket]dial race for %s failed: %d", ctx->host.c_str(), ctx->last_err);
+				ctx->done = true;
+				ctx->ch_dialf->set(std::make_tuple(ctx->last_err, nullptr));
+			}
+			return;
+		}
+
+		NRP<channel_dial_promise> dialf = netp::make_ref<channel_dial_promise>();
+		dialf->if_done([ctx, id](std::tuple<int, NRP<channel>> const& tupc) {
+			socket::_dial_race_attempt_done(ctx, id, tupc);
+		});
+
+		//only the first connected attempt may run the user initializer, a throw fails the attempt and the race with it
+		const fn_channel_initializer_t initializer = [ctx, id](NRP<channel> const& ch) {
+			if (ctx->won || ctx->done) {
+				NETP_THROW2(netp::E_OP_ABORT, "dial race lost");
+			}
+			ctx->won = true;
+			ctx->won_id = id;
+			if (ctx->initializer != nullptr) {
+				ctx->initializer(ch);
+			}
+		};
+
+		//register before dialing, dialf might be set in place
+		ctx->attempts.push_back(std::make_pair(id, NRP<socket>(nullptr)));
+		NRP<socket> so = __do_dial(addr, initializer, dialf, ctx->cfg->clone());
+		for (netp::size_t i = 0; i < ctx->attempts.size(); ++i) {
+			if (ctx->attempts[i].first == id) {
+				ctx->attempts[i].second = so;
+				break;
+			}
+		}
+
+		if (ctx->done || id != ctx->seq) {
+			return;
+		}
+		_dial_race_stagger(ctx, id);
+	}
+
+	void socket::_dial_race_attempt_done(NRP<socket_dial_race_ctx> const& ctx, u32_t id, std::tuple<int, NRP<channel>> const& tupc) {
+		NETP_ASSERT(ctx->cfg->L->in_event_loop());
+		for (netp::size_t i = 0; i < ctx->attempts.size(); ++i) {
+			if (ctx->attempts[i].first == id) {
+				ctx->attempts.erase(ctx->attempts.begin() + i);
+				break;
+			}
+		}
+
+		const int rt = std::get<0>(tupc);
+		if (ctx->done) {
+			NETP_ASSERT(rt != netp::OK);
+			return;
+		}
+		//the winner fails only if the user initializer threw, the race ends with it
+		if (rt != netp::OK && !(ctx->won && ctx->won_id == id)) {
+			ctx->last_err = rt;
+			_dial_race_next(ctx);
+			return;
+		}
+
+		ctx->done = true;
+		std::vector<std::pair<u32_t, NRP<socket>>> losers;
+		losers.swap(ctx->attempts);
+		for (netp::size_t i = 0; i < losers.size(); ++i) {
+			//a connecting socket is aborted by close, its dial promise fails with E_CHANNEL_ABORT
+			if (losers[i].second != nullptr) {
+				losers[i].second->ch_close_impl(nullptr);
+			}
+		}
+		ctx->ch_dialf->set(tupc);
+	}
 } //end of ns
@@ -201,6 +201,158 @@ namespace netp {
 		return netp::OK;
 	}
 
+	int socket_base::_cfg_max_pacing_rate(u32_t rate) {
+		NETP_RETURN_V_IF_MATCH(netp::E_INVALID_OPERATION, m_fd == NETP_INVALID_SOCKET);
+#ifdef SO_MAX_PACING_RATE
+		int rt = m_api->setsockopt(m_fd, SOL_SOCKET, SO_MAX_PACING_RATE, &rate, sizeof(rate));
+		NETP_RETURN_V_IF_MATCH(netp_socket_get_last_errno(), rt == NETP_SOCKET_ERROR);
+		return netp::OK;
+#else
+		(void)rate;
+		return netp::E_INVALID_OPERATION;
+#endif
+	}
+
+	int socket_base::_cfg_notsent_lowat(u32_t lowat) {
+		NETP_RETURN_V_IF_MATCH(netp::E_INVALID_OPERATION, m_fd == NETP_INVALID_SOCKET);
+		NETP_RETURN_V_IF_MATCH(netp::E_INVALID_OPERATION, m_protocol != u16_t(NETP_PROTOCOL_TCP) || m_family == NETP_AF_UNIX || m_family == NETP_AF_USER);
+#ifdef TCP_NOTSENT_LOWAT
+		int rt = m_api->setsockopt(m_fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, &lowat, sizeof(lowat));
+		NETP_RETURN_V_IF_MATCH(netp_socket_get_last_errno(), rt == NETP_SOCKET_ERROR);
+		return netp::OK;
+#else
+		(void)lowat;
+		return netp::E_INVALID_OPERATION;
+#endif
+	}
+
+	int socket_base::_cfg_timestamping(u8_t flags) {
+		NETP_RETURN_V_IF_MATCH(netp::E_INVALID_OPERATION, m_fd == NETP_INVALID_SOCKET);
+		NETP_RETURN_V_IF_MATCH(netp::E_INVALID_OPERATION, m_family == NETP_AF_USER);
+#ifdef _NETP_GNU_LINUX
+		int val = 0;
+		if (flags & u8_t(socket_timestamping::TIMESTAMPING_RX)) {
+			val |= SOF_TIMESTAMPING_RX_SOFTWARE;
+		}
+		if (flags & u8_t(socket_timestamping::TIMESTAMPING_TX)) {
+			val |= SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+			if (m_type == NETP_SOCK_STREAM) {
+				val |= SOF_TIMESTAMPING_TX_ACK;
+			}
+		}
+		if (val != 0) {
+			val |= SOF_TIMESTAMPING_SOFTWARE;
+		}
+		int rt = m_api->setsockopt(m_fd, SOL_SOCKET, SO_TIMESTAMPING, &val, sizeof(val));
+		if (rt == NETP_SOCKET_ERROR && flags == u8_t(socket_timestamping::TIMESTAMPING_RX)) {
+			//older kernel, rx only
+			val = 1;
+			rt = m_api->setsockopt(m_fd, SOL_SOCKET, SO_TIMESTAMPNS, &val, sizeof(val));
+		}
+		NETP_RETURN_V_IF_MATCH(netp_socket_get_last_errno(), rt == NETP_SOCKET_ERROR);
+		return netp::OK;
+#else
+		(void)flags;
+		return netp::E_INVALID_OPERATION;
+#endif
+	}
+
+#ifdef _NETP_GNU_LINUX
+	//kernel layout up to tcpi_delivery_rate (4.9), glibc's tcp_info stops at tcpi_total_retrans
+	//fields the running kernel does not fill stay zero
+	struct __tcp_info_ext {
+		u8_t tcpi_state;
+		u8_t tcpi_ca_state;
+		u8_t tcpi_retransmits;
+		u8_t tcpi_probes;
+		u8_t tcpi_backoff;
+		u8_t tcpi_options;
+		u8_t tcpi_snd_rcv_wscale;
+		u8_t tcpi_delivery_rate_app_limited;
+
+		u32_t tcpi_rto;
+		u32_t tcpi_ato;
+		u32_t tcpi_snd_mss;
+		u32_t tcpi_rcv_mss;
+
+		u32_t tcpi_unacked;
+		u32_t tcpi_sacked;
+		u32_t tcpi_lost;
+		u32_t tcpi_retrans;
+		u32_t tcpi_fackets;
+
+		u32_t tcpi_last_data_sent;
+		u32_t tcpi_last_ack_sent;
+		u32_t tcpi_last_data_recv;
+		u32_t tcpi_last_ack_recv;
+
+		u32_t tcpi_pmtu;
+		u32_t tcpi_rcv_ssthresh;
+		u32_t tcpi_rtt;
+		u32_t tcpi_rttvar;
+		u32_t tcpi_snd_ssthresh;
+		u32_t tcpi_snd_cwnd;
+		u32_t tcpi_advmss;
+		u32_t tcpi_reordering;
+
+		u32_t tcpi_rcv_rtt;
+		u32_t tcpi_rcv_space;
+
+		u32_t tcpi_total_retrans;
+
+		u64_t tcpi_pacing_rate;
+		u64_t tcpi_max_pacing_rate;
+		u64_t tcpi_bytes_acked;
+		u64_t tcpi_bytes_received;
+		u32_t tcpi_segs_out;
+		u32_t tcpi_segs_in;
+
+		u32_t tcpi_notsent_bytes;
+		u32_t tcpi_min_rtt;
+		u32_t tcpi_data_segs_in;
+		u32_t tcpi_data_segs_out;
+
+		u64_t tcpi_delivery_rate;
+	};
+	static_assert(offsetof(__tcp_info_ext, tcpi_delivery_rate) == 160, "__tcp_info_ext layout check failed");
+#endif
+
+	int socket_base::_get_tcp_info(channel_transport_stats& stats) {
+		NETP_RETURN_V_IF_MATCH(netp::E_INVALID_OPERATION, m_fd == NETP_INVALID_SOCKET);
+		NETP_RETURN_V_IF_MATCH(netp::E_INVALID_OPERATION, m_protocol != u16_t(NETP_PROTOCOL_TCP) || m_family == NETP_AF_UNIX || m_family == NETP_AF_USER);
+#ifdef _NETP_GNU_LINUX
+		__tcp_info_ext ti;
+		::memset(&ti, 0, sizeof(ti));
+		socklen_t len = sizeof(ti);
+		int rt = m_api->getsockopt(m_fd, IPPROTO_TCP, TCP_INFO, &ti, &len);
+		NETP_RETURN_V_IF_MATCH(netp_socket_get_last_errno(), rt == NETP_SOCKET_ERROR);
+
+		stats.sampled_at = netp::steady_now<std::chrono::milliseconds>().time_since_epoch().count();
+		stats.rtt = ti.tcpi_rtt;
+		stats.rttvar = ti.tcpi_rttvar;
+		stats.min_rtt = ti.tcpi_min_rtt;
+		stats.rto = ti.tcpi_rto;
+		stats.snd_mss = ti.tcpi_snd_mss;
+		stats.snd_cwnd = ti.tcpi_snd_cwnd;
+		stats.snd_ssthresh = ti.tcpi_snd_ssthresh;
+		stats.unacked = ti.tcpi_unacked;
+		stats.lost = ti.tcpi_lost;
+		stats.retrans = ti.tcpi_retrans;
+		stats.total_retrans = ti.tcpi_total_retrans;
+		stats.notsent_bytes = ti.tcpi_notsent_bytes;
+		stats.rcv_rtt = ti.tcpi_rcv_rtt;
+		stats.rcv_space = ti.tcpi_rcv_space;
+		stats.delivery_rate = ti.tcpi_delivery_rate;
+		stats.pacing_rate = ti.tcpi_pacing_rate;
+		stats.bytes_acked = ti.tcpi_bytes_acked;
+		stats.bytes_received = ti.tcpi_bytes_received;
+		return netp::OK;
+#else
+		(void)stats;
+		return netp::E_INVALID_OPERATION;
+#endif
+	}
+
 	int socket_base::_cfg_option(u16_t opt, keep_alive_vals const& kvals) {
 		//force nonblocking
 		int rt = _cfg_nonblocking((opt& u16_t(socket_option::OPTION_NON_BLOCKING)) != 0);
@@ -214,12 +366,12 @@ namespace netp {
 		NETP_RETURN_V_IF_MATCH(NETP_SOCKET_ERROR, rt == NETP_SOCKET_ERROR);
 #endif
 		
-		if (m_protocol == NETP_PROTOCOL_UDP) {
+		if (m_protocol == NETP_PROTOCOL_UDP && m_family != NETP_AF_UNIX) {
 			rt = _cfg_broadcast((opt & u16_t(socket_option::OPTION_BROADCAST)) != 0);
 			NETP_RETURN_V_IF_NOT_MATCH(rt, rt == netp::OK);
 		}
 
-		if (m_protocol == NETP_PROTOCOL_TCP) {
+		if (m_protocol == NETP_PROTOCOL_TCP && m_family != NETP_AF_UNIX) {
 			rt = _cfg_nodelay((opt & u16_t(socket_option::OPTION_NODELAY)) != 0);
 			NETP_RETURN_V_IF_NOT_MATCH(rt, rt == netp::OK);
 
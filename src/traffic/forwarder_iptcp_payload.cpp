@@ -28,6 +28,13 @@ namespace netp { namespace traffic {
 		});
 	}
 
+	void iptcp_payload_dst_handler::writability_changed(NRP<netp::channel_handler_context> const& ctx, bool writable) {
+		(void)ctx;
+		m_forwarder->m_loop->execute([F = m_forwarder, writable]() {
+			F->_dst_writability_changed(writable);
+		});
+	}
+
 	void iptcp_payload_dst_handler::read(NRP<netp::channel_handler_context> const& ctx, NRP<netp::packet> const& income) {
 		m_forwarder->m_loop->execute([F = m_forwarder, ctx,income]() {
 			F->_dst_read(ctx, income);
@@ -42,6 +49,10 @@ namespace netp { namespace traffic {
 
 		m_dst_ch = ctx->ch;
 		m_repeater_src_to_dst = netp::make_ref<netp::traffic::repeater<NRP<channel_handler_context>>>(m_loop, ctx, (m_src_rcv_wnd<<1));
+		//dst is dialed on m_loop, see _dial_dst
+		if (ctx->L == m_loop) {
+			m_repeater_src_to_dst->watch_writability();
+		}
 
 		m_repeater_src_to_dst->bind<netp::traffic::fn_repeater_event_t>(netp::traffic::repeater_event::e_finished, [dst_ch = ctx->ch]() {
 			dst_ch->ch_close_write();
@@ -95,6 +106,24 @@ namespace netp { namespace traffic {
 		(void)ctx;
 		NETP_ASSERT(m_loop->in_event_loop());
 		m_repeater_dst_to_src->finish();
+
+#ifdef _DEBUG
+		//path conditions of the dst leg, for slow tunnel diagnosing, debug build only, not worth a TCP_INFO query per close otherwise
+		m_dst_ch->ch_get_transport_stats()->if_done([src_ch_id = m_src_channel_id](std::tuple<int, channel_transport_stats> const& tups) {
+			if (std::get<0>(tups) != netp::OK) {
+				return;
+			}
+			channel_transport_stats const& s = std::get<1>(tups);
+			NETP_DEBUG("[forwarder_iptcp_payload][s%u]dst transport, rtt: %uus, rttvar: %uus, cwnd: %u, total_retrans: %u, delivery_rate: %llu", src_ch_id, s.rtt, s.rttvar, s.snd_cwnd, s.total_retrans, (unsigned long long)s.delivery_rate);
+		});
+#endif
+	}
+
+	void forwarder_iptcp_payload::_dst_writability_changed(bool writable) {
+		NETP_ASSERT(m_loop->in_event_loop());
+		if (m_repeater_src_to_dst != nullptr) {
+			m_repeater_src_to_dst->writability_changed(writable);
+		}
 	}
 
 	void forwarder_iptcp_payload::_dst_read(NRP<netp::channel_handler_context> const& ctx, NRP<netp::packet> const& income) {
@@ -129,13 +158,18 @@ namespace netp { namespace traffic {
 
 		NRP<socket_cfg> cfg = netp::make_ref<socket_cfg>();
 		cfg->sock_buf = { m_src_snd_wnd, m_src_rcv_wnd };
+		//the src to dst repeater pipelines its writes while dst is writable, it has to be on our loop for that
+		if (m_loop->type() == NETP_DEFAULT_POLLER_TYPE) {
+			cfg->L = m_loop;
+		}
+		cfg->wwm = { m_src_rcv_wnd, (m_src_rcv_wnd>>1) };
 		netp::socket::do_dial(dialurl.c_str(), dialurl.length(), [F = NRP<forwarder_iptcp_payload>(this)](NRP<netp::channel> const& ch) {
 			ch->pipeline()->add_last(netp::make_ref<iptcp_payload_dst_handler>(F));
 		},dial_p, std::move(cfg) );
 	}
 
 	forwarder_iptcp_payload::forwarder_iptcp_payload() :
-		channel_handler_abstract(netp::CH_ACTIVITY_CONNECTED | netp::CH_ACTIVITY_CLOSED | netp::CH_ACTIVITY_READ_CLOSED | netp::CH_INBOUND_READ)
+		channel_handler_abstract(netp::CH_ACTIVITY_CONNECTED | netp::CH_ACTIVITY_CLOSED | netp::CH_ACTIVITY_READ_CLOSED | netp::CH_ACTIVITY_WRITABILITY_CHANGED | netp::CH_INBOUND_READ)
 	{}
 
 	void forwarder_iptcp_payload::connected(NRP<netp::channel_handler_context> const& ctx) {
@@ -158,6 +192,9 @@ namespace netp { namespace traffic {
 		NETP_ASSERT(m_src_snd_wnd>0);
 
 		m_repeater_dst_to_src = netp::make_ref<netp::traffic::repeater<NRP<netp::channel_handler_context>>>(m_loop, ctx, (m_src_snd_wnd<<1) );
+		//src (a mux stream or a socket) is on m_loop, pipeline the dst to src writes while it is writable
+		ctx->ch->ch_set_write_watermark(m_src_snd_wnd, (m_src_snd_wnd>>1));
+		m_repeater_dst_to_src->watch_writability();
 		m_repeater_dst_to_src->bind<netp::traffic::fn_repeater_event_t>(netp::traffic::repeater_event::e_finished, [src_ch=ctx->ch]() {
 			src_ch->ch_close_write();
 		});
@@ -178,6 +215,11 @@ namespace netp { namespace traffic {
 		}
 	}
 
+	void forwarder_iptcp_payload::writability_changed(NRP<netp::channel_handler_context> const& ctx, bool writable) {
+		(void)ctx;
+		m_repeater_dst_to_src->writability_changed(writable);
+	}
+
 	void forwarder_iptcp_payload::read(NRP<netp::channel_handler_context> const& ctx, NRP<netp::packet> const& income ) { 
 
 	__check_read_begin:
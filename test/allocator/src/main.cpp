@@ -0,0 +1,136 @@
+// allocator micro benchmark
+// 1, size class lookup, the table scan of the 8 slot layout vs pool_align_allocator::size_class
+// 2, malloc/free of netp::allocator vs std::malloc, fixed sizes and a random mix with a window of live blocks
+
+//example:
+//allocator.exe
+
+#include <vector>
+#include <chrono>
+#include <random>
+
+#include <netp.hpp>
+
+#define LOOKUP_ROUND (1024*1024*16)
+#define ALLOC_ROUND (1024*1024*4)
+#define ALLOC_WINDOW (1024)
+
+//the table scan the O(1) lookup replaced, kept here as the reference
+const static size_t LEGACY_TABLE_UP_BOUND[netp::TABLE::T_COUNT + 1] = {
+	0, 8 * 16, 48 * 8, 112 * 8, 240 * 8, 496 * 8, 1008 * 8, 16128 * 8, 258048 * 8
+};
+
+inline void legacy_calc_TABLE_SLOT(size_t& size, netp::u8_t& table, netp::u8_t& slot) {
+	for (netp::u8_t t = 1; t < (netp::TABLE::T_COUNT + 1); ++t) {
+		if (size <= LEGACY_TABLE_UP_BOUND[t]) {
+			table = (--t);
+			break;
+		}
+	}
+	if (table == netp::TABLE::T0) {
+		slot = netp::u8_t(size >> 3);
+		(size % 8) != 0 ? ++slot : 0;
+		size = (slot << 3);
+		--slot;
+	} else if (table < netp::TABLE::T6) {
+		size -= LEGACY_TABLE_UP_BOUND[table];
+		slot = netp::u8_t(size >> (table + 4));
+		(size % size_t(1 << (table + 4))) != 0 ? ++slot : 0;
+		size = LEGACY_TABLE_UP_BOUND[table] + (slot << (table + 4));
+		--slot;
+	} else if (table < netp::TABLE::T_COUNT) {
+		const size_t LIMIT = LEGACY_TABLE_UP_BOUND[table];
+		for (netp::u8_t j = 0; j < 8; ++j) {
+			if (size <= (((j + 1) << 1) * LIMIT)) {
+				size = (((j + 1) << 1) * LIMIT);
+				slot = j;
+				return;
+			}
+		}
+	}
+}
+
+inline double ns_per_op(std::chrono::steady_clock::time_point const& begin, size_t ops) {
+	return double(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count()) / double(ops);
+}
+
+std::vector<size_t> make_sizes(size_t max) {
+	std::mt19937 rng(0);
+	std::uniform_int_distribution<size_t> dist(1, max);
+	std::vector<size_t> sizes(4096);
+	for (size_t i = 0; i < sizes.size(); ++i) {
+		sizes[i] = dist(rng);
+	}
+	return sizes;
+}
+
+void bench_lookup() {
+	const std::vector<size_t> sizes = make_sizes(258048 * 8);
+	const std::vector<size_t> small_sizes = make_sizes(8064);
+
+	for (int k = 0; k < 2; ++k) {
+		std::vector<size_t> const& s = k == 0 ? small_sizes : sizes;
+		size_t sum = 0;
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < LOOKUP_ROUND; ++i) {
+			size_t size = s[i & (s.size() - 1)];
+			netp::u8_t t = netp::TABLE::T_COUNT, slot = netp::u8_t(-1);
+			legacy_calc_TABLE_SLOT(size, t, slot);
+			sum += size + t + slot;
+		}
+		const double legacy = ns_per_op(begin, LOOKUP_ROUND);
+
+		begin = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < LOOKUP_ROUND; ++i) {
+			size_t size = s[i & (s.size() - 1)];
+			netp::u8_t t, slot;
+			netp::pool_align_allocator::size_class(size, t, slot);
+			sum += size + t + slot;
+		}
+		const double o1 = ns_per_op(begin, LOOKUP_ROUND);
+		NETP_INFO("[lookup][%s]table scan: %.2f ns, size_class: %.2f ns, (%zu)", k == 0 ? "<=8064" : "<=2M", legacy, o1, sum);
+	}
+}
+
+template <class _malloc_t, class _free_t>
+double bench_alloc(std::vector<size_t> const& sizes, _malloc_t const& m, _free_t const& f) {
+	std::vector<void*> window(ALLOC_WINDOW, nullptr);
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < ALLOC_ROUND; ++i) {
+		void*& p = window[i & (ALLOC_WINDOW - 1)];
+		if (p != nullptr) {
+			f(p);
+		}
+		p = m(sizes[i & (sizes.size() - 1)]);
+		*((char*)p) = char(i);
+	}
+	const double r = ns_per_op(begin, ALLOC_ROUND);
+	for (size_t i = 0; i < window.size(); ++i) {
+		f(window[i]);
+	}
+	return r;
+}
+
+void bench_alloc_all(const char* tag, std::vector<size_t> const& sizes) {
+	const double pool = bench_alloc(sizes, [](size_t n) { return (void*)netp::allocator<char>::malloc(n); }, [](void* p) { netp::allocator<char>::free((char*)p); });
+	const double sys = bench_alloc(sizes, [](size_t n) { return std::malloc(n); }, [](void* p) { std::free(p); });
+	NETP_INFO("[alloc][%s]netp::allocator: %.2f ns, std::malloc: %.2f ns", tag, pool, sys);
+}
+
+int main(int argc, char** argv) {
+	(void)argc;
+	(void)argv;
+	netp::app _app;
+
+	bench_lookup();
+
+	bench_alloc_all("64", std::vector<size_t>(1, 64));
+	bench_alloc_all("1920", std::vector<size_t>(1, 1920));
+	bench_alloc_all("mix<=8064", make_sizes(8064));
+	bench_alloc_all("mix<=128K", make_sizes(129024));
+
+	netp::pool_align_allocator_stats stats;
+	netp::tls_get<netp::pool_align_allocator_t>()->stats(stats);
+	netp::pool_align_allocator::stats_dump(stats);
+	return 0;
+}
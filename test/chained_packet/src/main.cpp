@@ -0,0 +1,249 @@
+// chained_packet
+// 1, append/prepend of packets and chains link the bytes in without a copy
+// 2, write/write_left copy into the tail/head segment only if the chain owns it
+// 3, read/peek/skip/slice work across segments, == compares the bytes whatever the segmentation
+// 4, to_iov exports the segments, capped by iovcnt
+// 5, ch_write of a chain without outbound handlers is sent by one gather write, a sendv of every segment
+// 6, ch_write of a chain through hlen is flattened into one message
+
+//example:
+//chained_packet.exe
+
+#include <chrono>
+#include <atomic>
+
+#include <netp.hpp>
+#include <netp/handler/hlen.hpp>
+
+#define LISTEN_URL_RAW "tcp://127.0.0.1:22319"
+#define LISTEN_URL_HLEN "tcp://127.0.0.1:22320"
+#define SEGMENT_SIZE 1000
+#define SEGMENT_COUNT 3
+
+std::atomic<int> g_sendv_calls(0);
+std::atomic<int> g_sendv_iovcnt(0);
+
+#define CP_CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			NETP_ERR("[chained_packet]check failed: %s, line: %d", #cond, __LINE__); \
+			return -2; \
+		} \
+	} while (0)
+
+NRP<netp::packet> make_packet(const char* str) {
+	return netp::make_ref<netp::packet>(str, netp::strlen(str));
+}
+
+bool equals(NRP<netp::chained_packet> const& chain, const char* str) {
+	NRP<netp::packet> p = chain->to_packet();
+	return p->len() == netp::strlen(str) && ::memcmp(p->head(), str, p->len()) == 0;
+}
+
+int check_link() {
+	//1
+	NRP<netp::packet> world = make_packet("world");
+	NRP<netp::chained_packet> chain = netp::make_ref<netp::chained_packet>(world);
+	chain->prepend(make_packet("hello "));
+	CP_CHECK(chain->len() == 11 && chain->segment_count() == 2);
+	CP_CHECK(equals(chain, "hello world"));
+
+	NRP<netp::chained_packet> other = netp::make_ref<netp::chained_packet>(make_packet(", bye"));
+	chain->append(other);
+	CP_CHECK(chain->segment_count() == 3 && equals(chain, "hello world, bye"));
+	NRP<netp::chained_packet> head = netp::make_ref<netp::chained_packet>(make_packet(">> "));
+	chain->prepend(head);
+	CP_CHECK(chain->segment_count() == 4 && equals(chain, ">> hello world, bye"));
+	//linked, not copied
+	CP_CHECK(other->len() == 5 && head->len() == 3);
+
+	chain->append(netp::make_ref<netp::packet>());
+	CP_CHECK(chain->segment_count() == 4);
+
+	//the chain of a single whole packet is the packet itself
+	CP_CHECK(netp::make_ref<netp::chained_packet>(world)->to_packet() == world);
+	return netp::OK;
+}
+
+int check_write() {
+	//2, the tail packet is shared with world, a write links a new segment
+	NRP<netp::packet> world = make_packet("world");
+	NRP<netp::chained_packet> chain = netp::make_ref<netp::chained_packet>(world);
+	chain->write<netp::u32_t>(0x01020304);
+	CP_CHECK(chain->segment_count() == 2 && world->len() == 5);
+	//the new tail is owned by the chain
+	chain->write<netp::u16_t>(0x0506);
+	chain->write("!", 1);
+	CP_CHECK(chain->segment_count() == 2 && chain->len() == 12);
+
+	chain->write_left<netp::u8_t>(0xAA);
+	CP_CHECK(chain->segment_count() == 3);
+	chain->write_left<netp::u8_t>(0xBB);
+	CP_CHECK(chain->segment_count() == 3 && chain->len() == 14);
+
+	//3
+	CP_CHECK(chain->peek<netp::u16_t>() == 0xBBAA);
+	CP_CHECK(chain->read<netp::u16_t>() == 0xBBAA);
+	netp::byte_t w[5];
+	CP_CHECK(chain->read(w, 5) == 5 && ::memcmp(w, "world", 5) == 0);
+	CP_CHECK(chain->read<netp::u32_t>() == 0x01020304);
+	chain->skip(2);
+	CP_CHECK(chain->len() == 1 && chain->read<netp::u8_t>() == '!');
+	CP_CHECK(chain->len() == 0 && chain->segment_count() == 0);
+	return netp::OK;
+}
+
+int check_slice() {
+	//3, a u32 across 3 segments
+	NRP<netp::chained_packet> chain = netp::make_ref<netp::chained_packet>();
+	const char* parts[] = { "ab", "c", "def", "g", "hij" };
+	for (size_t i = 0; i < sizeof(parts) / sizeof(parts[0]); ++i) {
+		chain->append(make_packet(parts[i]));
+	}
+	CP_CHECK(chain->len() == 10 && chain->segment_count() == 5);
+	NRP<netp::chained_packet> s = chain->slice(1, 7);
+	CP_CHECK(s->len() == 7 && s->segment_count() == 5 && equals(s, "bcdefgh"));
+	CP_CHECK(chain->slice(3, 2)->segment_count() == 1 && equals(chain->slice(3, 2), "de"));
+	CP_CHECK(chain->slice(10, 0)->len() == 0);
+	//the slice does not move the chain
+	CP_CHECK(chain->len() == 10 && equals(chain, "abcdefghij"));
+
+	netp::byte_t b[4];
+	CP_CHECK(chain->peek(b, 4) == 4 && ::memcmp(b, "abcd", 4) == 0);
+	chain->skip(1);
+	CP_CHECK(chain->peek<netp::u32_t>() == ((netp::u32_t('b') << 24) | (netp::u32_t('c') << 16) | (netp::u32_t('d') << 8) | netp::u32_t('e')));
+
+	NRP<netp::chained_packet> flat = netp::make_ref<netp::chained_packet>(make_packet("bcdefghij"));
+	CP_CHECK(*chain == *flat);
+	flat->skip(1);
+	CP_CHECK(*chain != *flat);
+
+	//4
+	netp::iov_t iov[8];
+	CP_CHECK(chain->to_iov(iov, 8) == 5);
+	CP_CHECK(chain->to_iov(iov, 2) == 2);
+#ifdef _NETP_WIN
+	CP_CHECK(iov[0].len == 1 && iov[1].len == 1 && iov[0].buf[0] == 'b');
+#else
+	CP_CHECK(iov[0].iov_len == 1 && iov[1].iov_len == 1 && ((char*)iov[0].iov_base)[0] == 'b');
+#endif
+	return netp::OK;
+}
+
+int counted_sendv(netp::SOCKET fd, netp::iov_t const* iov, netp::u32_t iovcnt, int flags) {
+	++g_sendv_calls;
+	g_sendv_iovcnt = int(iovcnt);
+	return netp::NETP_DEFAULT_SOCKAPI.sendv(fd, iov, iovcnt, flags);
+}
+
+class collector :
+	public netp::channel_handler_abstract
+{
+public:
+	NRP<netp::packet> m_bytes;
+	int m_reads;
+	netp::size_t m_expected;
+	NRP<netp::promise<int>> m_done;
+
+	collector(netp::size_t expected) :
+		channel_handler_abstract(netp::CH_INBOUND_READ),
+		m_bytes(netp::make_ref<netp::packet>()),
+		m_reads(0),
+		m_expected(expected),
+		m_done(netp::make_ref<netp::promise<int>>())
+	{}
+
+	void read(NRP<netp::channel_handler_context> const& ctx, NRP<netp::packet> const& income) override {
+		(void)ctx;
+		++m_reads;
+		m_bytes->write(income->head(), income->len());
+		if (m_bytes->len() >= m_expected) {
+			m_done->set(netp::OK);
+		}
+	}
+};
+
+NRP<netp::chained_packet> make_chain() {
+	NRP<netp::chained_packet> chain = netp::make_ref<netp::chained_packet>();
+	for (int i = 0; i < SEGMENT_COUNT; ++i) {
+		NRP<netp::packet> seg = netp::make_ref<netp::packet>(SEGMENT_SIZE);
+		for (int j = 0; j < SEGMENT_SIZE; ++j) {
+			seg->write<netp::u8_t>(netp::u8_t('a' + i));
+		}
+		chain->append(seg);
+	}
+	return chain;
+}
+
+int check_ch_write(bool with_hlen) {
+	const char* url = with_hlen ? LISTEN_URL_HLEN : LISTEN_URL_RAW;
+	NRP<collector> c = netp::make_ref<collector>(SEGMENT_SIZE * SEGMENT_COUNT);
+	NRP<netp::channel_listen_promise> listenp = netp::socket::listen_on(url, [c, with_hlen](NRP<netp::channel> const& ch) {
+		if (with_hlen) {
+			ch->pipeline()->add_last(netp::make_ref<netp::handler::hlen>());
+		}
+		ch->pipeline()->add_last(c);
+	});
+	CP_CHECK(std::get<0>(listenp->get()) == netp::OK);
+
+	static netp::socket_api counted_api = netp::NETP_DEFAULT_SOCKAPI;
+	counted_api.sendv = counted_sendv;
+	NRP<netp::socket_cfg> cfg = netp::make_ref<netp::socket_cfg>();
+	cfg->sockapi = &counted_api;
+	NRP<netp::channel_dial_promise> dp = netp::socket::dial(url, [with_hlen](NRP<netp::channel> const& ch) {
+		if (with_hlen) {
+			ch->pipeline()->add_last(netp::make_ref<netp::handler::hlen>());
+		}
+	}, cfg);
+	CP_CHECK(std::get<0>(dp->get()) == netp::OK);
+	NRP<netp::channel> ch = std::get<1>(dp->get());
+
+	g_sendv_calls = 0;
+	NRP<netp::chained_packet> chain = make_chain();
+	CP_CHECK(ch->ch_write(chain)->get() == netp::OK);
+	CP_CHECK(c->m_done->get() == netp::OK);
+
+	CP_CHECK(c->m_bytes->len() == SEGMENT_SIZE * SEGMENT_COUNT);
+	CP_CHECK(*netp::make_ref<netp::chained_packet>(c->m_bytes) == *chain);
+	if (with_hlen) {
+		//6
+		CP_CHECK(g_sendv_calls == 0 && c->m_reads == 1);
+	} else {
+		//5
+		NETP_INFO("[chained_packet]sendv calls: %d, iovcnt: %d, reads: %d", g_sendv_calls.load(), g_sendv_iovcnt.load(), c->m_reads);
+		CP_CHECK(g_sendv_calls == 1 && g_sendv_iovcnt == SEGMENT_COUNT);
+	}
+
+	ch->ch_close();
+	ch->ch_close_promise()->wait();
+	std::get<1>(listenp->get())->ch_close();
+	std::get<1>(listenp->get())->ch_close_promise()->wait();
+	return netp::OK;
+}
+
+int main(int argc, char** argv) {
+	(void)argc;
+	(void)argv;
+	netp::app app;
+
+	int rt = check_link();
+	if (rt == netp::OK) {
+		rt = check_write();
+	}
+	if (rt == netp::OK) {
+		rt = check_slice();
+	}
+	if (rt == netp::OK) {
+		rt = check_ch_write(false);
+	}
+	if (rt == netp::OK) {
+		rt = check_ch_write(true);
+	}
+
+	if (rt != netp::OK) {
+		NETP_ERR("[chained_packet]failed");
+		return rt;
+	}
+	NETP_INFO("[chained_packet]done");
+	return 0;
+}
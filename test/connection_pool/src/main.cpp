@@ -0,0 +1,229 @@
+// connection_pool against a local listener, max_per_host 2, 1-4 on a pool pinned to one loop
+// 1, a released channel is handed out again by the next acquire
+// 2, the third acquire waits for a release once max_per_host reached
+// 3, idle channels failing the health check are closed on acquire, a new one is dialed
+// 4, an idle channel is closed once it expired
+// 5, a channel is handed out on the loop of the acquire, a release on one loop is not seen by another
+// 6, with health_check_interval an unhealthy idle channel is closed without any acquire
+// 7, rpc::acquire hands out the rpc of a pooled channel, the same one after a release
+
+//example:
+//connection_pool.exe
+
+#include <chrono>
+#include <atomic>
+
+#include <netp.hpp>
+
+#define LISTEN_URL "tcp://127.0.0.1:22317"
+#define RPC_LISTEN_URL "tcp://127.0.0.1:22316"
+#define MAX_PER_HOST 2
+#define IDLE_TIMEOUT 1000
+#define HEALTH_CHECK_INTERVAL 1000
+#define API_ECHO 1
+
+std::atomic<bool> g_healthy(true);
+
+#define CP_CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			NETP_ERR("[connection_pool]check failed: %s, line: %d", #cond, __LINE__); \
+			return -2; \
+		} \
+	} while (0)
+
+NRP<netp::channel> acquire(NRP<netp::connection_pool> const& pool) {
+	NRP<netp::channel_dial_promise> dp = pool->acquire(LISTEN_URL);
+	if (std::get<0>(dp->get()) != netp::OK) {
+		NETP_ERR("[connection_pool]acquire failed: %d", std::get<0>(dp->get()));
+		return nullptr;
+	}
+	return std::get<1>(dp->get());
+}
+
+//acquire on L
+NRP<netp::channel> acquire_on(NRP<netp::connection_pool> const& pool, NRP<netp::io_event_loop> const& L) {
+	NRP<netp::promise<NRP<netp::channel_dial_promise>>> p = netp::make_ref<netp::promise<NRP<netp::channel_dial_promise>>>();
+	L->execute([pool, p]() {
+		p->set(pool->acquire(LISTEN_URL));
+	});
+	NRP<netp::channel_dial_promise> dp = p->get();
+	if (std::get<0>(dp->get()) != netp::OK) {
+		NETP_ERR("[connection_pool]acquire failed: %d", std::get<0>(dp->get()));
+		return nullptr;
+	}
+	return std::get<1>(dp->get());
+}
+
+int run(NRP<netp::connection_pool> const& pool) {
+	//1
+	NRP<netp::channel> ch1 = acquire(pool);
+	CP_CHECK(ch1 != nullptr);
+	pool->release(ch1);
+	NRP<netp::channel> ch1_again = acquire(pool);
+	CP_CHECK(ch1_again == ch1);
+
+	//2
+	NRP<netp::channel> ch2 = acquire(pool);
+	CP_CHECK(ch2 != nullptr && ch2 != ch1);
+	NRP<netp::channel_dial_promise> dp3 = pool->acquire(LISTEN_URL);
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	CP_CHECK(dp3->is_idle());
+	pool->release(ch1);
+	CP_CHECK(std::get<0>(dp3->get()) == netp::OK && std::get<1>(dp3->get()) == ch1);
+	pool->release(ch1);
+	pool->release(ch2);
+
+	//3
+	g_healthy = false;
+	NRP<netp::channel> ch4 = acquire(pool);
+	g_healthy = true;
+	CP_CHECK(ch4 != nullptr && ch4 != ch1 && ch4 != ch2);
+	CP_CHECK(ch1->ch_close_promise()->get() == netp::OK);
+	CP_CHECK(ch2->ch_close_promise()->get() == netp::OK);
+
+	//4
+	const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	pool->release(ch4);
+	ch4->ch_close_promise()->wait();
+	const long long cost_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+	NETP_INFO("[connection_pool]idle channel closed after: %lld ms", cost_ms);
+	CP_CHECK(cost_ms >= IDLE_TIMEOUT);
+
+	NRP<netp::channel> ch5 = acquire(pool);
+	CP_CHECK(ch5 != nullptr && ch5 != ch4);
+	pool->release(ch5, false);
+	ch5->ch_close_promise()->wait();
+	return 0;
+}
+
+int run_cross_loop() {
+	//5
+	NRP<netp::connection_pool> pool = netp::make_ref<netp::connection_pool>(netp::make_ref<netp::connection_pool_cfg>());
+	NRP<netp::io_event_loop> L1 = netp::io_event_loop_group::instance()->next();
+	NRP<netp::io_event_loop> L2 = netp::io_event_loop_group::instance()->next();
+	CP_CHECK(L1 != L2);
+	NRP<netp::channel> ch6 = acquire_on(pool, L1);
+	CP_CHECK(ch6 != nullptr && ch6->L == L1);
+	pool->release(ch6);
+	NRP<netp::channel> ch7 = acquire_on(pool, L2);
+	CP_CHECK(ch7 != nullptr && ch7 != ch6 && ch7->L == L2);
+	CP_CHECK(acquire_on(pool, L1) == ch6);
+	pool->release(ch6, false);
+	pool->release(ch7, false);
+	ch6->ch_close_promise()->wait();
+	ch7->ch_close_promise()->wait();
+	pool->close();
+	return 0;
+}
+
+int run_health_check() {
+	//6
+	NRP<netp::connection_pool_cfg> cfg = netp::make_ref<netp::connection_pool_cfg>();
+	cfg->idle_timeout = 0;
+	cfg->health_check_interval = HEALTH_CHECK_INTERVAL;
+	cfg->health_check = [](NRP<netp::channel> const& ch) {
+		(void)ch;
+		return g_healthy.load();
+	};
+	NRP<netp::connection_pool> pool = netp::make_ref<netp::connection_pool>(cfg);
+	NRP<netp::channel> ch = acquire(pool);
+	CP_CHECK(ch != nullptr);
+	pool->release(ch);
+	std::this_thread::sleep_for(std::chrono::milliseconds(HEALTH_CHECK_INTERVAL + 500));
+	CP_CHECK(!ch->ch_close_promise()->is_done());
+
+	const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	g_healthy = false;
+	ch->ch_close_promise()->wait();
+	g_healthy = true;
+	const long long cost_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+	NETP_INFO("[connection_pool]unhealthy idle channel closed after: %lld ms", cost_ms);
+	CP_CHECK(cost_ms <= HEALTH_CHECK_INTERVAL + 500);
+	pool->close();
+	return 0;
+}
+
+int run_rpc() {
+	//7
+	NRP<netp::rpc_listen_promise> lp = netp::rpc::listen(RPC_LISTEN_URL, [](NRP<netp::rpc> const& r) {
+		r->bindcall(API_ECHO, [](NRP<netp::rpc> const& r_, NRP<netp::packet> const& in, NRP<netp::rpc_call_promise> const& callp) {
+			(void)r_;
+			callp->set(std::make_tuple(netp::OK, in));
+		});
+	});
+	CP_CHECK(std::get<0>(lp->get()) == netp::OK);
+
+	NRP<netp::connection_pool_cfg> cfg = netp::make_ref<netp::connection_pool_cfg>();
+	cfg->initializer = netp::rpc::pool_initializer();
+	NRP<netp::connection_pool> pool = netp::make_ref<netp::connection_pool>(cfg);
+
+	NRP<netp::rpc> r1;
+	for (int i = 0; i < 2; ++i) {
+		NRP<netp::rpc_dial_promise> rdp = netp::rpc::acquire(pool, RPC_LISTEN_URL);
+		CP_CHECK(std::get<0>(rdp->get()) == netp::OK);
+		NRP<netp::rpc> r = std::get<1>(rdp->get());
+		CP_CHECK(r1 == nullptr || r == r1);
+		r1 = r;
+
+		NRP<netp::packet> outp = netp::make_ref<netp::packet>();
+		outp->write<netp::u32_t>(i);
+		NRP<netp::rpc_call_promise> callp = r->call(API_ECHO, outp);
+		CP_CHECK(std::get<0>(callp->get()) == netp::OK);
+		CP_CHECK(std::get<1>(callp->get())->read<netp::u32_t>() == netp::u32_t(i));
+		pool->release(r->channel());
+	}
+	NRP<netp::channel> ch = r1->channel();
+	pool->close();
+	ch->ch_close_promise()->wait();
+	std::get<1>(lp->get())->ch_close();
+	std::get<1>(lp->get())->ch_close_promise()->wait();
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	(void)argc;
+	(void)argv;
+	netp::app_cfg appcfg;
+	appcfg.cfg_poller_count(NETP_DEFAULT_POLLER_TYPE, 2);
+	netp::app app(appcfg);
+
+	NRP<netp::channel_listen_promise> listenp = netp::socket::listen_on(LISTEN_URL, [](NRP<netp::channel> const& ch) {
+		(void)ch;
+	});
+	if (std::get<0>(listenp->get()) != netp::OK) {
+		NETP_ERR("[connection_pool]listen failed: %d", std::get<0>(listenp->get()));
+		return -1;
+	}
+
+	NRP<netp::connection_pool_cfg> cfg = netp::make_ref<netp::connection_pool_cfg>();
+	cfg->max_per_host = MAX_PER_HOST;
+	cfg->idle_timeout = IDLE_TIMEOUT;
+	cfg->health_check = [](NRP<netp::channel> const& ch) {
+		(void)ch;
+		return g_healthy.load();
+	};
+	NRP<netp::connection_pool> pool = netp::make_ref<netp::connection_pool>(cfg, netp::io_event_loop_group::instance()->next());
+
+	int rt = run(pool);
+	pool->close();
+	if (rt == netp::OK) {
+		rt = run_cross_loop();
+	}
+	if (rt == netp::OK) {
+		rt = run_health_check();
+	}
+	if (rt == netp::OK) {
+		rt = run_rpc();
+	}
+
+	std::get<1>(listenp->get())->ch_close();
+	std::get<1>(listenp->get())->ch_close_promise()->wait();
+
+	if (rt != netp::OK) {
+		NETP_ERR("[connection_pool]failed");
+		return rt;
+	}
+	NETP_INFO("[connection_pool]done");
+	return 0;
+}
@@ -0,0 +1,94 @@
+#include <netp.hpp>
+
+//build with -std=c++20, an echo server and a client written with co_await
+
+#ifdef NETP_ENABLE_COROUTINE
+
+netp::co_task<> echo_session(NRP<netp::channel> ch, NRP<netp::co_reader> r) {
+	while (true) {
+		std::tuple<int, NRP<netp::packet>> in = co_await r->read();
+		if (std::get<0>(in) != netp::OK) {
+			break;
+		}
+		const int wrt = co_await ch->ch_write(std::get<1>(in));
+		if (wrt != netp::OK) {
+			break;
+		}
+	}
+	ch->ch_close();
+}
+
+netp::co_task<int> client_session(std::string dialurl, int rounds) {
+	NRP<netp::co_reader> r = netp::make_ref<netp::co_reader>();
+	//a named initializer, gcc 12 destroys a lambda temporary of a co_await operand twice
+	const netp::fn_channel_initializer_t initializer = [r](NRP<netp::channel> const& ch) {
+		ch->pipeline()->add_last(r);
+	};
+	std::tuple<int, NRP<netp::channel>> dialt = co_await netp::co_dial(dialurl, initializer);
+	if (std::get<0>(dialt) != netp::OK) {
+		co_return std::get<0>(dialt);
+	}
+	NRP<netp::channel> ch = std::get<1>(dialt);
+
+	int echoed = 0;
+	for (int i = 0; i < rounds; ++i) {
+		NRP<netp::packet> outlet = netp::make_ref<netp::packet>();
+		outlet->write<netp::u32_t>(netp::u32_t(i));
+		const int wrt = co_await ch->ch_write(outlet);
+		if (wrt != netp::OK) {
+			break;
+		}
+		std::tuple<int, NRP<netp::packet>> in = co_await r->read();
+		if (std::get<0>(in) != netp::OK) {
+			break;
+		}
+		echoed += int(std::get<1>(in)->len() / sizeof(netp::u32_t));
+		co_await netp::co_sleep_for(ch->L, std::chrono::milliseconds(1));
+	}
+	ch->ch_close();
+	//set once the pipeline fired closed
+	co_await ch->ch_close_promise();
+	co_return echoed;
+}
+
+netp::co_task<> client_main(NRP<netp::promise<int>> donep, std::string dialurl, int rounds) {
+	const int echoed = co_await client_session(dialurl, rounds);
+	donep->set(echoed);
+}
+
+int main(int argc, char** argv) {
+	(void)argc;
+	(void)argv;
+	netp::app app;
+
+	const std::string url = "tcp://127.0.0.1:22315";
+	NRP<netp::channel_listen_promise> listenp = netp::socket::listen_on(url, [](NRP<netp::channel> const& ch) {
+		NRP<netp::co_reader> r = netp::make_ref<netp::co_reader>();
+		ch->pipeline()->add_last(r);
+		netp::co_spawn(ch->L, echo_session(ch, r));
+	});
+	if (std::get<0>(listenp->get()) != netp::OK) {
+		NETP_ERR("[coroutine]listen failed: %d", std::get<0>(listenp->get()));
+		return -1;
+	}
+
+	const int rounds = 100;
+	NRP<netp::promise<int>> donep = netp::make_ref<netp::promise<int>>();
+	netp::co_spawn(netp::io_event_loop_group::instance()->next(), client_main(donep, url, rounds));
+	NETP_INFO("[coroutine]echoed: %d/%d", donep->get(), rounds);
+
+	std::get<1>(listenp->get())->ch_close();
+	std::get<1>(listenp->get())->ch_close_promise()->wait();
+	return 0;
+}
+
+#else
+
+int main(int argc, char** argv) {
+	(void)argc;
+	(void)argv;
+	NETP_WARN("[coroutine]C++20 coroutines are not enabled");
+	return 0;
+}
+
+#endif
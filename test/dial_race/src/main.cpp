@@ -0,0 +1,253 @@
+// ipv6 addresses and the racing dialer (socket_cfg::dial_race)
+// 1, ipv6 notation is parsed from urls and text, and formatted back as [ip]:port
+// 2, race.test resolves to ::1 and 127.0.0.1, ::1 is blackholed, the v4 attempt started after dial_attempt_delay wins
+// 3, a throwing initializer fails the race with its code, it is not run again for another attempt
+//
+// a dns server for race.test is run on udp 127.0.0.1:53, the test needs the permission to bind it
+// the blackhole is a listener on [::1] that never accepts, once its backlog is full the SYN is dropped
+
+//example:
+//dial_race.exe
+
+#include <chrono>
+#include <atomic>
+
+#include <netp.hpp>
+
+#ifdef _NETP_GNU_LINUX
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+#define RACE_HOST "race.test"
+#define RACE_PORT 22318
+#define RACE_ATTEMPT_DELAY 100
+
+std::atomic<bool> g_dns_stop(false);
+std::atomic<int> g_initializer_called(0);
+
+#define DR_CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			NETP_ERR("[dial_race]check failed: %s, line: %d", #cond, __LINE__); \
+			return -2; \
+		} \
+	} while (0)
+
+int check_address() {
+	netp::address a6("::1", 80);
+	DR_CHECK(a6.family() == NETP_AF_INET6);
+	DR_CHECK(a6.dotip() == "::1");
+	DR_CHECK(a6.to_string() == "[::1]:80");
+
+	netp::address a6full("2001:0db8:0000:0000:0000:0000:0000:0001", 443);
+	DR_CHECK(a6full.family() == NETP_AF_INET6);
+	DR_CHECK(a6full.to_string() == "[2001:db8::1]:443");
+	DR_CHECK(a6full == netp::address(netp::strtoipv6("2001:db8::1"), 443));
+	DR_CHECK(a6full != netp::address(netp::strtoipv6("2001:db8::2"), 443));
+
+	netp::address a4("127.0.0.1", 80, NETP_AF_INET);
+	DR_CHECK(a4.family() == NETP_AF_INET);
+	DR_CHECK(a4.to_string() == "127.0.0.1:80");
+
+	DR_CHECK(netp::is_ipv6_notation("127.0.0.1") == false);
+	DR_CHECK(netp::ipv6tostr(netp::strtoipv6("::ffff:127.0.0.1")) == "::ffff:127.0.0.1");
+
+	netp::socket_url_parse_info info;
+	const char* url6 = "tcp://[2001:db8::1]:8080";
+	DR_CHECK(netp::parse_socket_url(url6, netp::strlen(url6), info) == netp::OK);
+	DR_CHECK(info.proto == "tcp" && info.host == "2001:db8::1" && info.port == 8080);
+
+	const char* url6_noport = "tcp://[2001:db8::1]";
+	DR_CHECK(netp::parse_socket_url(url6_noport, netp::strlen(url6_noport), info) == netp::E_SOCKET_INVALID_ADDRESS);
+	const char* url6_bad = "tcp://[2001:db8::zz]:8080";
+	DR_CHECK(netp::parse_socket_url(url6_bad, netp::strlen(url6_bad), info) == netp::E_SOCKET_INVALID_ADDRESS);
+	return netp::OK;
+}
+
+//answers A and AAAA of RACE_HOST, NXDOMAIN for the others
+void dns_serve(int fd) {
+	unsigned char q[512];
+	while (!g_dns_stop.load()) {
+		sockaddr_in from;
+		socklen_t fromlen = sizeof(from);
+		const ssize_t n = ::recvfrom(fd, q, sizeof(q), 0, (sockaddr*)&from, &fromlen);
+		if (n < 17) {
+			continue;
+		}
+		std::string qname;
+		ssize_t i = 12;
+		while (i < n && q[i] != 0) {
+			if (qname.length()) { qname += "."; }
+			qname.append((const char*)q + i + 1, q[i]);
+			i += q[i] + 1;
+		}
+		if (i + 5 > n) {
+			continue;
+		}
+		const int qtype = (q[i + 1] << 8) | q[i + 2];
+		const ssize_t qend = i + 5;
+
+		unsigned char r[512];
+		::memcpy(r, q, qend);
+		r[2] = 0x81; r[3] = 0x80; //response, recursion available
+		r[6] = 0; r[7] = 0; r[8] = 0; r[9] = 0; r[10] = 0; r[11] = 0;
+		ssize_t rlen = qend;
+		if (qname == RACE_HOST && (qtype == 1 || qtype == 28)) {
+			const unsigned char an[] = { 0xc0, 0x0c, 0, (unsigned char)qtype, 0, 1, 0, 0, 0, 60, 0, (unsigned char)(qtype == 1 ? 4 : 16) };
+			::memcpy(r + rlen, an, sizeof(an));
+			rlen += sizeof(an);
+			if (qtype == 1) {
+				::inet_pton(AF_INET, "127.0.0.1", r + rlen);
+				rlen += 4;
+			} else {
+				::inet_pton(AF_INET6, "::1", r + rlen);
+				rlen += 16;
+			}
+			r[7] = 1;
+		} else if (qname != RACE_HOST) {
+			r[3] |= 3;
+		}
+		::sendto(fd, r, rlen, 0, (sockaddr*)&from, fromlen);
+	}
+}
+
+int dns_open() {
+	const int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0) {
+		return -1;
+	}
+	timeval tv = { 0, 100 * 1000 };
+	::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	sockaddr_in sa;
+	::memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_port = htons(53);
+	::inet_pton(AF_INET, "127.0.0.1", &sa.sin_addr);
+	if (::bind(fd, (sockaddr*)&sa, sizeof(sa)) != 0) {
+		::close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+//a listener that never accepts, with its backlog filled up
+int blackhole_open(std::vector<int>& fds) {
+	const int lfd = ::socket(AF_INET6, SOCK_STREAM, 0);
+	if (lfd < 0) {
+		return -1;
+	}
+	int on = 1;
+	::setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+	sockaddr_in6 sa;
+	::memset(&sa, 0, sizeof(sa));
+	sa.sin6_family = AF_INET6;
+	sa.sin6_port = htons(RACE_PORT);
+	sa.sin6_addr = in6addr_loopback;
+	if (::bind(lfd, (sockaddr*)&sa, sizeof(sa)) != 0 || ::listen(lfd, 0) != 0) {
+		::close(lfd);
+		return -1;
+	}
+	fds.push_back(lfd);
+	for (int i = 0; i < 4; ++i) {
+		const int cfd = ::socket(AF_INET6, SOCK_STREAM, 0);
+		::fcntl(cfd, F_SETFL, ::fcntl(cfd, F_GETFL) | O_NONBLOCK);
+		::connect(cfd, (sockaddr*)&sa, sizeof(sa));
+		fds.push_back(cfd);
+	}
+	return netp::OK;
+}
+
+NRP<netp::channel_dial_promise> race_dial(netp::fn_channel_initializer_t const& initializer) {
+	NRP<netp::socket_cfg> cfg = netp::make_ref<netp::socket_cfg>();
+	cfg->dial_race = true;
+	cfg->dial_attempt_delay = RACE_ATTEMPT_DELAY;
+	return netp::socket::dial("tcp://" RACE_HOST ":" NETP_QUOTE(RACE_PORT), initializer, cfg);
+}
+
+long long cost_ms(std::chrono::steady_clock::time_point const& begin) {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+}
+
+int check_race() {
+	//2
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	NRP<netp::channel_dial_promise> dp = race_dial([](NRP<netp::channel> const& ch) {
+		(void)ch;
+		++g_initializer_called;
+	});
+	DR_CHECK(std::get<0>(dp->get()) == netp::OK);
+	NETP_INFO("[dial_race]connected: %s, cost: %lld ms", std::get<1>(dp->get())->ch_info().c_str(), cost_ms(begin));
+	DR_CHECK(g_initializer_called == 1);
+	DR_CHECK(cost_ms(begin) < 2000);
+	DR_CHECK(std::get<1>(dp->get())->ch_info().find("127.0.0.1:" NETP_QUOTE(RACE_PORT)) != netp::string_t::npos);
+	std::get<1>(dp->get())->ch_close();
+	std::get<1>(dp->get())->ch_close_promise()->wait();
+
+	//3
+	g_initializer_called = 0;
+	begin = std::chrono::steady_clock::now();
+	dp = race_dial([](NRP<netp::channel> const& ch) {
+		(void)ch;
+		++g_initializer_called;
+		NETP_THROW2(netp::E_OP_INPROCESS, "initializer failed");
+	});
+	DR_CHECK(std::get<0>(dp->get()) == netp::E_OP_INPROCESS);
+	DR_CHECK(g_initializer_called == 1);
+	DR_CHECK(cost_ms(begin) < 2000);
+	return netp::OK;
+}
+
+int main(int argc, char** argv) {
+	(void)argc;
+	(void)argv;
+
+	const int dnsfd = dns_open();
+	if (dnsfd < 0) {
+		NETP_ERR("[dial_race]bind udp 127.0.0.1:53 failed");
+		return -1;
+	}
+	netp::app_cfg appcfg;
+	appcfg.dnsnses.push_back("127.0.0.1");
+	netp::app app(appcfg);
+
+	int rt = check_address();
+	if (rt != netp::OK) {
+		NETP_ERR("[dial_race]address failed");
+		::close(dnsfd);
+		return rt;
+	}
+
+	NRP<netp::thread> dns_th = netp::make_ref<netp::thread>();
+	dns_th->start(&dns_serve, dnsfd);
+
+	std::vector<int> blackhole_fds;
+	NRP<netp::channel_listen_promise> listenp = netp::socket::listen_on("tcp://127.0.0.1:" NETP_QUOTE(RACE_PORT), [](NRP<netp::channel> const& ch) {
+		(void)ch;
+	});
+	if (blackhole_open(blackhole_fds) != netp::OK || std::get<0>(listenp->get()) != netp::OK) {
+		NETP_ERR("[dial_race]listen failed");
+		rt = -1;
+	} else {
+		rt = check_race();
+		std::get<1>(listenp->get())->ch_close();
+		std::get<1>(listenp->get())->ch_close_promise()->wait();
+	}
+
+	for (size_t i = 0; i < blackhole_fds.size(); ++i) {
+		::close(blackhole_fds[i]);
+	}
+	g_dns_stop = true;
+	dns_th->join();
+	::close(dnsfd);
+
+	if (rt != netp::OK) {
+		NETP_ERR("[dial_race]failed");
+		return rt;
+	}
+	NETP_INFO("[dial_race]done");
+	return 0;
+}
@@ -0,0 +1,188 @@
+// per channel bdlimit and a shared rate_limiter
+// 1, the client writes TOTAL_BYTES with both limiters enabled, the tighter one sets the pace
+// 2, the bdlimit timer and the rate limiter retry timer fire in turn, a flush must not race the pending retry
+// 3, SHARED_CHANNELS channels on different loops share one rate_limiter, their total rate stays under RATE_LIMIT
+// 4, and the shared limiter does not starve them, the total rate stays close to RATE_LIMIT
+
+//example:
+//rate_limit.exe
+
+#include <chrono>
+#include <atomic>
+#include <vector>
+#include <set>
+
+#include <netp.hpp>
+
+#define LISTEN_URL "tcp://127.0.0.1:22316"
+#define PACKET_SIZE (1024*16)
+#define TOTAL_BYTES (1024*512)
+#define BDLIMIT (1024*256)
+#define RATE_LIMIT (1024*192)
+#define SHARED_CHANNELS 2
+#define SHARED_BYTES_PER_CHANNEL (1024*256)
+#define SHARED_BURST (1024*16)
+//timer resolution and the loop wakeup latency, a paced run never finishes later than its expect time plus this
+#define PACE_SLACK_MS 800
+
+class sink final :
+	public netp::channel_handler_abstract
+{
+	std::atomic<long>& m_rcv_bytes;
+public:
+	sink(std::atomic<long>& rcv_bytes) :
+		channel_handler_abstract(netp::CH_INBOUND_READ),
+		m_rcv_bytes(rcv_bytes)
+	{}
+	void read(NRP<netp::channel_handler_context> const& ctx, NRP<netp::packet> const& income) override {
+		(void)ctx;
+		m_rcv_bytes += long(income->len());
+	}
+};
+
+class source final :
+	public netp::channel_handler_abstract
+{
+	NRP<netp::promise<int>> m_donep;
+	long m_left;
+
+	void _write_next(NRP<netp::channel_handler_context> const& ctx) {
+		if (m_left == 0) {
+			m_donep->set(netp::OK);
+			return;
+		}
+		NRP<netp::packet> outp = netp::make_ref<netp::packet>(PACKET_SIZE);
+		outp->incre_write_idx(PACKET_SIZE);
+		m_left -= PACKET_SIZE;
+		NRP<netp::promise<int>> wp = ctx->write(outp);
+		wp->if_done([s = NRP<source>(this), ctx](int const& rt) {
+			if (rt != netp::OK) {
+				s->m_donep->set(rt);
+				return;
+			}
+			s->_write_next(ctx);
+		});
+	}
+
+public:
+	source(NRP<netp::promise<int>> const& donep, long total) :
+		channel_handler_abstract(netp::CH_ACTIVITY_CONNECTED),
+		m_donep(donep),
+		m_left(total)
+	{}
+	void connected(NRP<netp::channel_handler_context> const& ctx) override {
+		_write_next(ctx);
+	}
+};
+
+struct paced_writer {
+	NRP<netp::promise<int>> donep;
+	NRP<netp::channel_dial_promise> dialp;
+};
+
+paced_writer dial_source(NRP<netp::socket_cfg> const& cfg, long total) {
+	NRP<netp::promise<int>> donep = netp::make_ref<netp::promise<int>>();
+	NRP<netp::channel_dial_promise> dialp = netp::socket::dial(LISTEN_URL, [donep, total](NRP<netp::channel> const& ch) {
+		ch->pipeline()->add_last(netp::make_ref<source>(donep, total));
+	}, cfg);
+	return { donep, dialp };
+}
+
+//the first burst goes out at once, the rest is paced by RATE_LIMIT
+int check_pace(const char* name, std::vector<paced_writer> const& writers, std::atomic<long> const& rcv_bytes, long total, long burst, std::chrono::steady_clock::time_point const& begin) {
+	for (size_t i = 0; i < writers.size(); ++i) {
+		if (std::get<0>(writers[i].dialp->get()) != netp::OK) {
+			NETP_ERR("[rate_limit][%s]dial failed: %d", name, std::get<0>(writers[i].dialp->get()));
+			return -1;
+		}
+	}
+	int wrt = netp::OK;
+	for (size_t i = 0; i < writers.size() && wrt == netp::OK; ++i) {
+		wrt = writers[i].donep->get();
+	}
+	while (wrt == netp::OK && rcv_bytes.load() < total) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	const long long cost_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+
+	const long long min_ms = ((total - burst) * 1000LL) / RATE_LIMIT;
+	const long long max_ms = (total * 1000LL) / RATE_LIMIT + PACE_SLACK_MS;
+	NETP_INFO("[rate_limit][%s]write: %d, rcv: %ld bytes, cost: %lld ms, expect: [%lld, %lld] ms, rate: %lld bytes/s",
+		name, wrt, rcv_bytes.load(), cost_ms, min_ms, max_ms, cost_ms == 0 ? 0 : (rcv_bytes.load() * 1000LL) / cost_ms);
+
+	for (size_t i = 0; i < writers.size(); ++i) {
+		std::get<1>(writers[i].dialp->get())->ch_close();
+		std::get<1>(writers[i].dialp->get())->ch_close_promise()->wait();
+	}
+	if (wrt != netp::OK || cost_ms < min_ms || cost_ms > max_ms) {
+		NETP_ERR("[rate_limit][%s]failed", name);
+		return -2;
+	}
+	return netp::OK;
+}
+
+int run_single(std::atomic<long>& rcv_bytes) {
+	//1,2
+	rcv_bytes = 0;
+	NRP<netp::socket_cfg> cfg = netp::make_ref<netp::socket_cfg>();
+	cfg->bdlimit = BDLIMIT;
+	cfg->rate_limiter = netp::make_ref<netp::traffic::rate_limiter>(RATE_LIMIT);
+
+	const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	std::vector<paced_writer> writers;
+	writers.push_back(dial_source(cfg, TOTAL_BYTES));
+	return check_pace("single", writers, rcv_bytes, TOTAL_BYTES, BDLIMIT, begin);
+}
+
+int run_shared(std::atomic<long>& rcv_bytes) {
+	//3,4
+	rcv_bytes = 0;
+	NRP<netp::traffic::rate_limiter> limiter = netp::make_ref<netp::traffic::rate_limiter>(RATE_LIMIT, SHARED_BURST);
+
+	const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	std::vector<paced_writer> writers;
+	std::set<NRP<netp::io_event_loop>> loops;
+	for (int i = 0; i < SHARED_CHANNELS; ++i) {
+		NRP<netp::socket_cfg> cfg = netp::make_ref<netp::socket_cfg>();
+		cfg->L = netp::io_event_loop_group::instance()->next(NETP_DEFAULT_POLLER_TYPE, loops);
+		loops.insert(cfg->L);
+		cfg->rate_limiter = limiter;
+		writers.push_back(dial_source(cfg, SHARED_BYTES_PER_CHANNEL));
+	}
+	if (loops.size() != SHARED_CHANNELS) {
+		NETP_ERR("[rate_limit][shared]the channels run on the same loop");
+		return -2;
+	}
+	return check_pace("shared", writers, rcv_bytes, SHARED_BYTES_PER_CHANNEL * SHARED_CHANNELS, SHARED_BURST, begin);
+}
+
+int main(int argc, char** argv) {
+	(void)argc;
+	(void)argv;
+	netp::app_cfg appcfg;
+	appcfg.cfg_poller_count(NETP_DEFAULT_POLLER_TYPE, SHARED_CHANNELS);
+	netp::app app(appcfg);
+
+	std::atomic<long> rcv_bytes(0);
+	NRP<netp::channel_listen_promise> listenp = netp::socket::listen_on(LISTEN_URL, [&rcv_bytes](NRP<netp::channel> const& ch) {
+		ch->pipeline()->add_last(netp::make_ref<sink>(rcv_bytes));
+	});
+	if (std::get<0>(listenp->get()) != netp::OK) {
+		NETP_ERR("[rate_limit]listen failed: %d", std::get<0>(listenp->get()));
+		return -1;
+	}
+
+	int rt = run_single(rcv_bytes);
+	if (rt == netp::OK) {
+		rt = run_shared(rcv_bytes);
+	}
+
+	std::get<1>(listenp->get())->ch_close();
+	std::get<1>(listenp->get())->ch_close_promise()->wait();
+	if (rt != netp::OK) {
+		NETP_ERR("[rate_limit]failed");
+		return rt;
+	}
+	NETP_INFO("[rate_limit]done");
+	return 0;
+}
@@ -14,6 +14,9 @@
 //example: 
 //thp.exe -h
 //thp.exe -l 128 -n 1000000
+//thp.exe -l 128 -n 1000000 -t unix //compare loopback tcp with unix domain socket
+//thp.exe -l 128 -n 1000000 -p 0 //compare with the per-loop packet pool disabled
+//thp.exe -l 1400 -n 1000000 -a 33554432 //compare with a 32M huge page arena for packet buffers of each loop
 
 #include <netp.hpp>
 
@@ -28,6 +31,9 @@ int main(int argc, char** argv) {
 
 	netp::app_cfg appcfg;
 	appcfg.poller_cfgs[netp::u8_t(NETP_DEFAULT_POLLER_TYPE)].ch_buf_size = g_param.loopbufsize;
+	appcfg.poller_cfgs[netp::u8_t(NETP_DEFAULT_POLLER_TYPE)].packet_pool_bytes = g_param.packet_pool_bytes;
+	appcfg.poller_cfgs[netp::u8_t(NETP_DEFAULT_POLLER_TYPE)].packet_arena_bytes = g_param.packet_arena_bytes;
+	appcfg.poller_cfgs[netp::u8_t(NETP_DEFAULT_POLLER_TYPE)].recycle_objects = g_param.recycle_objects;
 	
 	netp::app _app(appcfg);
 
@@ -51,7 +57,11 @@ int main(int argc, char** argv) {
 
 	double avgrate = netp::u64_t(g_param.packet_number) *1.0 / (sec.count());
 	double avgbits = netp::u64_t(g_param.packet_number) * netp::u64_t(g_param.packet_size) * 1.0 / (sec.count() * 1000 * 1000);
-	NETP_INFO("\n---\npacket size: %ld bytes\nnumber: %ld\ncost: %ld s\navgrate: %0.2f/s\navgbits: %0.2fMB/s\n---",
+	NETP_INFO("\n---\ntransport: %s\npacket pool: %ld bytes\npacket arena: %ld bytes\nrecycle objects: %ld\npacket size: %ld bytes\nnumber: %ld\ncost: %ld s\navgrate: %0.2f/s\navgbits: %0.2fMB/s\n---",
+		g_param.transport.c_str(),
+		g_param.packet_pool_bytes,
+		g_param.packet_arena_bytes,
+		g_param.recycle_objects,
 		g_param.packet_size,
 		g_param.packet_number,
 		sec.count(),
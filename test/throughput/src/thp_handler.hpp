@@ -14,7 +14,7 @@ public:
 		channel_handler_abstract(netp::channel_handler_api::CH_INBOUND_READ)
 	{}
 	void read(NRP<netp::channel_handler_context> const& ctx, NRP<netp::packet> const& income) {
-		ctx->write(income);
+		ctx->write_forget(income);
 	}
 };
 
@@ -31,6 +31,20 @@ public:
 	void read(NRP<netp::channel_handler_context> const& ctx, NRP<netp::packet> const& income) {
 		m_total_received += income->len();
 		if (m_total_received >= m_total_to_receive) {
+			netp::packet_pool* pool = netp::tls_get<netp::packet_pool>();
+			if (pool != nullptr) {
+				netp::packet_pool_stats const& st = pool->stats();
+				NETP_INFO("packet pool: object hit: %llu, miss: %llu, buf hit: %llu, miss: %llu, drop: %llu, retained: %u objects, %u bufs, %llu bytes, arena: %llu bytes, carved: %llu bytes, huge page: %u",
+					st.object_hit, st.object_miss, st.buf_hit, st.buf_miss, st.buf_drop, st.objects, st.bufs, st.bytes, st.arena_bytes, st.arena_carved, st.arena_huge_page);
+			}
+			netp::recycler* rc = netp::tls_get<netp::recycler>();
+			if (rc != nullptr) {
+				for (netp::u32_t id = 0; id < netp::recycler::type_count(); ++id) {
+					netp::recycler_stats const& st = rc->stats(id);
+					NETP_INFO("recycler: %s, hit: %llu, miss: %llu, recycled: %llu, drop: %llu, retained: %u",
+						netp::recycler::type_name(id), st.hit, st.miss, st.recycled, st.drop, st.objects);
+				}
+			}
 			ctx->close();
 			long channels = netp::atomic_decre(&g_channels, std::memory_order_acq_rel);
 			if (channels == 1) {
@@ -38,7 +52,7 @@ public:
 				::raise(SIGTERM);
 			}
 		}
-		ctx->write(income);
+		ctx->write_forget(income);
 	}
 
 	netp::u64_t m_total_received;
@@ -50,7 +64,7 @@ void handler_start_listener(thp_param const& param_) {
 	NRP<netp::socket_cfg> cfg = netp::make_ref<netp::socket_cfg>();
 	cfg->sock_buf = { netp::u32_t(param_.rcvwnd), netp::u32_t(param_.sndwnd) };
 
-	NRP<netp::channel_listen_promise> lp = netp::socket::listen_on("tcp://0.0.0.0:32002", [](NRP<netp::channel> const& ch) {
+	NRP<netp::channel_listen_promise> lp = netp::socket::listen_on(param_.listen_url(), [](NRP<netp::channel> const& ch) {
 		ch->pipeline()->add_last(netp::make_ref<netp::handler::hlen>());
 		ch->pipeline()->add_last(netp::make_ref<server_echo_handler>());
 		}, cfg);
@@ -74,7 +88,7 @@ void handler_dial_one_client(thp_param const& param_) {
 	NRP<netp::socket_cfg> cfg = netp::make_ref<netp::socket_cfg>();
 	cfg->sock_buf = { netp::u32_t(param_.rcvwnd), netp::u32_t(param_.sndwnd) };
 
-	NRP<netp::channel_dial_promise> dp = netp::socket::dial("tcp://127.0.0.1:32002", [&param_](NRP<netp::channel> const& ch) {
+	NRP<netp::channel_dial_promise> dp = netp::socket::dial(param_.dial_url(), [&param_](NRP<netp::channel> const& ch) {
 		ch->pipeline()->add_last(netp::make_ref<netp::handler::hlen>());
 		ch->pipeline()->add_last(netp::make_ref<client_echo_handler>( netp::u64_t (param_.packet_size) * netp::u64_t(param_.packet_number)) );
 	}, cfg);
@@ -87,10 +101,10 @@ void handler_dial_one_client(thp_param const& param_) {
 
 		netp::atomic_incre(&g_channels, std::memory_order_acq_rel);
 
-		NRP<netp::packet> outp = netp::make_ref<netp::packet>(param_.packet_size);
+		NRP<netp::channel> const& ch = std::get<1>(tupc);
+		NRP<netp::packet> outp = ch->ch_make_packet(param_.packet_size);
 		outp->incre_write_idx(param_.packet_size);
 
-		NRP<netp::channel> const& ch = std::get<1>(tupc);
 		NRP<netp::promise<int>> wp = ch->ch_write(outp);
 		wp->if_done([](int const& rt) {
 			NETP_ASSERT(rt == netp::OK);
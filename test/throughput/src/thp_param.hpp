@@ -12,6 +12,10 @@ public:
 	long rcvwnd;
 	long sndwnd;
 	long loopbufsize;
+	long packet_pool_bytes;
+	long packet_arena_bytes;
+	long recycle_objects;
+	std::string transport; //tcp or unix
 
 	thp_param() :
 		client_max(1),
@@ -19,8 +23,20 @@ public:
 		packet_size(64),
 		rcvwnd(128 * 1024),
 		sndwnd(64 * 1024),
-		loopbufsize(128 * 1024)
+		loopbufsize(128 * 1024),
+		packet_pool_bytes(NETP_PACKET_POOL_DEFAULT_BYTES),
+		packet_arena_bytes(0),
+		recycle_objects(NETP_RECYCLER_DEFAULT_OBJECTS),
+		transport("tcp")
 	{}
+
+	std::string listen_url() const {
+		return transport == "unix" ? "unix://@netp_thp_32002" : "tcp://0.0.0.0:32002";
+	}
+
+	std::string dial_url() const {
+		return transport == "unix" ? "unix://@netp_thp_32002" : "tcp://127.0.0.1:32002";
+	}
 };
 
  void parse_param(thp_param& p, int argc, char** argv) {
@@ -31,11 +47,15 @@ public:
 		{"sndwnd", optional_argument,0, 's'},
 		{"clients", optional_argument, 0, 'c'},
 		{"buf-for-evtloop", optional_argument, 0, 'b'},
+		{"transport", optional_argument, 0, 't'}, //tcp (loopback) or unix (abstract unix domain socket)
+		{"packet-pool", optional_argument, 0, 'p'}, //bytes retained by the packet pool of each loop, 0 to disable
+		{"packet-arena", optional_argument, 0, 'a'}, //huge page arena bytes of the packet pool of each loop, 0 to disable
+		{"recycle", optional_argument, 0, 'o'}, //objects cached per recycled type by each loop, 0 to disable
 		{"help", optional_argument, 0, 'h'},
 		{0,0,0,0}
 	};
 
-	const char* optstring = "l:n:c:r:s:b:h::";
+	const char* optstring = "l:n:c:r:s:b:t:p:a:o:h::";
 
 	int opt;
 	int opt_idx;
@@ -71,9 +91,33 @@ public:
 			p.loopbufsize = std::atol(optarg);
 		}
 		break;
+		case 'p':
+		{
+			p.packet_pool_bytes = std::atol(optarg);
+		}
+		break;
+		case 'a':
+		{
+			p.packet_arena_bytes = std::atol(optarg);
+		}
+		break;
+		case 'o':
+		{
+			p.recycle_objects = std::atol(optarg);
+		}
+		break;
+		case 't':
+		{
+			p.transport = std::string(optarg);
+			if (p.transport != "tcp" && p.transport != "unix") {
+				printf("unknown transport: %s, tcp or unix\n", optarg);
+				exit(-1);
+			}
+		}
+		break;
 		case 'h':
 		{
-			printf("usage:  -c max_clients -l bytes_len -n packet_number\nexample: thp.exe -c 1 -l 64 -n 1000000\n");
+			printf("usage:  -c max_clients -l bytes_len -n packet_number -t tcp|unix -p packet_pool_bytes -a packet_arena_bytes -o recycle_objects\nexample: thp.exe -c 1 -l 64 -n 1000000 -t unix\n");
 			exit(-1);
 			break;
 		}
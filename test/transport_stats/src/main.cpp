@@ -0,0 +1,170 @@
+// transport_stats
+// 1, without sampling, ch_get_transport_stats queries TCP_INFO on demand, every call is a fresh sample
+// 2, with transport_stats_interval, the calls get the sample of the last tick, the timer refreshes it every interval
+// 3, the refreshed sample follows the traffic, bytes_acked covers the bytes written
+// 4, ch_set_transport_stats_sampling(0) stops the timer, the calls go back to on demand samples
+// 5, a udp channel has no transport stats, E_INVALID_OPERATION
+
+//example:
+//transport_stats.exe
+
+#include <chrono>
+#include <atomic>
+
+#include <netp.hpp>
+
+#define LISTEN_URL "tcp://127.0.0.1:22323"
+#define UDP_DIAL_URL "udp://127.0.0.1:22324"
+#define SAMPLE_INTERVAL 200
+#define WRITE_BYTES (1024*256)
+#define PACKET_SIZE (1024*16)
+
+#define TS_CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			NETP_ERR("[transport_stats]check failed: %s, line: %d", #cond, __LINE__); \
+			return -2; \
+		} \
+	} while (0)
+
+class sink final :
+	public netp::channel_handler_abstract
+{
+	std::atomic<long>& m_rcv_bytes;
+public:
+	sink(std::atomic<long>& rcv_bytes) :
+		channel_handler_abstract(netp::CH_INBOUND_READ),
+		m_rcv_bytes(rcv_bytes)
+	{}
+	void read(NRP<netp::channel_handler_context> const& ctx, NRP<netp::packet> const& income) override {
+		(void)ctx;
+		m_rcv_bytes += long(income->len());
+	}
+};
+
+std::tuple<int, netp::channel_transport_stats> get_stats(NRP<netp::channel> const& ch) {
+	return ch->ch_get_transport_stats()->get();
+}
+
+int write_and_wait(NRP<netp::channel> const& ch, std::atomic<long> const& rcv_bytes) {
+	const long begin = rcv_bytes.load();
+	for (int i = 0; i < WRITE_BYTES / PACKET_SIZE; ++i) {
+		NRP<netp::packet> outp = netp::make_ref<netp::packet>(PACKET_SIZE);
+		outp->incre_write_idx(PACKET_SIZE);
+		TS_CHECK(ch->ch_write(outp)->get() == netp::OK);
+	}
+	while (rcv_bytes.load() - begin < WRITE_BYTES) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	return netp::OK;
+}
+
+int run_on_demand(std::atomic<long>& rcv_bytes) {
+	//1
+	NRP<netp::channel_dial_promise> dp = netp::socket::dial(LISTEN_URL, nullptr);
+	TS_CHECK(std::get<0>(dp->get()) == netp::OK);
+	NRP<netp::channel> ch = std::get<1>(dp->get());
+
+	std::tuple<int, netp::channel_transport_stats> a = get_stats(ch);
+#ifdef _NETP_GNU_LINUX
+	TS_CHECK(std::get<0>(a) == netp::OK);
+	TS_CHECK(std::get<1>(a).snd_mss > 0 && std::get<1>(a).rto > 0 && std::get<1>(a).snd_cwnd > 0);
+	TS_CHECK(write_and_wait(ch, rcv_bytes) == netp::OK);
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	std::tuple<int, netp::channel_transport_stats> b = get_stats(ch);
+	TS_CHECK(std::get<0>(b) == netp::OK);
+	TS_CHECK(std::get<1>(b).sampled_at > std::get<1>(a).sampled_at);
+	TS_CHECK(std::get<1>(b).bytes_acked >= std::get<1>(a).bytes_acked + WRITE_BYTES);
+#else
+	TS_CHECK(std::get<0>(a) == netp::E_INVALID_OPERATION);
+#endif
+
+	ch->ch_close();
+	ch->ch_close_promise()->wait();
+	return netp::OK;
+}
+
+int run_sampling(std::atomic<long>& rcv_bytes) {
+	NRP<netp::socket_cfg> cfg = netp::make_ref<netp::socket_cfg>();
+	cfg->transport_stats_interval = SAMPLE_INTERVAL;
+	NRP<netp::channel_dial_promise> dp = netp::socket::dial(LISTEN_URL, nullptr, cfg);
+	TS_CHECK(std::get<0>(dp->get()) == netp::OK);
+	NRP<netp::channel> ch = std::get<1>(dp->get());
+
+	//2
+	std::tuple<int, netp::channel_transport_stats> a = get_stats(ch);
+	TS_CHECK(std::get<0>(a) == netp::OK);
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	std::tuple<int, netp::channel_transport_stats> b = get_stats(ch);
+	TS_CHECK(std::get<0>(b) == netp::OK);
+	TS_CHECK(std::get<1>(b).sampled_at == std::get<1>(a).sampled_at);
+
+	//3
+	TS_CHECK(write_and_wait(ch, rcv_bytes) == netp::OK);
+	std::this_thread::sleep_for(std::chrono::milliseconds(SAMPLE_INTERVAL * 2));
+	std::tuple<int, netp::channel_transport_stats> c = get_stats(ch);
+	TS_CHECK(std::get<0>(c) == netp::OK);
+	NETP_INFO("[transport_stats]sampled_at: %lld -> %lld, bytes_acked: %llu -> %llu, rtt: %uus",
+		std::get<1>(a).sampled_at, std::get<1>(c).sampled_at,
+		(unsigned long long)std::get<1>(a).bytes_acked, (unsigned long long)std::get<1>(c).bytes_acked,
+		std::get<1>(c).rtt);
+	TS_CHECK(std::get<1>(c).sampled_at - std::get<1>(a).sampled_at >= SAMPLE_INTERVAL);
+	TS_CHECK(std::get<1>(c).bytes_acked >= std::get<1>(a).bytes_acked + WRITE_BYTES);
+
+	//4
+	ch->ch_set_transport_stats_sampling(0);
+	std::tuple<int, netp::channel_transport_stats> d = get_stats(ch);
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	std::tuple<int, netp::channel_transport_stats> e = get_stats(ch);
+	TS_CHECK(std::get<0>(d) == netp::OK && std::get<0>(e) == netp::OK);
+	TS_CHECK(std::get<1>(e).sampled_at > std::get<1>(d).sampled_at);
+
+	ch->ch_close();
+	ch->ch_close_promise()->wait();
+	return netp::OK;
+}
+
+int run_udp() {
+	//5
+	NRP<netp::channel_dial_promise> dp = netp::socket::dial(UDP_DIAL_URL, nullptr);
+	TS_CHECK(std::get<0>(dp->get()) == netp::OK);
+	NRP<netp::channel> ch = std::get<1>(dp->get());
+	TS_CHECK(std::get<0>(get_stats(ch)) == netp::E_INVALID_OPERATION);
+	ch->ch_close();
+	ch->ch_close_promise()->wait();
+	return netp::OK;
+}
+
+int main(int argc, char** argv) {
+	(void)argc;
+	(void)argv;
+	netp::app app;
+
+	std::atomic<long> rcv_bytes(0);
+	NRP<netp::channel_listen_promise> listenp = netp::socket::listen_on(LISTEN_URL, [&rcv_bytes](NRP<netp::channel> const& ch) {
+		ch->pipeline()->add_last(netp::make_ref<sink>(rcv_bytes));
+	});
+	if (std::get<0>(listenp->get()) != netp::OK) {
+		NETP_ERR("[transport_stats]listen failed: %d", std::get<0>(listenp->get()));
+		return -1;
+	}
+
+	int rt = run_on_demand(rcv_bytes);
+#ifdef _NETP_GNU_LINUX
+	if (rt == netp::OK) {
+		rt = run_sampling(rcv_bytes);
+	}
+#endif
+	if (rt == netp::OK) {
+		rt = run_udp();
+	}
+
+	std::get<1>(listenp->get())->ch_close();
+	std::get<1>(listenp->get())->ch_close_promise()->wait();
+	if (rt != netp::OK) {
+		NETP_ERR("[transport_stats]failed");
+		return rt;
+	}
+	NETP_INFO("[transport_stats]done");
+	return 0;
+}
@@ -0,0 +1,164 @@
+// write_coalesce
+// 1, without write_coalesce, WRITE_COUNT writes of one loop iteration go out by WRITE_COUNT sends
+// 2, with write_coalesce, the same writes are flushed once at the end of the iteration, one sendv of WRITE_COUNT entries
+// 3, the peer gets the bytes of every write, in order
+// 4, a close issued in the same iteration waits for the flush, the bytes are delivered before the close
+
+//example:
+//write_coalesce.exe
+
+#include <chrono>
+#include <atomic>
+#include <vector>
+
+#include <netp.hpp>
+
+#define LISTEN_URL "tcp://127.0.0.1:22322"
+#define WRITE_COUNT 5
+#define WRITE_SIZE 100
+
+std::atomic<int> g_send_calls(0);
+std::atomic<int> g_sendv_calls(0);
+std::atomic<int> g_sendv_iovcnt(0);
+
+#define WC_CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			NETP_ERR("[write_coalesce]check failed: %s, line: %d", #cond, __LINE__); \
+			return -2; \
+		} \
+	} while (0)
+
+int counted_send(netp::SOCKET fd, char const* const buf, netp::u32_t len, int flags) {
+	++g_send_calls;
+	return netp::NETP_DEFAULT_SOCKAPI.send(fd, buf, len, flags);
+}
+
+int counted_sendv(netp::SOCKET fd, netp::iov_t const* iov, netp::u32_t iovcnt, int flags) {
+	++g_sendv_calls;
+	g_sendv_iovcnt = int(iovcnt);
+	return netp::NETP_DEFAULT_SOCKAPI.sendv(fd, iov, iovcnt, flags);
+}
+
+class collector final :
+	public netp::channel_handler_abstract
+{
+public:
+	NRP<netp::packet> m_bytes;
+	NRP<netp::promise<int>> m_closed;
+
+	collector() :
+		channel_handler_abstract(netp::CH_INBOUND_READ | netp::CH_ACTIVITY_READ_CLOSED),
+		m_bytes(netp::make_ref<netp::packet>()),
+		m_closed(netp::make_ref<netp::promise<int>>())
+	{}
+
+	void read(NRP<netp::channel_handler_context> const& ctx, NRP<netp::packet> const& income) override {
+		(void)ctx;
+		m_bytes->write(income->head(), income->len());
+	}
+
+	void read_closed(NRP<netp::channel_handler_context> const& ctx) override {
+		ctx->close();
+		m_closed->set(netp::OK);
+	}
+};
+
+//the i-th write is WRITE_SIZE bytes of 'a'+i
+NRP<netp::packet> make_write(int i) {
+	NRP<netp::packet> p = netp::make_ref<netp::packet>(WRITE_SIZE);
+	for (int j = 0; j < WRITE_SIZE; ++j) {
+		p->write<netp::u8_t>(netp::u8_t('a' + i));
+	}
+	return p;
+}
+
+int run(bool coalesce, bool close_after_write) {
+	NRP<collector> c = netp::make_ref<collector>();
+	NRP<netp::channel_listen_promise> listenp = netp::socket::listen_on(LISTEN_URL, [c](NRP<netp::channel> const& ch) {
+		ch->pipeline()->add_last(c);
+	});
+	WC_CHECK(std::get<0>(listenp->get()) == netp::OK);
+
+	static netp::socket_api counted_api = netp::NETP_DEFAULT_SOCKAPI;
+	counted_api.send = counted_send;
+	counted_api.sendv = counted_sendv;
+	NRP<netp::socket_cfg> cfg = netp::make_ref<netp::socket_cfg>();
+	cfg->sockapi = &counted_api;
+	cfg->write_coalesce = coalesce;
+	NRP<netp::channel_dial_promise> dp = netp::socket::dial(LISTEN_URL, nullptr, cfg);
+	WC_CHECK(std::get<0>(dp->get()) == netp::OK);
+	NRP<netp::channel> ch = std::get<1>(dp->get());
+
+	//all the writes in one task, i.e. in one loop iteration
+	NRP<netp::promise<std::vector<NRP<netp::promise<int>>>>> writesp = netp::make_ref<netp::promise<std::vector<NRP<netp::promise<int>>>>>();
+	ch->L->execute([ch, writesp, close_after_write]() {
+		g_send_calls = 0;
+		g_sendv_calls = 0;
+		g_sendv_iovcnt = 0;
+		std::vector<NRP<netp::promise<int>>> wps;
+		for (int i = 0; i < WRITE_COUNT; ++i) {
+			wps.push_back(ch->ch_write(make_write(i)));
+		}
+		if (close_after_write) {
+			ch->ch_close();
+		}
+		writesp->set(wps);
+	});
+	std::vector<NRP<netp::promise<int>>> wps = writesp->get();
+	for (size_t i = 0; i < wps.size(); ++i) {
+		WC_CHECK(wps[i]->get() == netp::OK);
+	}
+
+	NETP_INFO("[write_coalesce][coalesce: %d]send calls: %d, sendv calls: %d, iovcnt: %d", coalesce, g_send_calls.load(), g_sendv_calls.load(), g_sendv_iovcnt.load());
+	if (coalesce) {
+		//2
+		WC_CHECK(g_send_calls == 0 && g_sendv_calls == 1 && g_sendv_iovcnt == WRITE_COUNT);
+	} else {
+		//1
+		WC_CHECK(g_send_calls == WRITE_COUNT && g_sendv_calls == 0);
+	}
+
+	if (close_after_write) {
+		//4
+		WC_CHECK(c->m_closed->get() == netp::OK);
+		WC_CHECK(ch->ch_close_promise()->get() == netp::OK);
+	} else {
+		ch->ch_close();
+		ch->ch_close_promise()->wait();
+		WC_CHECK(c->m_closed->get() == netp::OK);
+	}
+
+	//3, the read_closed event comes after the last read
+	WC_CHECK(c->m_bytes->len() == WRITE_SIZE * WRITE_COUNT);
+	for (int i = 0; i < WRITE_COUNT; ++i) {
+		for (int j = 0; j < WRITE_SIZE; ++j) {
+			WC_CHECK(c->m_bytes->head()[i * WRITE_SIZE + j] == netp::byte_t('a' + i));
+		}
+	}
+
+	std::get<1>(listenp->get())->ch_close();
+	std::get<1>(listenp->get())->ch_close_promise()->wait();
+	return netp::OK;
+}
+
+int main(int argc, char** argv) {
+	(void)argc;
+	(void)argv;
+	netp::app app;
+
+	int rt = run(false, false);
+	if (rt == netp::OK) {
+		rt = run(true, false);
+	}
+	if (rt == netp::OK) {
+		rt = run(true, true);
+	}
+
+	if (rt != netp::OK) {
+		NETP_ERR("[write_coalesce]failed");
+		return rt;
+	}
+	NETP_INFO("[write_coalesce]done");
+	return 0;
+}
@@ -0,0 +1,147 @@
+// write watermark hysteresis
+// 1, the peer stops reading, the client writes until the outbound queue crosses the high watermark
+// 2, the channel is unwritable at once, the writability_changed(false) event is scheduled, not fired inside the write path that crossed the watermark
+// 3, the peer resumes reading, writability_changed(true) fires once the queue drains to the low watermark, no event in between
+// 4, a write issued from the writability_changed(true) handler goes out
+
+//example:
+//write_watermark.exe
+
+#include <chrono>
+#include <atomic>
+#include <vector>
+
+#include <netp.hpp>
+
+#define LISTEN_URL "tcp://127.0.0.1:22321"
+#define PACKET_SIZE (1024*8)
+#define SNDBUF_SIZE (1024*64)
+#define WWM_HIGH (1024*64)
+#define WWM_LOW (1024*16)
+#define MAX_BYTES (1024*1024*64)
+#define TAIL_SIZE 1000
+
+#define WWM_CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			NETP_ERR("[write_watermark]check failed: %s, line: %d", #cond, __LINE__); \
+			return -2; \
+		} \
+	} while (0)
+
+class sink final :
+	public netp::channel_handler_abstract
+{
+	std::atomic<long>& m_rcv_bytes;
+public:
+	sink(std::atomic<long>& rcv_bytes) :
+		channel_handler_abstract(netp::CH_INBOUND_READ),
+		m_rcv_bytes(rcv_bytes)
+	{}
+	void read(NRP<netp::channel_handler_context> const& ctx, NRP<netp::packet> const& income) override {
+		(void)ctx;
+		m_rcv_bytes += long(income->len());
+	}
+};
+
+//loop thread only, read by main after the promises
+class watcher final :
+	public netp::channel_handler_abstract
+{
+public:
+	std::vector<bool> m_events;
+	bool m_writable_on_event;
+	NRP<netp::promise<int>> m_unwritable;
+	NRP<netp::promise<int>> m_writable;
+	NRP<netp::promise<int>> m_tail_write;
+
+	watcher() :
+		channel_handler_abstract(netp::CH_ACTIVITY_WRITABILITY_CHANGED),
+		m_writable_on_event(false),
+		m_unwritable(netp::make_ref<netp::promise<int>>()),
+		m_writable(netp::make_ref<netp::promise<int>>()),
+		m_tail_write(nullptr)
+	{}
+
+	void writability_changed(NRP<netp::channel_handler_context> const& ctx, bool writable) override {
+		m_events.push_back(writable);
+		m_writable_on_event = ctx->ch->ch_is_writable();
+		if (!writable) {
+			m_unwritable->set(netp::OK);
+			return;
+		}
+		//4
+		NRP<netp::packet> tail = netp::make_ref<netp::packet>(TAIL_SIZE);
+		tail->incre_write_idx(TAIL_SIZE);
+		m_tail_write = ctx->write(tail);
+		m_writable->set(netp::OK);
+	}
+};
+
+int main(int argc, char** argv) {
+	(void)argc;
+	(void)argv;
+	netp::app app;
+
+	std::atomic<long> rcv_bytes(0);
+	NRP<netp::promise<NRP<netp::channel>>> acceptedp = netp::make_ref<netp::promise<NRP<netp::channel>>>();
+	NRP<netp::channel_listen_promise> listenp = netp::socket::listen_on(LISTEN_URL, [&rcv_bytes, acceptedp](NRP<netp::channel> const& ch) {
+		ch->pipeline()->add_last(netp::make_ref<sink>(rcv_bytes));
+		acceptedp->set(ch);
+	});
+	WWM_CHECK(std::get<0>(listenp->get()) == netp::OK);
+
+	NRP<watcher> w = netp::make_ref<watcher>();
+	NRP<netp::socket_cfg> cfg = netp::make_ref<netp::socket_cfg>();
+	cfg->sock_buf.sndbuf_size = SNDBUF_SIZE;
+	cfg->wwm = { WWM_HIGH, WWM_LOW };
+	NRP<netp::channel_dial_promise> dialp = netp::socket::dial(LISTEN_URL, [w](NRP<netp::channel> const& ch) {
+		ch->pipeline()->add_last(w);
+	}, cfg);
+	WWM_CHECK(std::get<0>(dialp->get()) == netp::OK);
+	NRP<netp::channel> ch = std::get<1>(dialp->get());
+	NRP<netp::channel> peer = acceptedp->get();
+
+	//1, the peer's kernel buffers fill up, then the client's, then the outbound queue
+	peer->ch_aio_end_read();
+	NRP<netp::promise<long>> writtenp = netp::make_ref<netp::promise<long>>();
+	ch->L->execute([ch, w, writtenp]() {
+		long written = 0;
+		while (ch->ch_is_writable() && written < MAX_BYTES) {
+			NRP<netp::packet> outp = netp::make_ref<netp::packet>(PACKET_SIZE);
+			outp->incre_write_idx(PACKET_SIZE);
+			ch->ch_write(outp);
+			written += PACKET_SIZE;
+		}
+		//2
+		writtenp->set(w->m_events.size() == 0 ? written : -1);
+	});
+	const long written = writtenp->get();
+	NETP_INFO("[write_watermark]written before the high watermark: %ld", written);
+	WWM_CHECK(written > 0 && written < MAX_BYTES);
+	WWM_CHECK(w->m_unwritable->get() == netp::OK);
+
+	//3
+	peer->ch_aio_read();
+	WWM_CHECK(w->m_writable->get() == netp::OK);
+	WWM_CHECK(w->m_events.size() == 2 && w->m_events[0] == false && w->m_events[1] == true);
+	WWM_CHECK(w->m_writable_on_event);
+
+	//4
+	WWM_CHECK(w->m_tail_write->get() == netp::OK);
+	const long total = written + TAIL_SIZE;
+	const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	while (rcv_bytes.load() < total && std::chrono::steady_clock::now() - begin < std::chrono::seconds(10)) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	NETP_INFO("[write_watermark]rcv: %ld bytes, expect: %ld bytes", rcv_bytes.load(), total);
+	WWM_CHECK(rcv_bytes.load() == total);
+	WWM_CHECK(w->m_events.size() == 2);
+
+	ch->ch_close();
+	ch->ch_close_promise()->wait();
+	std::get<1>(listenp->get())->ch_close();
+	std::get<1>(listenp->get())->ch_close_promise()->wait();
+	NETP_INFO("[write_watermark]done");
+	return 0;
+}